@@ -0,0 +1,76 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * linux/arch/arm/lib/csumpartial-neon-glue.c
+ *
+ * csum_partial() for kernels with kernel mode NEON. Large buffers are summed
+ * by the NEON unit when the CPU has one and the caller is allowed to use it,
+ * everything else (including the tail which is not a multiple of 64 bytes)
+ * by the integer implementation in csumpartial.S.
+ */
+
+#include <linux/init.h>
+#include <linux/jump_label.h>
+#include <linux/kernel.h>
+#include <linux/sizes.h>
+#include <asm/checksum.h>
+#include <asm/neon.h>
+#include <asm/simd.h>
+
+/*
+ * Below this, preserving the userspace VFP context costs more than what the
+ * NEON loop saves over the ldm/adcs one.
+ */
+#define CSUM_NEON_MIN_LEN	1024
+/* Bounds the time spent with preemption disabled */
+#define CSUM_NEON_CHUNK		SZ_4K
+
+__wsum __csum_partial_arm(const void *buff, int len, __wsum sum);
+u64 __csum_partial_neon(const void *buff, unsigned int len);
+
+static DEFINE_STATIC_KEY_FALSE(csum_use_neon);
+
+static u32 csum_fold64(u64 sum)
+{
+	sum = (sum & 0xffffffff) + (sum >> 32);
+	sum = (sum & 0xffffffff) + (sum >> 32);
+
+	return sum;
+}
+
+__wsum csum_partial(const void *buff, int len, __wsum sum)
+{
+	/*
+	 * kernel_neon_begin() can't be called from interrupt context, which
+	 * is what may_use_simd() checks for. Softirq callers (most of the
+	 * receive path) therefore always take the integer path.
+	 */
+	if (static_branch_likely(&csum_use_neon) &&
+	    len >= CSUM_NEON_MIN_LEN && may_use_simd()) {
+		unsigned int bulk = len & ~63;
+		u64 acc = (__force u32)sum;
+		unsigned int chunk;
+
+		len -= bulk;
+
+		for (; bulk; bulk -= chunk, buff += chunk) {
+			chunk = min_t(unsigned int, bulk, CSUM_NEON_CHUNK);
+
+			kernel_neon_begin();
+			acc += __csum_partial_neon(buff, chunk);
+			kernel_neon_end();
+		}
+
+		sum = (__force __wsum)csum_fold64(acc);
+	}
+
+	return __csum_partial_arm(buff, len, sum);
+}
+
+static int __init csum_neon_init(void)
+{
+	if (cpu_has_neon())
+		static_branch_enable(&csum_use_neon);
+
+	return 0;
+}
+arch_initcall(csum_neon_init);
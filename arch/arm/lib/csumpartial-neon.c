@@ -0,0 +1,43 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * linux/arch/arm/lib/csumpartial-neon.c
+ *
+ * NEON inner loop of csum_partial(), see csumpartial-neon-glue.c
+ */
+
+#include <linux/types.h>
+#include <arm_neon.h>
+
+#ifndef __ARM_NEON__
+#error You should compile this file with '-march=armv7-a -mfloat-abi=softfp -mfpu=neon'
+#endif
+
+/*
+ * Returns the sum of the 16-bit words in the @len bytes at @buff, @len being
+ * a multiple of 64. Words are paired from the start of the buffer whatever
+ * its alignment, and the partial sums are widened into 64-bit lanes, so
+ * there is no carry to take care of until the caller folds the result.
+ */
+u64 __csum_partial_neon(const void *buff, unsigned int len)
+{
+	uint64x2_t acc0 = vdupq_n_u64(0);
+	uint64x2_t acc1 = vdupq_n_u64(0);
+	const u8 *p = buff;
+
+	for (; len; len -= 64, p += 64) {
+		uint16x8_t a = vreinterpretq_u16_u8(vld1q_u8(p));
+		uint16x8_t b = vreinterpretq_u16_u8(vld1q_u8(p + 16));
+		uint16x8_t c = vreinterpretq_u16_u8(vld1q_u8(p + 32));
+		uint16x8_t d = vreinterpretq_u16_u8(vld1q_u8(p + 48));
+		uint32x4_t s0, s1;
+
+		s0 = vpadalq_u16(vpaddlq_u16(a), b);
+		s1 = vpadalq_u16(vpaddlq_u16(c), d);
+		acc0 = vpadalq_u32(acc0, s0);
+		acc1 = vpadalq_u32(acc1, s1);
+	}
+
+	acc0 = vaddq_u64(acc0, acc1);
+
+	return vgetq_lane_u64(acc0, 0) + vgetq_lane_u64(acc0, 1);
+}
@@ -90,6 +90,18 @@ struct sja1105_info {
 	const char *name;
 };
 
+struct sja1105_devlink_data {
+	struct devlink_region *static_config_region;
+	struct devlink_region *l2_lookup_region;
+	size_t static_config_len;
+	bool snapshot_enabled;
+};
+
+struct sja1105_flow_block {
+	struct list_head rules;
+	int num_virtual_links;
+};
+
 struct sja1105_private {
 	struct sja1105_static_config static_config;
 	bool rgmii_rx_delay[SJA1105_NUM_PORTS];
@@ -103,9 +115,12 @@ struct sja1105_private {
 	 * the switch doesn't confuse them with one another.
 	 */
 	struct mutex mgmt_lock;
+	bool sticky_routes_en;
 	struct sja1105_tagger_data tagger_data;
 	struct sja1105_ptp_data ptp_data;
 	struct sja1105_tas_data tas_data;
+	struct sja1105_devlink_data devlink_data;
+	struct sja1105_flow_block flow_block;
 };
 
 #include "sja1105_dynamic_config.h"
@@ -122,10 +137,12 @@ enum sja1105_reset_reason {
 	SJA1105_RX_HWTSTAMPING,
 	SJA1105_AGEING_TIME,
 	SJA1105_SCHEDULING,
+	SJA1105_VIRTUAL_LINKS,
 };
 
 int sja1105_static_config_reload(struct sja1105_private *priv,
 				 enum sja1105_reset_reason reason);
+void sja1105_sticky_routes_flush(struct sja1105_private *priv, int port);
 
 /* From sja1105_spi.c */
 int sja1105_xfer_buf(const struct sja1105_private *priv,
@@ -173,10 +190,27 @@ int sja1105_clocking_setup_port(struct sja1105_private *priv, int port);
 int sja1105_clocking_setup(struct sja1105_private *priv);
 
 /* From sja1105_ethtool.c */
-void sja1105_get_ethtool_stats(struct dsa_switch *ds, int port, u64 *data);
-void sja1105_get_strings(struct dsa_switch *ds, int port,
-			 u32 stringset, u8 *data);
-int sja1105_get_sset_count(struct dsa_switch *ds, int port, int sset);
+int sja1105_stats_register(struct dsa_switch *ds);
+
+/* From sja1105_flower.c */
+int sja1105_cls_flower_add(struct dsa_switch *ds, int port,
+			   struct flow_cls_offload *cls, bool ingress);
+int sja1105_cls_flower_del(struct dsa_switch *ds, int port,
+			   struct flow_cls_offload *cls, bool ingress);
+void sja1105_flower_setup(struct dsa_switch *ds);
+void sja1105_flower_teardown(struct dsa_switch *ds);
+
+/* From sja1105_devlink.c */
+int sja1105_devlink_setup(struct dsa_switch *ds);
+void sja1105_devlink_teardown(struct dsa_switch *ds);
+int sja1105_devlink_param_get(struct dsa_switch *ds, u32 id,
+			      struct devlink_param_gset_ctx *ctx);
+int sja1105_devlink_param_set(struct dsa_switch *ds, u32 id,
+			      struct devlink_param_gset_ctx *ctx);
+void sja1105_devlink_snapshot_static_config(struct sja1105_private *priv,
+					    const u8 *config_buf,
+					    size_t buf_len);
+void sja1105_devlink_snapshot_l2_lookup(struct sja1105_private *priv);
 
 /* From sja1105_dynamic_config.c */
 int sja1105_dynamic_config_read(struct sja1105_private *priv,
@@ -0,0 +1,237 @@
+// SPDX-License-Identifier: GPL-2.0
+/* Copyright (c) 2019, Vladimir Oltean <olteanv@gmail.com>
+ */
+#include "sja1105.h"
+
+/* The static config is write-only from the host's perspective, and once
+ * uploaded it can't be read back from the switch. To be able to inspect what
+ * the hardware is actually running with, a copy of the packed buffer is
+ * stored as a devlink region snapshot on every successful upload. The packed
+ * format is exactly the one described in UM10944.pdf (device ID, followed by
+ * table headers, entries and CRCs, and terminated by a header with len 0), so
+ * that userspace may decode it using the same layouts as the packing
+ * functions in sja1105_static_config.c.
+ *
+ * The L2 lookup table is also snapshotted (in packed static config entry
+ * format, one slot per index, unused slots zeroed) right before the switch
+ * is reset, to show what dynamically learned and installed state was lost.
+ *
+ * Snapshots are only taken while the generic "region_snapshot_enable"
+ * parameter is set, since the L2 lookup readout costs 1024 SPI transfers.
+ * Snapshot IDs are allocated from a counter shared by both regions, so their
+ * order reflects the chronology of the events:
+ *
+ * devlink dev param set spi/spi2.0 name region_snapshot_enable \
+ *	value true cmode runtime
+ * devlink region show
+ * devlink region dump spi/spi2.0/static-config snapshot 1
+ */
+#define SJA1105_REGION_MAX_SNAPSHOTS	16
+
+int sja1105_devlink_param_get(struct dsa_switch *ds, u32 id,
+			      struct devlink_param_gset_ctx *ctx)
+{
+	struct sja1105_private *priv = ds->priv;
+
+	switch (id) {
+	case DEVLINK_PARAM_GENERIC_ID_REGION_SNAPSHOT:
+		ctx->val.vbool = priv->devlink_data.snapshot_enabled;
+		return 0;
+	default:
+		return -EOPNOTSUPP;
+	}
+}
+
+int sja1105_devlink_param_set(struct dsa_switch *ds, u32 id,
+			      struct devlink_param_gset_ctx *ctx)
+{
+	struct sja1105_private *priv = ds->priv;
+
+	switch (id) {
+	case DEVLINK_PARAM_GENERIC_ID_REGION_SNAPSHOT:
+		priv->devlink_data.snapshot_enabled = ctx->val.vbool;
+		return 0;
+	default:
+		return -EOPNOTSUPP;
+	}
+}
+
+static const struct devlink_param sja1105_devlink_params[] = {
+	DEVLINK_PARAM_GENERIC(REGION_SNAPSHOT,
+			      BIT(DEVLINK_PARAM_CMODE_RUNTIME),
+			      dsa_devlink_param_get, dsa_devlink_param_set,
+			      NULL),
+};
+
+/* Region size is fixed at creation time, so size the static config region
+ * for the case where all tables supported by this switch are full.
+ */
+static size_t sja1105_static_config_max_length(struct sja1105_private *priv)
+{
+	const struct sja1105_table_ops *ops = priv->info->static_ops;
+	unsigned int header_count = 1;
+	size_t sum = SJA1105_SIZE_DEVICE_ID;
+	enum sja1105_blk_idx i;
+
+	for (i = 0; i < BLK_IDX_MAX; i++) {
+		if (!ops[i].max_entry_count)
+			continue;
+
+		header_count++;
+		sum += ops[i].packed_entry_size * ops[i].max_entry_count;
+	}
+	sum += header_count * (SJA1105_SIZE_TABLE_HEADER + 4);
+	sum -= 4;
+
+	return sum;
+}
+
+static size_t sja1105_l2_lookup_region_length(struct sja1105_private *priv)
+{
+	const struct sja1105_table_ops *ops;
+
+	ops = &priv->info->static_ops[BLK_IDX_L2_LOOKUP];
+
+	return ops->packed_entry_size * SJA1105_MAX_L2_LOOKUP_COUNT;
+}
+
+static void sja1105_devlink_snapshot(struct sja1105_private *priv,
+				     struct devlink_region *region, u8 *data)
+{
+	struct dsa_switch *ds = priv->ds;
+	u32 id;
+	int rc;
+
+	id = devlink_region_shapshot_id_get(ds->devlink);
+
+	rc = devlink_region_snapshot_create(region, data, id, kfree);
+	if (rc < 0) {
+		/* Most likely all snapshot slots are in use and userspace
+		 * needs to delete some before new ones can be taken.
+		 */
+		dev_dbg(ds->dev, "Failed to create snapshot %u: %d\n", id, rc);
+		kfree(data);
+	}
+}
+
+/* Called with the just-uploaded packed buffer, with its final CRC in place */
+void sja1105_devlink_snapshot_static_config(struct sja1105_private *priv,
+					    const u8 *config_buf, size_t buf_len)
+{
+	struct sja1105_devlink_data *dl = &priv->devlink_data;
+	u8 *data;
+
+	if (!dl->static_config_region || !dl->snapshot_enabled)
+		return;
+
+	if (WARN_ON(buf_len > dl->static_config_len))
+		return;
+
+	data = kzalloc(dl->static_config_len, GFP_KERNEL);
+	if (!data)
+		return;
+
+	memcpy(data, config_buf, buf_len);
+
+	sja1105_devlink_snapshot(priv, dl->static_config_region, data);
+}
+
+void sja1105_devlink_snapshot_l2_lookup(struct sja1105_private *priv)
+{
+	struct sja1105_devlink_data *dl = &priv->devlink_data;
+	const struct sja1105_table_ops *ops;
+	u8 *data;
+	int i;
+
+	if (!dl->l2_lookup_region || !dl->snapshot_enabled)
+		return;
+
+	ops = &priv->info->static_ops[BLK_IDX_L2_LOOKUP];
+
+	data = kzalloc(sja1105_l2_lookup_region_length(priv), GFP_KERNEL);
+	if (!data)
+		return;
+
+	for (i = 0; i < SJA1105_MAX_L2_LOOKUP_COUNT; i++) {
+		struct sja1105_l2_lookup_entry l2_lookup = {0};
+		int rc;
+
+		rc = sja1105_dynamic_config_read(priv, BLK_IDX_L2_LOOKUP,
+						 i, &l2_lookup);
+		/* No fdb entry at i, leave the slot zeroed */
+		if (rc == -ENOENT)
+			continue;
+		if (rc) {
+			dev_err(priv->ds->dev,
+				"Failed to read L2 lookup entry %d: %d\n",
+				i, rc);
+			kfree(data);
+			return;
+		}
+
+		ops->packing(data + i * ops->packed_entry_size, &l2_lookup,
+			     PACK);
+	}
+
+	sja1105_devlink_snapshot(priv, dl->l2_lookup_region, data);
+}
+
+int sja1105_devlink_setup(struct dsa_switch *ds)
+{
+	struct sja1105_private *priv = ds->priv;
+	struct sja1105_devlink_data *dl = &priv->devlink_data;
+	struct devlink_region *region;
+	int rc;
+
+	rc = dsa_devlink_params_register(ds, sja1105_devlink_params,
+					 ARRAY_SIZE(sja1105_devlink_params));
+	if (rc < 0)
+		return rc;
+
+	dl->static_config_len = sja1105_static_config_max_length(priv);
+
+	region = devlink_region_create(ds->devlink, "static-config",
+				       SJA1105_REGION_MAX_SNAPSHOTS,
+				       dl->static_config_len);
+	if (IS_ERR(region)) {
+		rc = PTR_ERR(region);
+		goto out_params_unregister;
+	}
+	dl->static_config_region = region;
+
+	region = devlink_region_create(ds->devlink, "l2-lookup",
+				       SJA1105_REGION_MAX_SNAPSHOTS,
+				       sja1105_l2_lookup_region_length(priv));
+	if (IS_ERR(region)) {
+		rc = PTR_ERR(region);
+		goto out_static_config_region_destroy;
+	}
+	dl->l2_lookup_region = region;
+
+	return 0;
+
+out_static_config_region_destroy:
+	devlink_region_destroy(dl->static_config_region);
+	dl->static_config_region = NULL;
+out_params_unregister:
+	dsa_devlink_params_unregister(ds, sja1105_devlink_params,
+				      ARRAY_SIZE(sja1105_devlink_params));
+	return rc;
+}
+
+void sja1105_devlink_teardown(struct dsa_switch *ds)
+{
+	struct sja1105_private *priv = ds->priv;
+	struct sja1105_devlink_data *dl = &priv->devlink_data;
+
+	if (dl->l2_lookup_region) {
+		devlink_region_destroy(dl->l2_lookup_region);
+		dl->l2_lookup_region = NULL;
+	}
+	if (dl->static_config_region) {
+		devlink_region_destroy(dl->static_config_region);
+		dl->static_config_region = NULL;
+	}
+	dsa_devlink_params_unregister(ds, sja1105_devlink_params,
+				      ARRAY_SIZE(sja1105_devlink_params));
+}
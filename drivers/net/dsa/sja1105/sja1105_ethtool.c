@@ -244,73 +244,101 @@ static int sja1105_port_status_get(struct sja1105_private *priv,
 	return 0;
 }
 
-static char sja1105_port_stats[][ETH_GSTRING_LEN] = {
+/* Widths after which the hardware counters wrap around, used by the DSA core
+ * to accumulate them. The 1-bit flags and the 4-bit priorities are reported
+ * as last read, and so are the queue levels.
+ */
+static const struct dsa_stat_desc sja1105_port_stats[] = {
 	/* MAC-Level Diagnostic Counters */
-	"n_runt",
-	"n_soferr",
-	"n_alignerr",
-	"n_miierr",
+	{ "n_runt",		8 },
+	{ "n_soferr",		8 },
+	{ "n_alignerr",		8 },
+	{ "n_miierr",		8 },
 	/* MAC-Level Diagnostic Flags */
-	"typeerr",
-	"sizeerr",
-	"tctimeout",
-	"priorerr",
-	"nomaster",
-	"memov",
-	"memerr",
-	"invtyp",
-	"intcyov",
-	"domerr",
-	"pcfbagdrop",
-	"spcprior",
-	"ageprior",
-	"portdrop",
-	"lendrop",
-	"bagdrop",
-	"policeerr",
-	"drpnona664err",
-	"spcerr",
-	"agedrp",
+	{ "typeerr",		0 },
+	{ "sizeerr",		0 },
+	{ "tctimeout",		0 },
+	{ "priorerr",		0 },
+	{ "nomaster",		0 },
+	{ "memov",		0 },
+	{ "memerr",		0 },
+	{ "invtyp",		0 },
+	{ "intcyov",		0 },
+	{ "domerr",		0 },
+	{ "pcfbagdrop",		0 },
+	{ "spcprior",		0 },
+	{ "ageprior",		0 },
+	{ "portdrop",		0 },
+	{ "lendrop",		0 },
+	{ "bagdrop",		0 },
+	{ "policeerr",		0 },
+	{ "drpnona664err",	0 },
+	{ "spcerr",		0 },
+	{ "agedrp",		0 },
 	/* High-Level Diagnostic Counters */
-	"n_n664err",
-	"n_vlanerr",
-	"n_unreleased",
-	"n_sizeerr",
-	"n_crcerr",
-	"n_vlnotfound",
-	"n_ctpolerr",
-	"n_polerr",
-	"n_rxfrm",
-	"n_rxbyte",
-	"n_txfrm",
-	"n_txbyte",
-	"n_qfull",
-	"n_part_drop",
-	"n_egr_disabled",
-	"n_not_reach",
-};
-
-static char sja1105pqrs_extra_port_stats[][ETH_GSTRING_LEN] = {
-	/* Queue Levels */
-	"qlevel_hwm_0",
-	"qlevel_hwm_1",
-	"qlevel_hwm_2",
-	"qlevel_hwm_3",
-	"qlevel_hwm_4",
-	"qlevel_hwm_5",
-	"qlevel_hwm_6",
-	"qlevel_hwm_7",
-	"qlevel_0",
-	"qlevel_1",
-	"qlevel_2",
-	"qlevel_3",
-	"qlevel_4",
-	"qlevel_5",
-	"qlevel_6",
-	"qlevel_7",
+	{ "n_n664err",		32 },
+	{ "n_vlanerr",		32 },
+	{ "n_unreleased",	32 },
+	{ "n_sizeerr",		32 },
+	{ "n_crcerr",		32 },
+	{ "n_vlnotfound",	32 },
+	{ "n_ctpolerr",		32 },
+	{ "n_polerr",		32 },
+	{ "n_rxfrm",		64 },
+	{ "n_rxbyte",		64 },
+	{ "n_txfrm",		64 },
+	{ "n_txbyte",		64 },
+	{ "n_qfull",		32 },
+	{ "n_part_drop",	32 },
+	{ "n_egr_disabled",	32 },
+	{ "n_not_reach",	32 },
+	/* Queue Levels, only for P/Q/R/S */
+	{ "qlevel_hwm_0",	0 },
+	{ "qlevel_hwm_1",	0 },
+	{ "qlevel_hwm_2",	0 },
+	{ "qlevel_hwm_3",	0 },
+	{ "qlevel_hwm_4",	0 },
+	{ "qlevel_hwm_5",	0 },
+	{ "qlevel_hwm_6",	0 },
+	{ "qlevel_hwm_7",	0 },
+	{ "qlevel_0",		0 },
+	{ "qlevel_1",		0 },
+	{ "qlevel_2",		0 },
+	{ "qlevel_3",		0 },
+	{ "qlevel_4",		0 },
+	{ "qlevel_5",		0 },
+	{ "qlevel_6",		0 },
+	{ "qlevel_7",		0 },
 };
 
-void sja1105_get_ethtool_stats(struct dsa_switch *ds, int port, u64 *data)
+#define SJA1105ET_NUM_PORT_STATS	(ARRAY_SIZE(sja1105_port_stats) - 16)
+#define SJA1105PQRS_NUM_PORT_STATS	ARRAY_SIZE(sja1105_port_stats)
+
+/* Indices of the counters used by ndo_get_stats64 */
+#define SJA1105_STAT_N_RUNT		0
+#define SJA1105_STAT_N_SOFERR		1
+#define SJA1105_STAT_N_ALIGNERR		2
+#define SJA1105_STAT_N_MIIERR		3
+#define SJA1105_STAT_N_N664ERR		24
+#define SJA1105_STAT_N_VLANERR		25
+#define SJA1105_STAT_N_SIZEERR		27
+#define SJA1105_STAT_N_CRCERR		28
+#define SJA1105_STAT_N_VLNOTFOUND	29
+#define SJA1105_STAT_N_CTPOLERR		30
+#define SJA1105_STAT_N_POLERR		31
+#define SJA1105_STAT_N_RXFRM		32
+#define SJA1105_STAT_N_RXBYTE		33
+#define SJA1105_STAT_N_TXFRM		34
+#define SJA1105_STAT_N_TXBYTE		35
+#define SJA1105_STAT_N_QFULL		36
+#define SJA1105_STAT_N_PART_DROP	37
+#define SJA1105_STAT_N_EGR_DISABLED	38
+#define SJA1105_STAT_N_NOT_REACH	39
+
+/* Called by the DSA core from the stats worker, never from the ethtool or
+ * ndo_get_stats64 paths.
+ */
+static int sja1105_stats_read(struct dsa_switch *ds, int port, u64 *data)
 {
 	struct sja1105_private *priv = ds->priv;
 	struct sja1105_port_status status;
@@ -319,12 +347,9 @@ void sja1105_get_ethtool_stats(struct dsa_switch *ds, int port, u64 *data)
 	memset(&status, 0, sizeof(status));
 
 	rc = sja1105_port_status_get(priv, &status, port);
-	if (rc < 0) {
-		dev_err(ds->dev, "Failed to read port %d counters: %d\n",
-			port, rc);
-		return;
-	}
-	memset(data, 0, ARRAY_SIZE(sja1105_port_stats) * sizeof(u64));
+	if (rc < 0)
+		return rc;
+
 	data[k++] = status.mac.n_runt;
 	data[k++] = status.mac.n_soferr;
 	data[k++] = status.mac.n_alignerr;
@@ -368,52 +393,68 @@ void sja1105_get_ethtool_stats(struct dsa_switch *ds, int port, u64 *data)
 
 	if (priv->info->device_id == SJA1105E_DEVICE_ID ||
 	    priv->info->device_id == SJA1105T_DEVICE_ID)
-		return;
+		return 0;
 
-	memset(data + k, 0, ARRAY_SIZE(sja1105pqrs_extra_port_stats) *
-			sizeof(u64));
-	for (i = 0; i < 8; i++) {
+	for (i = 0; i < 8; i++)
 		data[k++] = status.hl2.qlevel_hwm[i];
+	for (i = 0; i < 8; i++)
 		data[k++] = status.hl2.qlevel[i];
-	}
+
+	return 0;
 }
 
-void sja1105_get_strings(struct dsa_switch *ds, int port,
-			 u32 stringset, u8 *data)
+static void sja1105_fill_stats64(struct dsa_switch *ds, int port,
+				 const u64 *stats,
+				 struct rtnl_link_stats64 *s)
 {
-	struct sja1105_private *priv = ds->priv;
-	u8 *p = data;
-	int i;
-
-	switch (stringset) {
-	case ETH_SS_STATS:
-		for (i = 0; i < ARRAY_SIZE(sja1105_port_stats); i++) {
-			strlcpy(p, sja1105_port_stats[i], ETH_GSTRING_LEN);
-			p += ETH_GSTRING_LEN;
-		}
-		if (priv->info->device_id == SJA1105E_DEVICE_ID ||
-		    priv->info->device_id == SJA1105T_DEVICE_ID)
-			return;
-		for (i = 0; i < ARRAY_SIZE(sja1105pqrs_extra_port_stats); i++) {
-			strlcpy(p, sja1105pqrs_extra_port_stats[i],
-				ETH_GSTRING_LEN);
-			p += ETH_GSTRING_LEN;
-		}
-		break;
-	}
+	s->rx_packets = stats[SJA1105_STAT_N_RXFRM];
+	s->rx_bytes = stats[SJA1105_STAT_N_RXBYTE];
+	s->tx_packets = stats[SJA1105_STAT_N_TXFRM];
+	s->tx_bytes = stats[SJA1105_STAT_N_TXBYTE];
+	s->rx_crc_errors = stats[SJA1105_STAT_N_CRCERR];
+	s->rx_frame_errors = stats[SJA1105_STAT_N_ALIGNERR];
+	s->rx_length_errors = stats[SJA1105_STAT_N_RUNT] +
+			      stats[SJA1105_STAT_N_SIZEERR];
+	s->rx_errors = s->rx_crc_errors + s->rx_frame_errors +
+		       s->rx_length_errors +
+		       stats[SJA1105_STAT_N_SOFERR] +
+		       stats[SJA1105_STAT_N_MIIERR];
+	s->rx_dropped = stats[SJA1105_STAT_N_N664ERR] +
+			stats[SJA1105_STAT_N_VLANERR] +
+			stats[SJA1105_STAT_N_VLNOTFOUND] +
+			stats[SJA1105_STAT_N_CTPOLERR] +
+			stats[SJA1105_STAT_N_POLERR];
+	s->tx_dropped = stats[SJA1105_STAT_N_QFULL] +
+			stats[SJA1105_STAT_N_PART_DROP] +
+			stats[SJA1105_STAT_N_EGR_DISABLED] +
+			stats[SJA1105_STAT_N_NOT_REACH];
 }
 
-int sja1105_get_sset_count(struct dsa_switch *ds, int port, int sset)
+static const struct dsa_stats_ops sja1105et_stats_ops = {
+	.descs		= sja1105_port_stats,
+	.num_stats	= SJA1105ET_NUM_PORT_STATS,
+	.read		= sja1105_stats_read,
+	.fill_stats64	= sja1105_fill_stats64,
+};
+
+static const struct dsa_stats_ops sja1105pqrs_stats_ops = {
+	.descs		= sja1105_port_stats,
+	.num_stats	= SJA1105PQRS_NUM_PORT_STATS,
+	.read		= sja1105_stats_read,
+	.fill_stats64	= sja1105_fill_stats64,
+};
+
+/* Reading the counters of a port takes 3 to 4 SPI transfers, so let the DSA
+ * core do it periodically in the background and serve ethtool -S and the
+ * netdev stats from the accumulated values.
+ */
+int sja1105_stats_register(struct dsa_switch *ds)
 {
-	int count = ARRAY_SIZE(sja1105_port_stats);
 	struct sja1105_private *priv = ds->priv;
 
-	if (sset != ETH_SS_STATS)
-		return -EOPNOTSUPP;
-
-	if (priv->info->device_id == SJA1105PR_DEVICE_ID ||
-	    priv->info->device_id == SJA1105QS_DEVICE_ID)
-		count += ARRAY_SIZE(sja1105pqrs_extra_port_stats);
+	if (priv->info->device_id == SJA1105E_DEVICE_ID ||
+	    priv->info->device_id == SJA1105T_DEVICE_ID)
+		return dsa_stats_register(ds, &sja1105et_stats_ops);
 
-	return count;
+	return dsa_stats_register(ds, &sja1105pqrs_stats_ops);
 }
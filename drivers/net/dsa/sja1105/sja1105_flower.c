@@ -0,0 +1,618 @@
+// SPDX-License-Identifier: GPL-2.0
+/* Copyright (c) 2019, Vladimir Oltean <olteanv@gmail.com>
+ */
+#include <linux/dsa/8021q.h>
+#include <linux/etherdevice.h>
+#include <linux/if_vlan.h>
+#include <linux/sort.h>
+#include <net/flow_offload.h>
+#include "sja1105.h"
+
+/* tc-flower rules are offloaded as virtual links (VLs), a TTEthernet heritage
+ * of the switch. Frames are looked up in the VL lookup table by
+ * {ingress port, DMAC, VID, PCP} before the L2 lookup, and on a hit they
+ * bypass it and are sent to the destination ports of the VL:
+ *
+ * - redirect, trap and drop rules become best-effort VLs, with the
+ *   destination ports held in the VL lookup entry itself.
+ * - police rules become critical, rate-constrained VLs: at most one frame of
+ *   up to maxlen bytes per Bandwidth Allocation Gap (BAG) is admitted, with
+ *   some jitter tolerated, and the frames are forwarded through the VL
+ *   forwarding table and a VL memory partition.
+ *
+ * The VL tables are only configurable through the static config, so each
+ * rule change resets the switch.
+ *
+ * The switch doesn't count the frames matching a VL, so rules have no stats.
+ * The frames dropped by the VL policers are counted per ingress port, in the
+ * n_ctpolerr and n_unreleased counters.
+ *
+ * With VLAN filtering off, all frames are classified to the tag_8021q pvid
+ * of their ingress port, so rules in that mode must not match on VLAN, and
+ * match on the port's pvid instead.
+ */
+#define SJA1105_VL_MAXLEN		(VLAN_ETH_FRAME_LEN + ETH_FCS_LEN)
+/* BAG and jitter are expressed in 8 us ticks */
+#define SJA1105_VL_TICK_NS		8000
+#define SJA1105_VL_MAX_BAG		GENMASK(13, 0)
+#define SJA1105_VL_MAX_JITTER		GENMASK(9, 0)
+#define SJA1105_VL_MEM_PARTITION	0
+
+struct sja1105_rule {
+	struct list_head list;
+	unsigned long cookie;
+	int port;
+	/* Key */
+	u64 dmac;
+	u16 vid;
+	u8 pcp;
+	/* Action */
+	unsigned long destports;
+	bool police;
+	u64 bag;
+	u64 jitter;
+};
+
+static const int sja1105_vl_blk_idx[] = {
+	BLK_IDX_VL_LOOKUP,
+	BLK_IDX_VL_POLICING,
+	BLK_IDX_VL_FORWARDING,
+	BLK_IDX_VL_FORWARDING_PARAMS,
+};
+
+/* The VL tables as they were before a rule change, together with the L2
+ * memory partition they were carved out of, so that the change can be
+ * undone if the switch can't be reprogrammed.
+ */
+struct sja1105_vl_backup {
+	struct sja1105_table tables[ARRAY_SIZE(sja1105_vl_blk_idx)];
+	u64 l2_part_spc;
+	int num_virtual_links;
+};
+
+static struct sja1105_rule *sja1105_rule_find(struct sja1105_private *priv,
+					      int port, unsigned long cookie)
+{
+	struct sja1105_rule *rule;
+
+	list_for_each_entry(rule, &priv->flow_block.rules, list)
+		if (rule->port == port && rule->cookie == cookie)
+			return rule;
+
+	return NULL;
+}
+
+static bool sja1105_rule_key_equal(const struct sja1105_rule *a,
+				   const struct sja1105_rule *b)
+{
+	return a->port == b->port && a->dmac == b->dmac &&
+	       a->vid == b->vid && a->pcp == b->pcp;
+}
+
+/* The hardware does a binary search in the VL lookup table, whose key is
+ * {MACADDR, VLANID, PORT, VLANPRIOR} in order of significance.
+ */
+static int sja1105_rule_key_cmp(const void *a, const void *b)
+{
+	const struct sja1105_rule *ra = *(const struct sja1105_rule **)a;
+	const struct sja1105_rule *rb = *(const struct sja1105_rule **)b;
+
+	if (ra->dmac != rb->dmac)
+		return ra->dmac < rb->dmac ? -1 : 1;
+	if (ra->vid != rb->vid)
+		return ra->vid < rb->vid ? -1 : 1;
+	if (ra->port != rb->port)
+		return ra->port < rb->port ? -1 : 1;
+	if (ra->pcp != rb->pcp)
+		return ra->pcp < rb->pcp ? -1 : 1;
+	return 0;
+}
+
+static void sja1105_table_free(struct sja1105_table *table)
+{
+	kfree(table->entries);
+	table->entries = NULL;
+	table->entry_count = 0;
+}
+
+/* Regenerate the VL tables of the static config from the list of rules */
+static int sja1105_init_virtual_links(struct sja1105_private *priv)
+{
+	struct sja1105_vl_forwarding_params_entry *vl_fwd_params;
+	struct sja1105_l2_forwarding_params_entry *l2_fwd_params;
+	struct sja1105_table *tables = priv->static_config.tables;
+	struct sja1105_vl_forwarding_entry *vl_fwd;
+	struct sja1105_vl_lookup_entry *vl_lookup;
+	struct sja1105_vl_policing_entry *vl_pol;
+	struct sja1105_rule **sorted, *rule;
+	int num_virtual_links = 0;
+	bool have_critical = false;
+	int i, rc = -ENOMEM;
+
+	sja1105_table_free(&tables[BLK_IDX_VL_LOOKUP]);
+	sja1105_table_free(&tables[BLK_IDX_VL_POLICING]);
+	sja1105_table_free(&tables[BLK_IDX_VL_FORWARDING]);
+	sja1105_table_free(&tables[BLK_IDX_VL_FORWARDING_PARAMS]);
+
+	l2_fwd_params = tables[BLK_IDX_L2_FORWARDING_PARAMS].entries;
+	l2_fwd_params->part_spc[0] = SJA1105_MAX_FRAME_MEMORY;
+
+	list_for_each_entry(rule, &priv->flow_block.rules, list) {
+		num_virtual_links++;
+		if (rule->police)
+			have_critical = true;
+	}
+
+	priv->flow_block.num_virtual_links = num_virtual_links;
+
+	if (!num_virtual_links)
+		return 0;
+
+	if (num_virtual_links > SJA1105_MAX_VL_LOOKUP_COUNT)
+		return -ENOSPC;
+
+	sorted = kcalloc(num_virtual_links, sizeof(*sorted), GFP_KERNEL);
+	if (!sorted)
+		return -ENOMEM;
+
+	i = 0;
+	list_for_each_entry(rule, &priv->flow_block.rules, list)
+		sorted[i++] = rule;
+
+	sort(sorted, num_virtual_links, sizeof(*sorted),
+	     sja1105_rule_key_cmp, NULL);
+
+	vl_lookup = kcalloc(num_virtual_links, sizeof(*vl_lookup), GFP_KERNEL);
+	if (!vl_lookup)
+		goto out;
+
+	tables[BLK_IDX_VL_LOOKUP].entries = vl_lookup;
+	tables[BLK_IDX_VL_LOOKUP].entry_count = num_virtual_links;
+
+	for (i = 0; i < num_virtual_links; i++) {
+		rule = sorted[i];
+
+		vl_lookup[i].port = rule->port;
+		vl_lookup[i].macaddr = rule->dmac;
+		vl_lookup[i].vlanid = rule->vid;
+		vl_lookup[i].vlanprior = rule->pcp;
+		vl_lookup[i].iscritical = rule->police;
+		vl_lookup[i].destports = rule->destports;
+	}
+
+	if (!have_critical) {
+		rc = 0;
+		goto out;
+	}
+
+	/* The critical VLs are indexed by their position in the lookup table,
+	 * so the policing and forwarding tables need as many entries. Those
+	 * of the best-effort VLs are unused.
+	 */
+	vl_pol = kcalloc(num_virtual_links, sizeof(*vl_pol), GFP_KERNEL);
+	if (!vl_pol)
+		goto out;
+
+	tables[BLK_IDX_VL_POLICING].entries = vl_pol;
+	tables[BLK_IDX_VL_POLICING].entry_count = num_virtual_links;
+
+	vl_fwd = kcalloc(num_virtual_links, sizeof(*vl_fwd), GFP_KERNEL);
+	if (!vl_fwd)
+		goto out;
+
+	tables[BLK_IDX_VL_FORWARDING].entries = vl_fwd;
+	tables[BLK_IDX_VL_FORWARDING].entry_count = num_virtual_links;
+
+	vl_fwd_params = kcalloc(SJA1105_MAX_VL_FORWARDING_PARAMS_COUNT,
+				sizeof(*vl_fwd_params), GFP_KERNEL);
+	if (!vl_fwd_params)
+		goto out;
+
+	tables[BLK_IDX_VL_FORWARDING_PARAMS].entries = vl_fwd_params;
+	tables[BLK_IDX_VL_FORWARDING_PARAMS].entry_count =
+		SJA1105_MAX_VL_FORWARDING_PARAMS_COUNT;
+
+	/* Carve the VL memory partition out of the L2 one */
+	vl_fwd_params->partspc[SJA1105_VL_MEM_PARTITION] =
+		SJA1105_VL_FRAME_MEMORY;
+	l2_fwd_params->part_spc[0] -= SJA1105_VL_FRAME_MEMORY;
+
+	for (i = 0; i < num_virtual_links; i++) {
+		rule = sorted[i];
+
+		vl_pol[i].sharindx = i;
+		if (!rule->police)
+			continue;
+
+		vl_pol[i].type = 0;
+		vl_pol[i].maxlen = SJA1105_VL_MAXLEN;
+		vl_pol[i].bag = rule->bag;
+		vl_pol[i].jitter = rule->jitter;
+
+		vl_fwd[i].type = 0;
+		vl_fwd[i].priority = rule->pcp;
+		vl_fwd[i].partition = SJA1105_VL_MEM_PARTITION;
+		vl_fwd[i].destports = rule->destports;
+	}
+
+	rc = 0;
+out:
+	kfree(sorted);
+	if (rc) {
+		sja1105_table_free(&tables[BLK_IDX_VL_LOOKUP]);
+		sja1105_table_free(&tables[BLK_IDX_VL_POLICING]);
+		sja1105_table_free(&tables[BLK_IDX_VL_FORWARDING]);
+		sja1105_table_free(&tables[BLK_IDX_VL_FORWARDING_PARAMS]);
+		l2_fwd_params->part_spc[0] = SJA1105_MAX_FRAME_MEMORY;
+	}
+	return rc;
+}
+
+/* Takes the VL tables out of the static config, for
+ * sja1105_init_virtual_links() to build new ones.
+ */
+static void sja1105_vl_save(struct sja1105_private *priv,
+			    struct sja1105_vl_backup *backup)
+{
+	struct sja1105_l2_forwarding_params_entry *l2_fwd_params;
+	struct sja1105_table *tables = priv->static_config.tables;
+	int i;
+
+	l2_fwd_params = tables[BLK_IDX_L2_FORWARDING_PARAMS].entries;
+
+	for (i = 0; i < ARRAY_SIZE(sja1105_vl_blk_idx); i++) {
+		struct sja1105_table *table = &tables[sja1105_vl_blk_idx[i]];
+
+		backup->tables[i] = *table;
+		table->entries = NULL;
+		table->entry_count = 0;
+	}
+	backup->l2_part_spc = l2_fwd_params->part_spc[0];
+	backup->num_virtual_links = priv->flow_block.num_virtual_links;
+}
+
+static void sja1105_vl_restore(struct sja1105_private *priv,
+			       struct sja1105_vl_backup *backup)
+{
+	struct sja1105_l2_forwarding_params_entry *l2_fwd_params;
+	struct sja1105_table *tables = priv->static_config.tables;
+	int i;
+
+	l2_fwd_params = tables[BLK_IDX_L2_FORWARDING_PARAMS].entries;
+
+	for (i = 0; i < ARRAY_SIZE(sja1105_vl_blk_idx); i++) {
+		struct sja1105_table *table = &tables[sja1105_vl_blk_idx[i]];
+
+		sja1105_table_free(table);
+		*table = backup->tables[i];
+	}
+	l2_fwd_params->part_spc[0] = backup->l2_part_spc;
+	priv->flow_block.num_virtual_links = backup->num_virtual_links;
+}
+
+static void sja1105_vl_discard(struct sja1105_vl_backup *backup)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(sja1105_vl_blk_idx); i++)
+		sja1105_table_free(&backup->tables[i]);
+}
+
+/* Regenerates the VL tables after a change to the list of rules, and
+ * reprograms the switch with them. On failure, the switch is put back to
+ * the previous tables, and the caller must revert its change to the list.
+ */
+static int sja1105_vl_apply(struct sja1105_private *priv,
+			    struct netlink_ext_ack *extack)
+{
+	struct sja1105_vl_backup backup;
+	int rc;
+
+	sja1105_vl_save(priv, &backup);
+
+	rc = sja1105_init_virtual_links(priv);
+	if (rc) {
+		NL_SET_ERR_MSG_MOD(extack, "Failed to build VL tables");
+		sja1105_vl_restore(priv, &backup);
+		return rc;
+	}
+
+	rc = sja1105_static_config_reload(priv, SJA1105_VIRTUAL_LINKS);
+	if (rc) {
+		NL_SET_ERR_MSG_MOD(extack, "Failed to reload static config");
+		sja1105_vl_restore(priv, &backup);
+		if (sja1105_static_config_reload(priv, SJA1105_VIRTUAL_LINKS))
+			dev_err(priv->ds->dev,
+				"Failed to restore the previous VL tables\n");
+		return rc;
+	}
+
+	sja1105_vl_discard(&backup);
+
+	return 0;
+}
+
+static int sja1105_flower_parse_key(struct sja1105_private *priv, int port,
+				    struct flow_cls_offload *cls,
+				    struct sja1105_rule *rule)
+{
+	struct flow_rule *flow_rule = flow_cls_offload_flow_rule(cls);
+	struct netlink_ext_ack *extack = cls->common.extack;
+	struct flow_dissector *dissector = flow_rule->match.dissector;
+	struct sja1105_mac_config_entry *mac;
+	struct flow_match_eth_addrs eth;
+	struct dsa_switch *ds = priv->ds;
+	struct flow_match_basic basic;
+	struct flow_match_vlan vlan;
+	bool is_vlan_key = false;
+
+	if (dissector->used_keys &
+	    ~(BIT(FLOW_DISSECTOR_KEY_BASIC) |
+	      BIT(FLOW_DISSECTOR_KEY_CONTROL) |
+	      BIT(FLOW_DISSECTOR_KEY_VLAN) |
+	      BIT(FLOW_DISSECTOR_KEY_ETH_ADDRS))) {
+		NL_SET_ERR_MSG_MOD(extack, "Unsupported keys used");
+		return -EOPNOTSUPP;
+	}
+
+	if (flow_rule_match_key(flow_rule, FLOW_DISSECTOR_KEY_BASIC)) {
+		flow_rule_match_basic(flow_rule, &basic);
+		if (basic.mask->n_proto || basic.mask->ip_proto) {
+			NL_SET_ERR_MSG_MOD(extack,
+					   "Matching on protocol not supported");
+			return -EOPNOTSUPP;
+		}
+	}
+
+	if (!flow_rule_match_key(flow_rule, FLOW_DISSECTOR_KEY_ETH_ADDRS)) {
+		NL_SET_ERR_MSG_MOD(extack,
+				   "Destination MAC address is required");
+		return -EOPNOTSUPP;
+	}
+
+	flow_rule_match_eth_addrs(flow_rule, &eth);
+
+	if (!is_zero_ether_addr(eth.mask->src)) {
+		NL_SET_ERR_MSG_MOD(extack,
+				   "Matching on source MAC not supported");
+		return -EOPNOTSUPP;
+	}
+
+	if (!is_broadcast_ether_addr(eth.mask->dst)) {
+		NL_SET_ERR_MSG_MOD(extack,
+				   "Masked matching on MAC not supported");
+		return -EOPNOTSUPP;
+	}
+
+	rule->dmac = ether_addr_to_u64(eth.key->dst);
+
+	if (flow_rule_match_key(flow_rule, FLOW_DISSECTOR_KEY_VLAN)) {
+		flow_rule_match_vlan(flow_rule, &vlan);
+
+		if (vlan.mask->vlan_id != VLAN_VID_MASK ||
+		    vlan.mask->vlan_priority != 0x7) {
+			NL_SET_ERR_MSG_MOD(extack,
+					   "VLAN ID and PCP must both be matched exactly");
+			return -EOPNOTSUPP;
+		}
+
+		rule->vid = vlan.key->vlan_id;
+		rule->pcp = vlan.key->vlan_priority;
+		is_vlan_key = true;
+	}
+
+	if (ds->vlan_filtering && !is_vlan_key) {
+		NL_SET_ERR_MSG_MOD(extack,
+				   "VLAN ID and PCP are required with VLAN filtering");
+		return -EOPNOTSUPP;
+	}
+
+	if (!ds->vlan_filtering && is_vlan_key) {
+		NL_SET_ERR_MSG_MOD(extack,
+				   "Cannot match on VLAN without VLAN filtering");
+		return -EOPNOTSUPP;
+	}
+
+	if (!is_vlan_key) {
+		mac = priv->static_config.tables[BLK_IDX_MAC_CONFIG].entries;
+
+		rule->vid = dsa_8021q_rx_vid(ds, port);
+		rule->pcp = mac[port].vlanprio;
+	}
+
+	return 0;
+}
+
+/* At most one frame of SJA1105_VL_MAXLEN bytes per BAG is admitted, and a
+ * frame may come in up to "jitter" early, which is how the burst is
+ * accommodated.
+ */
+static int sja1105_flower_parse_police(const struct flow_action_entry *act,
+				       struct sja1105_rule *rule,
+				       struct netlink_ext_ack *extack)
+{
+	u64 rate = act->police.rate_bytes_ps;
+	u64 bag, jitter;
+
+	if (!rate) {
+		NL_SET_ERR_MSG_MOD(extack, "Police rate cannot be zero");
+		return -EINVAL;
+	}
+
+	bag = div64_u64((u64)SJA1105_VL_MAXLEN * NSEC_PER_SEC,
+			rate * SJA1105_VL_TICK_NS);
+	if (!bag || bag > SJA1105_VL_MAX_BAG) {
+		NL_SET_ERR_MSG_MOD(extack, "Police rate out of range");
+		return -ERANGE;
+	}
+
+	/* The burst comes as the time it takes to send it at @rate */
+	jitter = div_u64(max_t(s64, act->police.burst, 0), SJA1105_VL_TICK_NS);
+	if (jitter > SJA1105_VL_MAX_JITTER)
+		jitter = SJA1105_VL_MAX_JITTER;
+
+	rule->police = true;
+	rule->bag = bag;
+	rule->jitter = jitter;
+
+	return 0;
+}
+
+static int sja1105_flower_parse_actions(struct sja1105_private *priv, int port,
+					struct flow_cls_offload *cls,
+					struct sja1105_rule *rule)
+{
+	struct flow_rule *flow_rule = flow_cls_offload_flow_rule(cls);
+	struct netlink_ext_ack *extack = cls->common.extack;
+	const struct flow_action_entry *act;
+	struct dsa_switch *ds = priv->ds;
+	bool forward = false, drop = false;
+	int i, p, rc;
+
+	flow_action_for_each(i, act, &flow_rule->action) {
+		switch (act->id) {
+		case FLOW_ACTION_REDIRECT:
+			for (p = 0; p < SJA1105_NUM_PORTS; p++) {
+				if (dsa_is_user_port(ds, p) &&
+				    dsa_to_port(ds, p)->slave == act->dev)
+					break;
+			}
+			if (p == SJA1105_NUM_PORTS) {
+				NL_SET_ERR_MSG_MOD(extack,
+						   "Can only redirect to a port of the same switch");
+				return -EOPNOTSUPP;
+			}
+			rule->destports |= BIT(p);
+			forward = true;
+			break;
+		case FLOW_ACTION_TRAP:
+			rule->destports |= BIT(dsa_upstream_port(ds, port));
+			forward = true;
+			break;
+		case FLOW_ACTION_DROP:
+			drop = true;
+			break;
+		case FLOW_ACTION_POLICE:
+			rc = sja1105_flower_parse_police(act, rule, extack);
+			if (rc)
+				return rc;
+			break;
+		default:
+			NL_SET_ERR_MSG_MOD(extack,
+					   "Action not supported");
+			return -EOPNOTSUPP;
+		}
+	}
+
+	if (drop && (forward || rule->police)) {
+		NL_SET_ERR_MSG_MOD(extack,
+				   "Drop cannot be combined with other actions");
+		return -EOPNOTSUPP;
+	}
+
+	if (!drop && !forward) {
+		NL_SET_ERR_MSG_MOD(extack,
+				   "A redirect, trap or drop action is required");
+		return -EOPNOTSUPP;
+	}
+
+	return 0;
+}
+
+int sja1105_cls_flower_add(struct dsa_switch *ds, int port,
+			   struct flow_cls_offload *cls, bool ingress)
+{
+	struct netlink_ext_ack *extack = cls->common.extack;
+	struct sja1105_private *priv = ds->priv;
+	struct sja1105_rule *rule, *other;
+	int rc;
+
+	if (!ingress || cls->common.chain_index) {
+		NL_SET_ERR_MSG_MOD(extack,
+				   "Only ingress chain 0 can be offloaded");
+		return -EOPNOTSUPP;
+	}
+
+	if (sja1105_rule_find(priv, port, cls->cookie))
+		return -EEXIST;
+
+	rule = kzalloc(sizeof(*rule), GFP_KERNEL);
+	if (!rule)
+		return -ENOMEM;
+
+	rule->cookie = cls->cookie;
+	rule->port = port;
+
+	rc = sja1105_flower_parse_key(priv, port, cls, rule);
+	if (rc)
+		goto out_free;
+
+	rc = sja1105_flower_parse_actions(priv, port, cls, rule);
+	if (rc)
+		goto out_free;
+
+	list_for_each_entry(other, &priv->flow_block.rules, list) {
+		if (sja1105_rule_key_equal(rule, other)) {
+			NL_SET_ERR_MSG_MOD(extack,
+					   "A rule with the same key already exists");
+			rc = -EEXIST;
+			goto out_free;
+		}
+	}
+
+	list_add_tail(&rule->list, &priv->flow_block.rules);
+
+	rc = sja1105_vl_apply(priv, extack);
+	if (rc) {
+		list_del(&rule->list);
+		goto out_free;
+	}
+
+	return 0;
+
+out_free:
+	kfree(rule);
+	return rc;
+}
+
+int sja1105_cls_flower_del(struct dsa_switch *ds, int port,
+			   struct flow_cls_offload *cls, bool ingress)
+{
+	struct sja1105_private *priv = ds->priv;
+	struct sja1105_rule *rule;
+	int rc;
+
+	rule = sja1105_rule_find(priv, port, cls->cookie);
+	if (!rule)
+		return 0;
+
+	list_del(&rule->list);
+
+	rc = sja1105_vl_apply(priv, cls->common.extack);
+	if (rc) {
+		list_add_tail(&rule->list, &priv->flow_block.rules);
+		return rc;
+	}
+
+	kfree(rule);
+
+	return 0;
+}
+
+void sja1105_flower_setup(struct dsa_switch *ds)
+{
+	struct sja1105_private *priv = ds->priv;
+
+	INIT_LIST_HEAD(&priv->flow_block.rules);
+}
+
+void sja1105_flower_teardown(struct dsa_switch *ds)
+{
+	struct sja1105_private *priv = ds->priv;
+	struct sja1105_rule *rule, *n;
+
+	list_for_each_entry_safe(rule, n, &priv->flow_block.rules, list) {
+		list_del(&rule->list);
+		kfree(rule);
+	}
+}
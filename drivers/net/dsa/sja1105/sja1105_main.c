@@ -1338,6 +1338,7 @@ static const char * const sja1105_reset_reasons[] = {
 	[SJA1105_RX_HWTSTAMPING] = "RX timestamping",
 	[SJA1105_AGEING_TIME] = "Ageing time",
 	[SJA1105_SCHEDULING] = "Time-aware scheduling",
+	[SJA1105_VIRTUAL_LINKS] = "Virtual links",
 };
 
 /* For situations where we need to change a setting at runtime that is only
@@ -1354,6 +1355,7 @@ int sja1105_static_config_reload(struct sja1105_private *priv,
 	struct sja1105_mac_config_entry *mac;
 	int speed_mbps[SJA1105_NUM_PORTS];
 	struct dsa_switch *ds = priv->ds;
+	bool cleared = false;
 	s64 t1, t2, t3, t4;
 	s64 t12, t34;
 	int rc, i;
@@ -1361,6 +1363,9 @@ int sja1105_static_config_reload(struct sja1105_private *priv,
 
 	mutex_lock(&priv->mgmt_lock);
 
+	/* The management routes don't survive the reset */
+	sja1105_sticky_routes_flush(priv, -1);
+
 	mac = priv->static_config.tables[BLK_IDX_MAC_CONFIG].entries;
 
 	/* Back up the dynamic link speed changed by sja1105_adjust_port_config
@@ -1373,6 +1378,12 @@ int sja1105_static_config_reload(struct sja1105_private *priv,
 		mac[i].speed = SJA1105_SPEED_AUTO;
 	}
 
+	/* Capture the FDB before it is lost to the reset */
+	sja1105_devlink_snapshot_l2_lookup(priv);
+
+	/* The port counters are cleared by the reset */
+	dsa_stats_hw_reset_begin(ds);
+
 	/* No PTP operations can run right now */
 	mutex_lock(&priv->ptp_data.lock);
 
@@ -1385,6 +1396,8 @@ int sja1105_static_config_reload(struct sja1105_private *priv,
 	if (rc < 0)
 		goto out_unlock_ptp;
 
+	cleared = true;
+
 	rc = __sja1105_ptp_settime(ds, 0, &ptp_sts_after);
 	if (rc < 0)
 		goto out_unlock_ptp;
@@ -1405,6 +1418,8 @@ int sja1105_static_config_reload(struct sja1105_private *priv,
 out_unlock_ptp:
 	mutex_unlock(&priv->ptp_data.lock);
 
+	dsa_stats_hw_reset_end(ds, cleared);
+
 	dev_info(priv->ds->dev,
 		 "Reset switch and programmed static config. Reason: %s\n",
 		 sja1105_reset_reasons[reason]);
@@ -1560,6 +1575,13 @@ static int sja1105_vlan_filtering(struct dsa_switch *ds, int port, bool enabled)
 	u16 tpid, tpid2;
 	int rc;
 
+	/* The keys of the virtual links depend on the VLAN awareness */
+	if (!list_empty(&priv->flow_block.rules)) {
+		dev_err(ds->dev,
+			"Cannot change VLAN filtering with flower rules installed\n");
+		return -EBUSY;
+	}
+
 	if (enabled) {
 		/* Enable VLAN filtering. */
 		tpid  = ETH_P_8021Q;
@@ -1698,6 +1720,12 @@ static int sja1105_setup(struct dsa_switch *ds)
 		dev_err(ds->dev, "Failed to register PTP clock: %d\n", rc);
 		return rc;
 	}
+
+	rc = sja1105_devlink_setup(ds);
+	if (rc < 0) {
+		dev_err(ds->dev, "Failed to set up devlink: %d\n", rc);
+		return rc;
+	}
 	/* Create and send configuration down to device */
 	rc = sja1105_static_config_load(priv, ports);
 	if (rc < 0) {
@@ -1710,6 +1738,13 @@ static int sja1105_setup(struct dsa_switch *ds)
 		dev_err(ds->dev, "Failed to configure MII clocking: %d\n", rc);
 		return rc;
 	}
+
+	rc = sja1105_stats_register(ds);
+	if (rc < 0) {
+		dev_err(ds->dev, "Failed to register port counters: %d\n", rc);
+		return rc;
+	}
+
 	/* On SJA1105, VLAN filtering per se is always enabled in hardware.
 	 * The only thing we can do to disable it is lie about what the 802.1Q
 	 * EtherType is.
@@ -1727,7 +1762,13 @@ static int sja1105_setup(struct dsa_switch *ds)
 	 * default, and that means vlan_filtering is 0 since they're not under
 	 * a bridge, so it's safe to set up switch tagging at this time.
 	 */
-	return sja1105_setup_8021q_tagging(ds, true);
+	rc = sja1105_setup_8021q_tagging(ds, true);
+	if (rc < 0) {
+		dev_err(ds->dev, "Failed to set up 8021q tagging: %d\n", rc);
+		dsa_stats_unregister(ds);
+	}
+
+	return rc;
 }
 
 static void sja1105_teardown(struct dsa_switch *ds)
@@ -1744,7 +1785,10 @@ static void sja1105_teardown(struct dsa_switch *ds)
 		kthread_destroy_worker(sp->xmit_worker);
 	}
 
+	sja1105_flower_teardown(ds);
 	sja1105_tas_teardown(ds);
+	dsa_stats_unregister(ds);
+	sja1105_devlink_teardown(ds);
 	sja1105_ptp_clock_unregister(ds);
 	sja1105_static_config_free(&priv->static_config);
 }
@@ -1764,16 +1808,41 @@ static int sja1105_port_enable(struct dsa_switch *ds, int port,
 	return 0;
 }
 
-static void sja1105_port_disable(struct dsa_switch *ds, int port)
+/* Wait until the switch has processed the frame that matched the management
+ * route in @slot.
+ */
+static void sja1105_mgmt_route_wait(struct sja1105_private *priv, int slot)
 {
-	struct sja1105_private *priv = ds->priv;
-	struct sja1105_port *sp = &priv->ports[port];
+	struct sja1105_mgmt_entry mgmt_route = {0};
+	int timeout = 10;
+	int rc;
 
-	if (!dsa_is_user_port(ds, port))
-		return;
+	do {
+		rc = sja1105_dynamic_config_read(priv, BLK_IDX_MGMT_ROUTE,
+						 slot, &mgmt_route);
+		if (rc < 0) {
+			dev_err_ratelimited(priv->ds->dev,
+					    "failed to poll for mgmt route\n");
+			continue;
+		}
 
-	kthread_cancel_work_sync(&sp->xmit_work);
-	skb_queue_purge(&sp->xmit_queue);
+		/* UM10944: The ENFPORT flag of the respective entry is
+		 * cleared when a match is found. The host can use this
+		 * flag as an acknowledgment.
+		 */
+		cpu_relax();
+	} while (mgmt_route.enfport && --timeout);
+
+	if (!timeout) {
+		/* Clean up the management route so that a follow-up
+		 * frame may not match on it by mistake.
+		 * This is only hardware supported on P/Q/R/S - on E/T it is
+		 * a no-op and we are silently discarding the -EOPNOTSUPP.
+		 */
+		sja1105_dynamic_config_write(priv, BLK_IDX_MGMT_ROUTE,
+					     slot, &mgmt_route, false);
+		dev_err_ratelimited(priv->ds->dev, "xmit timed out\n");
+	}
 }
 
 static int sja1105_mgmt_xmit(struct dsa_switch *ds, int port, int slot,
@@ -1782,7 +1851,6 @@ static int sja1105_mgmt_xmit(struct dsa_switch *ds, int port, int slot,
 	struct sja1105_mgmt_entry mgmt_route = {0};
 	struct sja1105_private *priv = ds->priv;
 	struct ethhdr *hdr;
-	int timeout = 10;
 	int rc;
 
 	hdr = eth_hdr(skb);
@@ -1803,39 +1871,168 @@ static int sja1105_mgmt_xmit(struct dsa_switch *ds, int port, int slot,
 	/* Transfer skb to the host port. */
 	dsa_enqueue_skb(skb, dsa_to_port(ds, port)->slave);
 
-	/* Wait until the switch has processed the frame */
-	do {
-		rc = sja1105_dynamic_config_read(priv, BLK_IDX_MGMT_ROUTE,
-						 slot, &mgmt_route);
-		if (rc < 0) {
-			dev_err_ratelimited(priv->ds->dev,
-					    "failed to poll for mgmt route\n");
-			continue;
-		}
+	sja1105_mgmt_route_wait(priv, slot);
 
-		/* UM10944: The ENFPORT flag of the respective entry is
-		 * cleared when a match is found. The host can use this
-		 * flag as an acknowledgment.
-		 */
-		cpu_relax();
-	} while (mgmt_route.enfport && --timeout);
+	return NETDEV_TX_OK;
+}
 
-	if (!timeout) {
-		/* Clean up the management route so that a follow-up
-		 * frame may not match on it by mistake.
-		 * This is only hardware supported on P/Q/R/S - on E/T it is
-		 * a no-op and we are silently discarding the -EOPNOTSUPP.
-		 */
+/* Sticky management routes.
+ *
+ * Management routes are consumed by the first frame that matches them, and
+ * installing one requires a sleepable SPI transfer. So by default, every
+ * link-local frame is deferred to the xmit kthread of its port, which
+ * installs a route in slot 0 and only then sends the frame.
+ *
+ * For the common PTP destinations, the driver additionally keeps a route
+ * armed (in slot 1 + index of the sticky route) towards the port that last
+ * sent to that DMAC. The tagger consumes it from ndo_start_xmit context and
+ * sends the frame right away, deferring to the kthread only the wait for the
+ * switch to process the frame, the collection of the TX timestamp and the
+ * re-arming of the route.
+ *
+ * To avoid ambiguity in the hardware lookup, no two management routes ever
+ * have the same DMAC: the sticky route is taken down before a frame to its
+ * DMAC is sent through slot 0. This requires deleting management routes,
+ * which is only possible on P/Q/R/S. Sticky routes always take a timestamp
+ * into TSREG 1, so they don't clobber the one of slot 0 (TSREG 0), and the
+ * tagger never consumes two sticky routes of the same port at once.
+ *
+ * Transitions of route->state (and route->port) out of ARMED are protected
+ * by tagger_data->sticky_lock, all other route operations by mgmt_lock.
+ */
+static const u64 sja1105_sticky_dmacs[SJA1105_NUM_STICKY_ROUTES] = {
+	SJA1105_LINKLOCAL_FILTER_B,
+	SJA1105_PTP_PDELAY_DMAC,
+};
+
+static int sja1105_sticky_route_slot(struct sja1105_private *priv,
+				     struct sja1105_sticky_route *route)
+{
+	return 1 + (route - priv->tagger_data.sticky_routes);
+}
+
+static struct sja1105_sticky_route *
+sja1105_sticky_route_find(struct sja1105_private *priv, u64 dmac)
+{
+	struct sja1105_tagger_data *tagger_data = &priv->tagger_data;
+	int i;
+
+	if (!priv->sticky_routes_en)
+		return NULL;
+
+	for (i = 0; i < SJA1105_NUM_STICKY_ROUTES; i++)
+		if (tagger_data->sticky_routes[i].dmac == dmac)
+			return &tagger_data->sticky_routes[i];
+
+	return NULL;
+}
+
+/* Caller must hold mgmt_lock. Brings the route back to the IDLE state, by
+ * either taking it out of hardware if still armed, or by completing the
+ * transmission of the frame that consumed it.
+ */
+static void sja1105_sticky_route_settle(struct sja1105_private *priv,
+					struct sja1105_sticky_route *route)
+{
+	struct sja1105_tagger_data *tagger_data = &priv->tagger_data;
+	int slot = sja1105_sticky_route_slot(priv, route);
+	struct sja1105_mgmt_entry mgmt_route = {0};
+	enum sja1105_sticky_route_state state;
+	struct sk_buff *clone;
+
+	spin_lock_bh(&tagger_data->sticky_lock);
+	state = route->state;
+	clone = route->clone;
+	route->state = SJA1105_STICKY_ROUTE_IDLE;
+	route->clone = NULL;
+	spin_unlock_bh(&tagger_data->sticky_lock);
+
+	switch (state) {
+	case SJA1105_STICKY_ROUTE_ARMED:
 		sja1105_dynamic_config_write(priv, BLK_IDX_MGMT_ROUTE,
 					     slot, &mgmt_route, false);
-		dev_err_ratelimited(priv->ds->dev, "xmit timed out\n");
+		break;
+	case SJA1105_STICKY_ROUTE_INFLIGHT:
+		sja1105_mgmt_route_wait(priv, slot);
+		if (clone)
+			sja1105_ptp_txtstamp_skb(priv->ds, route->port, 1,
+						 clone);
+		break;
+	default:
+		break;
 	}
+}
 
-	return NETDEV_TX_OK;
+/* Caller must hold mgmt_lock, and the route must be IDLE */
+static void sja1105_sticky_route_arm(struct sja1105_private *priv,
+				     struct sja1105_sticky_route *route,
+				     int port)
+{
+	struct sja1105_tagger_data *tagger_data = &priv->tagger_data;
+	int slot = sja1105_sticky_route_slot(priv, route);
+	struct sja1105_mgmt_entry mgmt_route = {0};
+	int rc;
+
+	mgmt_route.macaddr = route->dmac;
+	mgmt_route.destports = BIT(port);
+	mgmt_route.enfport = 1;
+	mgmt_route.tsreg = 1;
+	mgmt_route.takets = true;
+
+	rc = sja1105_dynamic_config_write(priv, BLK_IDX_MGMT_ROUTE,
+					  slot, &mgmt_route, true);
+	if (rc < 0) {
+		dev_err_ratelimited(priv->ds->dev,
+				    "failed to arm mgmt route: %d\n", rc);
+		return;
+	}
+
+	spin_lock_bh(&tagger_data->sticky_lock);
+	route->port = port;
+	route->state = SJA1105_STICKY_ROUTE_ARMED;
+	spin_unlock_bh(&tagger_data->sticky_lock);
+}
+
+/* Caller must hold mgmt_lock. Used when the hardware routes are lost or the
+ * port goes away: a negative @port means all routes.
+ */
+void sja1105_sticky_routes_flush(struct sja1105_private *priv, int port)
+{
+	struct sja1105_tagger_data *tagger_data = &priv->tagger_data;
+	int i;
+
+	for (i = 0; i < SJA1105_NUM_STICKY_ROUTES; i++) {
+		struct sja1105_sticky_route *route;
+
+		route = &tagger_data->sticky_routes[i];
+		if (port >= 0 && route->port != port)
+			continue;
+
+		sja1105_sticky_route_settle(priv, route);
+	}
+}
+
+static void sja1105_sticky_routes_init(struct sja1105_private *priv)
+{
+	struct sja1105_tagger_data *tagger_data = &priv->tagger_data;
+	int i;
+
+	spin_lock_init(&tagger_data->sticky_lock);
+
+	for (i = 0; i < SJA1105_NUM_STICKY_ROUTES; i++) {
+		tagger_data->sticky_routes[i].dmac = sja1105_sticky_dmacs[i];
+		tagger_data->sticky_routes[i].port = -1;
+	}
+
+	/* There is no way to take an armed route out of hardware on E/T */
+	priv->sticky_routes_en = (priv->info->device_id != SJA1105E_DEVICE_ID &&
+				  priv->info->device_id != SJA1105T_DEVICE_ID);
 }
 
 #define work_to_port(work) \
 		container_of((work), struct sja1105_port, xmit_work)
+#define rearm_work_to_port(work) \
+		container_of((work), struct sja1105_port, rearm_work)
 #define tagger_to_sja1105(t) \
 		container_of((t), struct sja1105_private, tagger_data)
 
@@ -1853,19 +2050,80 @@ static void sja1105_port_deferred_xmit(struct kthread_work *work)
 
 	while ((skb = skb_dequeue(&sp->xmit_queue)) != NULL) {
 		struct sk_buff *clone = DSA_SKB_CB(skb)->clone;
+		struct sja1105_sticky_route *route;
+
+		route = sja1105_sticky_route_find(priv,
+				ether_addr_to_u64(eth_hdr(skb)->h_dest));
 
 		mutex_lock(&priv->mgmt_lock);
 
+		if (route)
+			sja1105_sticky_route_settle(priv, route);
+
 		sja1105_mgmt_xmit(priv->ds, port, 0, skb, !!clone);
 
 		/* The clone, if there, was made by dsa_skb_tx_timestamp */
 		if (clone)
-			sja1105_ptp_txtstamp_skb(priv->ds, port, clone);
+			sja1105_ptp_txtstamp_skb(priv->ds, port, 0, clone);
+
+		/* Follow-up frames to this DMAC and port can skip the
+		 * deferred path.
+		 */
+		if (route)
+			sja1105_sticky_route_arm(priv, route, port);
 
 		mutex_unlock(&priv->mgmt_lock);
 	}
 }
 
+/* Completes the transmission of frames sent by the tagger through sticky
+ * routes of this port, and arms the routes again.
+ */
+static void sja1105_port_sticky_rearm(struct kthread_work *work)
+{
+	struct sja1105_port *sp = rearm_work_to_port(work);
+	struct sja1105_tagger_data *tagger_data = sp->data;
+	struct sja1105_private *priv = tagger_to_sja1105(tagger_data);
+	int port = sp - priv->ports;
+	int i;
+
+	mutex_lock(&priv->mgmt_lock);
+
+	for (i = 0; i < SJA1105_NUM_STICKY_ROUTES; i++) {
+		struct sja1105_sticky_route *route;
+
+		route = &tagger_data->sticky_routes[i];
+		/* Only the tagger can change the state of an armed route,
+		 * everything else is serialized by mgmt_lock.
+		 */
+		if (READ_ONCE(route->state) != SJA1105_STICKY_ROUTE_INFLIGHT ||
+		    route->port != port)
+			continue;
+
+		sja1105_sticky_route_settle(priv, route);
+		sja1105_sticky_route_arm(priv, route, port);
+	}
+
+	mutex_unlock(&priv->mgmt_lock);
+}
+
+static void sja1105_port_disable(struct dsa_switch *ds, int port)
+{
+	struct sja1105_private *priv = ds->priv;
+	struct sja1105_port *sp = &priv->ports[port];
+
+	if (!dsa_is_user_port(ds, port))
+		return;
+
+	kthread_cancel_work_sync(&sp->xmit_work);
+	kthread_cancel_work_sync(&sp->rearm_work);
+	skb_queue_purge(&sp->xmit_queue);
+
+	mutex_lock(&priv->mgmt_lock);
+	sja1105_sticky_routes_flush(priv, port);
+	mutex_unlock(&priv->mgmt_lock);
+}
+
 /* The MAXAGE setting belongs to the L2 Forwarding Parameters table,
  * which cannot be reconfigured at runtime. So a switch reset is required.
  */
@@ -1989,9 +2247,9 @@ static const struct dsa_switch_ops sja1105_switch_ops = {
 	.phylink_mac_config	= sja1105_mac_config,
 	.phylink_mac_link_up	= sja1105_mac_link_up,
 	.phylink_mac_link_down	= sja1105_mac_link_down,
-	.get_strings		= sja1105_get_strings,
-	.get_ethtool_stats	= sja1105_get_ethtool_stats,
-	.get_sset_count		= sja1105_get_sset_count,
+	.get_strings		= dsa_stats_get_strings,
+	.get_ethtool_stats	= dsa_stats_get_ethtool_stats,
+	.get_sset_count		= dsa_stats_get_sset_count,
 	.get_ts_info		= sja1105_get_ts_info,
 	.port_enable		= sja1105_port_enable,
 	.port_disable		= sja1105_port_disable,
@@ -2013,8 +2271,12 @@ static const struct dsa_switch_ops sja1105_switch_ops = {
 	.port_rxtstamp		= sja1105_port_rxtstamp,
 	.port_txtstamp		= sja1105_port_txtstamp,
 	.port_setup_tc		= sja1105_port_setup_tc,
+	.cls_flower_add		= sja1105_cls_flower_add,
+	.cls_flower_del		= sja1105_cls_flower_del,
 	.port_mirror_add	= sja1105_mirror_add,
 	.port_mirror_del	= sja1105_mirror_del,
+	.devlink_param_get	= sja1105_devlink_param_get,
+	.devlink_param_set	= sja1105_devlink_param_set,
 };
 
 static int sja1105_check_device_id(struct sja1105_private *priv)
@@ -2118,7 +2380,10 @@ static int sja1105_probe(struct spi_device *spi)
 	mutex_init(&priv->ptp_data.lock);
 	mutex_init(&priv->mgmt_lock);
 
+	sja1105_sticky_routes_init(priv);
+
 	sja1105_tas_setup(ds);
+	sja1105_flower_setup(ds);
 
 	rc = dsa_register_switch(priv->ds);
 	if (rc)
@@ -2138,6 +2403,7 @@ static int sja1105_probe(struct spi_device *spi)
 		sp->data = tagger_data;
 		slave = dp->slave;
 		kthread_init_work(&sp->xmit_work, sja1105_port_deferred_xmit);
+		kthread_init_work(&sp->rearm_work, sja1105_port_sticky_rearm);
 		sp->xmit_worker = kthread_create_worker(0, "%s_xmit",
 							slave->name);
 		if (IS_ERR(sp->xmit_worker)) {
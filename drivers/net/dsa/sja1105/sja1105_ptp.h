@@ -51,7 +51,7 @@ void sja1105pqrs_ptp_cmd_packing(u8 *buf, struct sja1105_ptp_cmd *cmd,
 int sja1105_get_ts_info(struct dsa_switch *ds, int port,
 			struct ethtool_ts_info *ts);
 
-void sja1105_ptp_txtstamp_skb(struct dsa_switch *ds, int slot,
+void sja1105_ptp_txtstamp_skb(struct dsa_switch *ds, int port, int tsreg,
 			      struct sk_buff *clone);
 
 bool sja1105_port_rxtstamp(struct dsa_switch *ds, int port,
@@ -94,8 +94,8 @@ static inline int sja1105_ptp_clock_register(struct dsa_switch *ds)
 
 static inline void sja1105_ptp_clock_unregister(struct dsa_switch *ds) { }
 
-static inline void sja1105_ptp_txtstamp_skb(struct dsa_switch *ds, int slot,
-					    struct sk_buff *clone)
+static inline void sja1105_ptp_txtstamp_skb(struct dsa_switch *ds, int port,
+					    int tsreg, struct sk_buff *clone)
 {
 }
 
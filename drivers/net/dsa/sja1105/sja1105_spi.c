@@ -429,6 +429,8 @@ int sja1105_static_config_upload(struct sja1105_private *priv)
 		dev_info(dev, "Succeeded after %d tried\n", RETRIES - retries);
 	}
 
+	sja1105_devlink_snapshot_static_config(priv, config_buf, buf_len);
+
 out:
 	kfree(config_buf);
 	return rc;
@@ -263,8 +263,12 @@ static irqreturn_t enetc_msix(int irq, void *data)
 	struct enetc_int_vector	*v = data;
 	int i;
 
+	v->irq_ts = ktime_get_ns();
+
 	/* disable interrupts */
 	enetc_wr_reg(v->rbier, 0);
+	if (v->rx_ictt)
+		enetc_wr_reg(v->ricr1, v->rx_ictt);
 
 	for_each_set_bit(i, &v->tx_rings_map, v->count_tx_rings)
 		enetc_wr_reg(v->tbier_base + ENETC_BDR_OFF(i), 0);
@@ -278,19 +282,60 @@ static bool enetc_clean_tx_ring(struct enetc_bdr *tx_ring, int napi_budget);
 static int enetc_clean_rx_ring(struct enetc_bdr *rx_ring,
 			       struct napi_struct *napi, int work_limit);
 
+static void enetc_rx_dim_work(struct work_struct *w)
+{
+	struct dim *dim = container_of(w, struct dim, work);
+	struct enetc_int_vector *v =
+		container_of(dim, struct enetc_int_vector, rx_dim);
+	struct enetc_ndev_priv *priv = netdev_priv(v->rx_ring.ndev);
+	struct dim_cq_moder moder;
+	u8 mode;
+
+	/* The CQE based profiles top out at a much lower coalescing time,
+	 * so prefer them while the port runs a time-aware schedule.
+	 */
+	if (priv->active_offloads & ENETC_F_QBV)
+		mode = DIM_CQ_PERIOD_MODE_START_FROM_CQE;
+	else
+		mode = DIM_CQ_PERIOD_MODE_START_FROM_EQE;
+
+	moder = net_dim_get_rx_moderation(mode, dim->profile_ix);
+	v->rx_ictt = enetc_usecs_to_cycles(moder.usec);
+	dim->state = DIM_START_MEASURE;
+}
+
+static void enetc_rx_net_dim(struct enetc_int_vector *v)
+{
+	struct dim_sample dim_sample;
+
+	v->comp_cnt++;
+
+	dim_update_sample(v->comp_cnt, v->rx_ring.stats.packets,
+			  v->rx_ring.stats.bytes, &dim_sample);
+	net_dim(&v->rx_dim, dim_sample);
+}
+
 static int enetc_poll(struct napi_struct *napi, int budget)
 {
 	struct enetc_int_vector
 		*v = container_of(napi, struct enetc_int_vector, napi);
+	bool rx_first = READ_ONCE(v->rx_prio);
 	bool complete = true;
-	int work_done;
+	int work_done = 0;
 	int i;
 
+	/* Time-critical traffic is steered to this ring, don't make it wait
+	 * for up to ENETC_DEFAULT_TX_WORK confirmations per Tx ring.
+	 */
+	if (rx_first)
+		work_done = enetc_clean_rx_ring(&v->rx_ring, napi, budget);
+
 	for (i = 0; i < v->count_tx_rings; i++)
 		if (!enetc_clean_tx_ring(&v->tx_ring[i], budget))
 			complete = false;
 
-	work_done = enetc_clean_rx_ring(&v->rx_ring, napi, budget);
+	if (!rx_first)
+		work_done = enetc_clean_rx_ring(&v->rx_ring, napi, budget);
 	if (work_done == budget)
 		complete = false;
 
@@ -299,6 +344,9 @@ static int enetc_poll(struct napi_struct *napi, int budget)
 
 	napi_complete_done(napi, work_done);
 
+	if (likely(v->rx_dim_en))
+		enetc_rx_net_dim(v);
+
 	/* enable interrupts */
 	enetc_wr_reg(v->rbier, ENETC_RBIER_RXTIE);
 
@@ -631,6 +679,19 @@ static void enetc_add_rx_buff_to_skb(struct enetc_bdr *rx_ring, int i,
 	enetc_put_rx_buff(rx_ring, rx_swbd);
 }
 
+static void enetc_rx_latency_update(struct enetc_bdr *rx_ring)
+{
+	struct enetc_int_vector *v =
+		container_of(rx_ring, struct enetc_int_vector, rx_ring);
+	struct enetc_ring_stats *stats = &rx_ring->stats;
+	u64 lat = ktime_get_ns() - v->irq_ts;
+
+	stats->lat_polls++;
+	stats->lat_total_ns += lat;
+	if (lat > stats->lat_max_ns)
+		stats->lat_max_ns = min_t(u64, lat, U32_MAX);
+}
+
 #define ENETC_RXBD_BUNDLE 16 /* # of BDs to update at once */
 
 static int enetc_clean_rx_ring(struct enetc_bdr *rx_ring,
@@ -732,6 +793,9 @@ static int enetc_clean_rx_ring(struct enetc_bdr *rx_ring,
 	rx_ring->stats.packets += rx_frm_cnt;
 	rx_ring->stats.bytes += rx_byte_cnt;
 
+	if (rx_frm_cnt)
+		enetc_rx_latency_update(rx_ring);
+
 	return rx_frm_cnt;
 }
 
@@ -974,8 +1038,18 @@ static int enetc_alloc_cbdr(struct device *dev, struct enetc_cbdr *cbdr)
 		return -EINVAL;
 	}
 
+	/* Page aligned, which covers the 64B alignment of all payloads */
+	cbdr->data = dma_alloc_coherent(dev, ENETC_CBDR_DATA_SIZE,
+					&cbdr->data_dma, GFP_KERNEL);
+	if (!cbdr->data) {
+		dma_free_coherent(dev, size, cbdr->bd_base, cbdr->bd_dma_base);
+		return -ENOMEM;
+	}
+
 	cbdr->next_to_clean = 0;
 	cbdr->next_to_use = 0;
+	spin_lock_init(&cbdr->lock);
+	mutex_init(&cbdr->data_lock);
 
 	return 0;
 }
@@ -984,6 +1058,11 @@ static void enetc_free_cbdr(struct device *dev, struct enetc_cbdr *cbdr)
 {
 	int size = cbdr->bd_count * sizeof(struct enetc_cbd);
 
+	dma_free_coherent(dev, ENETC_CBDR_DATA_SIZE, cbdr->data,
+			  cbdr->data_dma);
+	cbdr->data = NULL;
+	mutex_destroy(&cbdr->data_lock);
+
 	dma_free_coherent(dev, size, cbdr->bd_base, cbdr->bd_dma_base);
 	cbdr->bd_base = NULL;
 }
@@ -1064,6 +1143,10 @@ void enetc_init_si_rings_params(struct enetc_ndev_priv *priv)
 	priv->tx_bd_count = ENETC_BDR_DEFAULT_SIZE;
 	priv->rx_bd_count = ENETC_BDR_DEFAULT_SIZE;
 
+	/* adaptive Rx and fixed Tx interrupt coalescing by default */
+	priv->ic_mode = ENETC_IC_RX_ADAPTIVE | ENETC_IC_TX_MANUAL;
+	priv->tx_ictt = ENETC_TXIC_TIMETHR;
+
 	/* Enable all available TX rings in order to configure as many
 	 * priorities as possible, when needed.
 	 * TODO: Make # of TX rings run-time configurable
@@ -1119,8 +1202,9 @@ void enetc_free_si_resources(struct enetc_ndev_priv *priv)
 
 static void enetc_setup_txbdr(struct enetc_hw *hw, struct enetc_bdr *tx_ring)
 {
+	struct enetc_ndev_priv *priv = netdev_priv(tx_ring->ndev);
 	int idx = tx_ring->index;
-	u32 tbmr;
+	u32 tbmr, icpt;
 
 	enetc_txbdr_wr(hw, idx, ENETC_TBBAR0,
 		       lower_32_bits(tx_ring->bd_dma_base));
@@ -1136,8 +1220,14 @@ static void enetc_setup_txbdr(struct enetc_hw *hw, struct enetc_bdr *tx_ring)
 	tx_ring->next_to_use = enetc_txbdr_rd(hw, idx, ENETC_TBPIR);
 	tx_ring->next_to_clean = enetc_txbdr_rd(hw, idx, ENETC_TBCIR);
 
-	/* enable Tx ints by setting pkt thr to 1 */
-	enetc_txbdr_wr(hw, idx, ENETC_TBICIR0, ENETC_TBICIR0_ICEN | 0x1);
+	if (priv->ic_mode & ENETC_IC_TX_MANUAL) {
+		enetc_txbdr_wr(hw, idx, ENETC_TBICIR1, priv->tx_ictt);
+		icpt = ENETC_TXIC_PKTTHR;
+	} else {
+		/* interrupt on every frame */
+		icpt = 0x1;
+	}
+	enetc_txbdr_wr(hw, idx, ENETC_TBICIR0, ENETC_TBICIR0_ICEN | icpt);
 
 	tbmr = ENETC_TBMR_EN;
 	if (tx_ring->ndev->features & NETIF_F_HW_VLAN_CTAG_TX)
@@ -1153,8 +1243,11 @@ static void enetc_setup_txbdr(struct enetc_hw *hw, struct enetc_bdr *tx_ring)
 
 static void enetc_setup_rxbdr(struct enetc_hw *hw, struct enetc_bdr *rx_ring)
 {
+	struct enetc_ndev_priv *priv = netdev_priv(rx_ring->ndev);
+	struct enetc_int_vector *v =
+		container_of(rx_ring, struct enetc_int_vector, rx_ring);
 	int idx = rx_ring->index;
-	u32 rbmr;
+	u32 rbmr, icpt;
 
 	enetc_rxbdr_wr(hw, idx, ENETC_RBBAR0,
 		       lower_32_bits(rx_ring->bd_dma_base));
@@ -1170,8 +1263,15 @@ static void enetc_setup_rxbdr(struct enetc_hw *hw, struct enetc_bdr *rx_ring)
 
 	enetc_rxbdr_wr(hw, idx, ENETC_RBPIR, 0);
 
-	/* enable Rx ints by setting pkt thr to 1 */
-	enetc_rxbdr_wr(hw, idx, ENETC_RBICIR0, ENETC_RBICIR0_ICEN | 0x1);
+	if (priv->ic_mode & (ENETC_IC_RX_MANUAL | ENETC_IC_RX_ADAPTIVE)) {
+		/* in adaptive mode, the IRQ handler keeps updating this */
+		enetc_rxbdr_wr(hw, idx, ENETC_RBICIR1, v->rx_ictt);
+		icpt = ENETC_RXIC_PKTTHR;
+	} else {
+		/* interrupt on every frame */
+		icpt = 0x1;
+	}
+	enetc_rxbdr_wr(hw, idx, ENETC_RBICIR0, ENETC_RBICIR0_ICEN | icpt);
 
 	rbmr = ENETC_RBMR_EN;
 #ifdef CONFIG_FSL_ENETC_HW_TIMESTAMPING
@@ -1263,6 +1363,7 @@ static int enetc_setup_irqs(struct enetc_ndev_priv *priv)
 
 		v->tbier_base = hw->reg + ENETC_BDR(TX, 0, ENETC_TBIER);
 		v->rbier = hw->reg + ENETC_BDR(RX, i, ENETC_RBIER);
+		v->ricr1 = hw->reg + ENETC_BDR(RX, i, ENETC_RBICIR1);
 
 		enetc_wr(hw, ENETC_SIMSIRRV(i), entry);
 
@@ -1440,6 +1541,7 @@ int enetc_close(struct net_device *ndev)
 	for (i = 0; i < priv->bdr_int_num; i++) {
 		napi_synchronize(&priv->int_vector[i]->napi);
 		napi_disable(&priv->int_vector[i]->napi);
+		cancel_work_sync(&priv->int_vector[i]->rx_dim.work);
 	}
 
 	enetc_disable_interrupts(priv);
@@ -1678,6 +1780,12 @@ int enetc_alloc_msix(struct enetc_ndev_priv *priv)
 
 		priv->int_vector[i] = v;
 
+		/* init defaults for adaptive IC */
+		if (priv->ic_mode & ENETC_IC_RX_ADAPTIVE) {
+			v->rx_ictt = 0x1;
+			v->rx_dim_en = true;
+		}
+		INIT_WORK(&v->rx_dim.work, enetc_rx_dim_work);
 		netif_napi_add(priv->ndev, &v->napi, enetc_poll,
 			       NAPI_POLL_WEIGHT);
 		v->count_tx_rings = v_tx_rings;
@@ -10,6 +10,8 @@
 #include <linux/ethtool.h>
 #include <linux/if_vlan.h>
 #include <linux/phy.h>
+#include <linux/sizes.h>
+#include <linux/dim.h>
 
 #include "enetc_hw.h"
 
@@ -42,6 +44,12 @@ struct enetc_ring_stats {
 	unsigned int packets;
 	unsigned int bytes;
 	unsigned int rx_alloc_errs;
+	/* Rx: time from the interrupt to the last frame handed to the stack,
+	 * per NAPI poll
+	 */
+	unsigned int lat_polls;
+	unsigned int lat_max_ns;
+	u64 lat_total_ns;
 };
 
 #define ENETC_BDR_DEFAULT_SIZE	1024
@@ -91,6 +99,7 @@ static inline int enetc_bd_unused(struct enetc_bdr *bdr)
 
 /* Control BD ring */
 #define ENETC_CBDR_DEFAULT_SIZE	64
+#define ENETC_CBDR_DATA_SIZE	SZ_4K
 struct enetc_cbdr {
 	void *bd_base; /* points to Rx or Tx BD ring */
 	void __iomem *pir;
@@ -101,6 +110,14 @@ struct enetc_cbdr {
 	int next_to_clean;
 
 	dma_addr_t bd_dma_base;
+	/* serializes command submission, which may happen in atomic context */
+	spinlock_t lock;
+
+	/* preallocated, coherent area for command payloads */
+	void *data;
+	dma_addr_t data_dma;
+	/* held by the command which currently owns the data area */
+	struct mutex data_lock;
 };
 
 #define ENETC_TXBD(BDR, i) (&(((union enetc_tx_bd *)((BDR).bd_base))[i]))
@@ -157,9 +174,16 @@ static inline bool enetc_si_is_pf(struct enetc_si *si)
 struct enetc_int_vector {
 	void __iomem *rbier;
 	void __iomem *tbier_base;
+	void __iomem *ricr1;
 	unsigned long tx_rings_map;
 	int count_tx_rings;
+	u32 rx_ictt;
+	u16 comp_cnt;
+	bool rx_dim_en;
+	bool rx_prio; /* serve Rx before Tx confirmations */
+	u64 irq_ts;
 	struct napi_struct napi;
+	struct dim rx_dim;
 	char name[ENETC_INT_NAME_MAX];
 
 	struct enetc_bdr rx_ring ____cacheline_aligned_in_smp;
@@ -180,6 +204,31 @@ enum enetc_active_offloads {
 	ENETC_F_QBV             = BIT(2),
 };
 
+/* Interrupt coalescing modes */
+enum enetc_ic_mode {
+	/* one interrupt per frame */
+	ENETC_IC_NONE = 0,
+	/* activated when int coalescing time is set to a non-0 value */
+	ENETC_IC_RX_MANUAL = BIT(0),
+	ENETC_IC_TX_MANUAL = BIT(1),
+	/* use dynamic interrupt moderation */
+	ENETC_IC_RX_ADAPTIVE = BIT(2),
+};
+
+#define ENETC_RXIC_PKTTHR	min_t(u32, 256, ENETC_BDR_DEFAULT_SIZE / 2)
+#define ENETC_TXIC_PKTTHR	min_t(u32, 128, ENETC_BDR_DEFAULT_SIZE / 2)
+#define ENETC_TXIC_TIMETHR	enetc_usecs_to_cycles(600)
+
+static inline u32 enetc_usecs_to_cycles(u32 usecs)
+{
+	return (u32)div_u64(usecs * ENETC_CLK, 1000000ULL);
+}
+
+static inline u32 enetc_cycles_to_usecs(u32 cycles)
+{
+	return (u32)div_u64(cycles * 1000000ULL, ENETC_CLK);
+}
+
 struct enetc_ndev_priv {
 	struct net_device *ndev;
 	struct device *dev; /* dma-mapping device */
@@ -195,6 +244,9 @@ struct enetc_ndev_priv {
 
 	u32 speed; /* store speed for compare update pspeed */
 
+	int ic_mode;
+	u32 tx_ictt;
+
 	struct enetc_bdr *tx_ring[16];
 	struct enetc_bdr *rx_ring[16];
 
@@ -252,6 +304,10 @@ void enetc_set_rss_key(struct enetc_hw *hw, const u8 *bytes);
 int enetc_get_rss_table(struct enetc_si *si, u32 *table, int count);
 int enetc_set_rss_table(struct enetc_si *si, const u32 *table, int count);
 int enetc_send_cmd(struct enetc_si *si, struct enetc_cbd *cbd);
+void *enetc_cbd_alloc_data(struct enetc_si *si, struct enetc_cbd *cbd,
+			   int size, dma_addr_t *dma);
+void enetc_cbd_free_data(struct enetc_si *si, int size, void *data,
+			 dma_addr_t dma);
 
 #ifdef CONFIG_FSL_ENETC_QOS
 int enetc_setup_tc_taprio(struct net_device *ndev, void *type_data);
@@ -37,11 +37,13 @@ int enetc_send_cmd(struct enetc_si *si, struct enetc_cbd *cbd)
 	struct enetc_cbdr *ring = &si->cbd_ring;
 	int timeout = ENETC_CBDR_TIMEOUT;
 	struct enetc_cbd *dest_cbd;
-	int i;
+	int i, err = 0;
 
 	if (unlikely(!ring->bd_base))
 		return -EIO;
 
+	spin_lock_bh(&ring->lock);
+
 	if (unlikely(!enetc_cbd_unused(ring)))
 		enetc_clean_cbdr(si);
 
@@ -63,15 +65,67 @@ int enetc_send_cmd(struct enetc_si *si, struct enetc_cbd *cbd)
 		timeout -= 10;
 	} while (timeout);
 
-	if (!timeout)
-		return -EBUSY;
+	if (!timeout) {
+		err = -EBUSY;
+		goto out;
+	}
 
 	/* CBD may writeback data, feedback up level */
 	*cbd = *dest_cbd;
 
 	enetc_clean_cbdr(si);
+out:
+	spin_unlock_bh(&ring->lock);
+
+	return err;
+}
+
+/* Command payloads are normally placed in the data area which is allocated
+ * together with the ring. Being coherent, it needs no mapping or cache
+ * maintenance per command. Payloads which don't fit get a coherent buffer
+ * of their own. Either way, the buffer is page aligned and zeroed, and @cbd
+ * is pointed at it.
+ *
+ * The data area is owned by the caller until enetc_cbd_free_data(), so this
+ * may sleep, unlike enetc_send_cmd().
+ */
+void *enetc_cbd_alloc_data(struct enetc_si *si, struct enetc_cbd *cbd,
+			   int size, dma_addr_t *dma)
+{
+	struct enetc_cbdr *ring = &si->cbd_ring;
+	void *data;
+
+	mutex_lock(&ring->data_lock);
+
+	if (size <= ENETC_CBDR_DATA_SIZE) {
+		data = ring->data;
+		*dma = ring->data_dma;
+		memset(data, 0, size);
+	} else {
+		data = dma_alloc_coherent(&si->pdev->dev, size, dma,
+					  GFP_KERNEL);
+		if (!data) {
+			mutex_unlock(&ring->data_lock);
+			return NULL;
+		}
+	}
+
+	cbd->addr[0] = cpu_to_le32(lower_32_bits(*dma));
+	cbd->addr[1] = cpu_to_le32(upper_32_bits(*dma));
+	cbd->length = cpu_to_le16(size);
+
+	return data;
+}
+
+void enetc_cbd_free_data(struct enetc_si *si, int size, void *data,
+			 dma_addr_t dma)
+{
+	struct enetc_cbdr *ring = &si->cbd_ring;
 
-	return 0;
+	if (data != ring->data)
+		dma_free_coherent(&si->pdev->dev, size, data, dma);
+
+	mutex_unlock(&ring->data_lock);
 }
 
 int enetc_clear_mac_flt_entry(struct enetc_si *si, int index)
@@ -112,80 +166,64 @@ int enetc_set_mac_flt_entry(struct enetc_si *si, int index,
 	return enetc_send_cmd(si, &cbd);
 }
 
-#define RFSE_ALIGN	64
 /* Set entry in RFS table */
 int enetc_set_fs_entry(struct enetc_si *si, struct enetc_cmd_rfse *rfse,
 		       int index)
 {
 	struct enetc_cbd cbd = {.cmd = 0};
-	dma_addr_t dma, dma_align;
-	void *tmp, *tmp_align;
+	dma_addr_t dma;
+	void *tmp;
 	int err;
 
 	/* fill up the "set" descriptor */
 	cbd.cmd = 0;
 	cbd.cls = 4;
 	cbd.index = cpu_to_le16(index);
-	cbd.length = cpu_to_le16(sizeof(*rfse));
 	cbd.opt[3] = cpu_to_le32(0); /* SI */
 
-	tmp = dma_alloc_coherent(&si->pdev->dev, sizeof(*rfse) + RFSE_ALIGN,
-				 &dma, GFP_KERNEL);
+	tmp = enetc_cbd_alloc_data(si, &cbd, sizeof(*rfse), &dma);
 	if (!tmp) {
 		dev_err(&si->pdev->dev, "DMA mapping of RFS entry failed!\n");
 		return -ENOMEM;
 	}
 
-	dma_align = ALIGN(dma, RFSE_ALIGN);
-	tmp_align = PTR_ALIGN(tmp, RFSE_ALIGN);
-	memcpy(tmp_align, rfse, sizeof(*rfse));
-
-	cbd.addr[0] = cpu_to_le32(lower_32_bits(dma_align));
-	cbd.addr[1] = cpu_to_le32(upper_32_bits(dma_align));
+	memcpy(tmp, rfse, sizeof(*rfse));
 
 	err = enetc_send_cmd(si, &cbd);
 	if (err)
 		dev_err(&si->pdev->dev, "FS entry add failed (%d)!", err);
 
-	dma_free_coherent(&si->pdev->dev, sizeof(*rfse) + RFSE_ALIGN,
-			  tmp, dma);
+	enetc_cbd_free_data(si, sizeof(*rfse), tmp, dma);
 
 	return err;
 }
 
-#define RSSE_ALIGN	64
+#define RSSE_MIN_COUNT	64
 static int enetc_cmd_rss_table(struct enetc_si *si, u32 *table, int count,
 			       bool read)
 {
 	struct enetc_cbd cbd = {.cmd = 0};
-	dma_addr_t dma, dma_align;
-	u8 *tmp, *tmp_align;
+	dma_addr_t dma;
+	u8 *tmp;
 	int err, i;
 
-	if (count < RSSE_ALIGN)
+	if (count < RSSE_MIN_COUNT)
 		/* HW only takes in a full 64 entry table */
 		return -EINVAL;
 
-	tmp = dma_alloc_coherent(&si->pdev->dev, count + RSSE_ALIGN,
-				 &dma, GFP_KERNEL);
+	/* fill up the descriptor */
+	cbd.cmd = read ? 2 : 1;
+	cbd.cls = 3;
+
+	tmp = enetc_cbd_alloc_data(si, &cbd, count, &dma);
 	if (!tmp) {
 		dev_err(&si->pdev->dev, "DMA mapping of RSS table failed!\n");
 		return -ENOMEM;
 	}
-	dma_align = ALIGN(dma, RSSE_ALIGN);
-	tmp_align = PTR_ALIGN(tmp, RSSE_ALIGN);
 
 	if (!read)
 		for (i = 0; i < count; i++)
-			tmp_align[i] = (u8)(table[i]);
-
-	/* fill up the descriptor */
-	cbd.cmd = read ? 2 : 1;
-	cbd.cls = 3;
-	cbd.length = cpu_to_le16(count);
-
-	cbd.addr[0] = cpu_to_le32(lower_32_bits(dma_align));
-	cbd.addr[1] = cpu_to_le32(upper_32_bits(dma_align));
+			tmp[i] = (u8)(table[i]);
 
 	err = enetc_send_cmd(si, &cbd);
 	if (err)
@@ -193,9 +231,9 @@ static int enetc_cmd_rss_table(struct enetc_si *si, u32 *table, int count,
 
 	if (read)
 		for (i = 0; i < count; i++)
-			table[i] = tmp_align[i];
+			table[i] = tmp[i];
 
-	dma_free_coherent(&si->pdev->dev, count + RSSE_ALIGN, tmp, dma);
+	enetc_cbd_free_data(si, count, tmp, dma);
 
 	return err;
 }
@@ -186,6 +186,8 @@ static const struct {
 static const char rx_ring_stats[][ETH_GSTRING_LEN] = {
 	"Rx ring %2d frames",
 	"Rx ring %2d alloc errors",
+	"Rx ring %2d avg irq-to-stack ns",
+	"Rx ring %2d max irq-to-stack ns",
 };
 
 static const char tx_ring_stats[][ETH_GSTRING_LEN] = {
@@ -259,8 +261,13 @@ static void enetc_get_ethtool_stats(struct net_device *ndev,
 		data[o++] = priv->tx_ring[i]->stats.packets;
 
 	for (i = 0; i < priv->num_rx_rings; i++) {
-		data[o++] = priv->rx_ring[i]->stats.packets;
-		data[o++] = priv->rx_ring[i]->stats.rx_alloc_errs;
+		struct enetc_ring_stats *rs = &priv->rx_ring[i]->stats;
+
+		data[o++] = rs->packets;
+		data[o++] = rs->rx_alloc_errs;
+		data[o++] = rs->lat_polls ?
+			    div_u64(rs->lat_total_ns, rs->lat_polls) : 0;
+		data[o++] = rs->lat_max_ns;
 	}
 
 	if (!enetc_si_is_pf(priv->si))
@@ -371,6 +378,16 @@ static int enetc_set_cls_entry(struct enetc_si *si,
 		return -EOPNOTSUPP;
 	}
 
+	if (fs->flow_type & FLOW_EXT) {
+		/* only the VLAN TCI (and so, the PCP) can be matched on */
+		if (fs->m_ext.vlan_etype || fs->m_ext.data[0] ||
+		    fs->m_ext.data[1])
+			return -EOPNOTSUPP;
+
+		rfse.vlan_h = ntohs(fs->h_ext.vlan_tci);
+		rfse.vlan_m = ntohs(fs->m_ext.vlan_tci);
+	}
+
 	rfse.mode |= ENETC_RFSE_EN;
 	if (fs->ring_cookie != RX_CLS_FLOW_DISC) {
 		rfse.mode |= ENETC_RFSE_MODE_BD;
@@ -431,6 +448,33 @@ static int enetc_get_rxnfc(struct net_device *ndev, struct ethtool_rxnfc *rxnfc,
 	return 0;
 }
 
+/* Rings which rules steer traffic to by VLAN PCP are assumed to carry
+ * time-critical traffic, so they get served first by their NAPI instance.
+ */
+static void enetc_update_rx_prio(struct enetc_ndev_priv *priv)
+{
+	unsigned long prio_rings = 0;
+	int i;
+
+	for (i = 0; i < priv->si->num_fs_entries; i++) {
+		struct ethtool_rx_flow_spec *fs = &priv->cls_rules[i].fs;
+
+		if (!priv->cls_rules[i].used || !(fs->flow_type & FLOW_EXT) ||
+		    fs->ring_cookie == RX_CLS_FLOW_DISC)
+			continue;
+
+		if (ntohs(fs->m_ext.vlan_tci) & VLAN_PRIO_MASK)
+			__set_bit(fs->ring_cookie, &prio_rings);
+	}
+
+	for (i = 0; i < priv->bdr_int_num; i++) {
+		struct enetc_int_vector *v = priv->int_vector[i];
+
+		WRITE_ONCE(v->rx_prio,
+			   test_bit(v->rx_ring.index, &prio_rings));
+	}
+}
+
 static int enetc_set_rxnfc(struct net_device *ndev, struct ethtool_rxnfc *rxnfc)
 {
 	struct enetc_ndev_priv *priv = netdev_priv(ndev);
@@ -450,6 +494,7 @@ static int enetc_set_rxnfc(struct net_device *ndev, struct ethtool_rxnfc *rxnfc)
 			return err;
 		priv->cls_rules[rxnfc->fs.location].fs = rxnfc->fs;
 		priv->cls_rules[rxnfc->fs.location].used = 1;
+		enetc_update_rx_prio(priv);
 		break;
 	case ETHTOOL_SRXCLSRLDEL:
 		if (rxnfc->fs.location >= priv->si->num_fs_entries)
@@ -459,6 +504,7 @@ static int enetc_set_rxnfc(struct net_device *ndev, struct ethtool_rxnfc *rxnfc)
 		if (err)
 			return err;
 		priv->cls_rules[rxnfc->fs.location].used = 0;
+		enetc_update_rx_prio(priv);
 		break;
 	default:
 		return -EOPNOTSUPP;
@@ -610,6 +656,74 @@ static int enetc_set_wol(struct net_device *dev,
 	return ret;
 }
 
+static int enetc_get_coalesce(struct net_device *ndev,
+			      struct ethtool_coalesce *ic)
+{
+	struct enetc_ndev_priv *priv = netdev_priv(ndev);
+	struct enetc_int_vector *v = priv->int_vector[0];
+
+	ic->tx_coalesce_usecs = enetc_cycles_to_usecs(priv->tx_ictt);
+	ic->rx_coalesce_usecs = enetc_cycles_to_usecs(v->rx_ictt);
+
+	ic->tx_max_coalesced_frames = ENETC_TXIC_PKTTHR;
+	ic->rx_max_coalesced_frames = ENETC_RXIC_PKTTHR;
+
+	ic->use_adaptive_rx_coalesce = priv->ic_mode & ENETC_IC_RX_ADAPTIVE;
+
+	return 0;
+}
+
+static int enetc_set_coalesce(struct net_device *ndev,
+			      struct ethtool_coalesce *ic)
+{
+	struct enetc_ndev_priv *priv = netdev_priv(ndev);
+	u32 rx_ictt, tx_ictt;
+	int i, ic_mode;
+	bool changed;
+
+	/* only the time thresholds are configurable */
+	if (ic->rx_max_coalesced_frames != ENETC_RXIC_PKTTHR ||
+	    ic->tx_max_coalesced_frames != ENETC_TXIC_PKTTHR ||
+	    ic->use_adaptive_tx_coalesce)
+		return -EOPNOTSUPP;
+
+	tx_ictt = enetc_usecs_to_cycles(ic->tx_coalesce_usecs);
+	rx_ictt = enetc_usecs_to_cycles(ic->rx_coalesce_usecs);
+
+	ic_mode = ENETC_IC_NONE;
+	if (ic->use_adaptive_rx_coalesce) {
+		ic_mode |= ENETC_IC_RX_ADAPTIVE;
+		rx_ictt = 0x1;
+	} else {
+		ic_mode |= rx_ictt > 1 ? ENETC_IC_RX_MANUAL : 0;
+	}
+
+	ic_mode |= tx_ictt > 1 ? ENETC_IC_TX_MANUAL : 0;
+
+	/* commit the settings */
+	changed = (ic_mode != priv->ic_mode) || (priv->tx_ictt != tx_ictt);
+
+	priv->ic_mode = ic_mode;
+	priv->tx_ictt = tx_ictt;
+
+	for (i = 0; i < priv->bdr_int_num; i++) {
+		struct enetc_int_vector *v = priv->int_vector[i];
+
+		v->rx_ictt = rx_ictt;
+		v->rx_dim_en = !!(ic_mode & ENETC_IC_RX_ADAPTIVE);
+	}
+
+	if (netif_running(ndev) && changed) {
+		/* the packet thresholds can only be changed while the rings
+		 * are disabled
+		 */
+		enetc_close(ndev);
+		return enetc_open(ndev);
+	}
+
+	return 0;
+}
+
 static const struct ethtool_ops enetc_pf_ethtool_ops = {
 	.get_regs_len = enetc_get_reglen,
 	.get_regs = enetc_get_regs,
@@ -623,6 +737,8 @@ static const struct ethtool_ops enetc_pf_ethtool_ops = {
 	.get_rxfh = enetc_get_rxfh,
 	.set_rxfh = enetc_set_rxfh,
 	.get_ringparam = enetc_get_ringparam,
+	.get_coalesce = enetc_get_coalesce,
+	.set_coalesce = enetc_set_coalesce,
 	.get_link_ksettings = phy_ethtool_get_link_ksettings,
 	.set_link_ksettings = phy_ethtool_set_link_ksettings,
 	.get_link = ethtool_op_get_link,
@@ -643,6 +759,8 @@ static const struct ethtool_ops enetc_vf_ethtool_ops = {
 	.get_rxfh = enetc_get_rxfh,
 	.set_rxfh = enetc_set_rxfh,
 	.get_ringparam = enetc_get_ringparam,
+	.get_coalesce = enetc_get_coalesce,
+	.set_coalesce = enetc_set_coalesce,
 	.get_link = ethtool_op_get_link,
 	.get_ts_info = enetc_get_ts_info,
 };
@@ -122,6 +122,7 @@ enum enetc_bdr_type {TX, RX};
 #define ENETC_RBIDR	0xa4
 #define ENETC_RBICIR0	0xa8
 #define ENETC_RBICIR0_ICEN	BIT(31)
+#define ENETC_RBICIR1	0xac
 
 /* TX BDR reg offsets */
 #define ENETC_TBMR	0
@@ -142,6 +143,7 @@ enum enetc_bdr_type {TX, RX};
 #define ENETC_TBIDR	0xa4
 #define ENETC_TBICIR0	0xa8
 #define ENETC_TBICIR0_ICEN	BIT(31)
+#define ENETC_TBICIR1	0xac
 
 #define ENETC_RTBLENR_LEN(n)	((n) & ~0x7)
 
@@ -280,6 +280,58 @@ static void gfar_configure_coalescing_all(struct gfar_private *priv)
 	gfar_configure_coalescing(priv, 0xFF, 0xFF);
 }
 
+static void gfar_rx_dim_work(struct work_struct *work)
+{
+	struct dim *dim = container_of(work, struct dim, work);
+	struct gfar_priv_grp *grp =
+		container_of(dim, struct gfar_priv_grp, rx_dim);
+	struct gfar_private *priv = grp->priv;
+	struct dim_cq_moder moder;
+	unsigned long rxic;
+	int i;
+
+	/* A reset or an ethtool change reprograms the registers itself. The
+	 * work can't just wait for it like they do, as stop_gfar() cancels
+	 * it with GFAR_RESETTING held.
+	 */
+	if (test_bit(GFAR_RESETTING, &priv->state))
+		goto out;
+
+	/* The coalescing timer ticks depend on the link speed */
+	if (!priv->rx_dim_en || test_bit(GFAR_DOWN, &priv->state) ||
+	    !priv->ndev->phydev)
+		goto out;
+
+	moder = net_dim_get_rx_moderation(dim->mode, dim->profile_ix);
+	rxic = mk_ic_value(min_t(u16, moder.pkts, GFAR_MAX_COAL_FRAMES),
+			   gfar_usecs2ticks(priv, moder.usec));
+
+	for_each_set_bit(i, &grp->rx_bit_map, priv->num_rx_queues) {
+		priv->rx_queue[i]->rxcoalescing = 1;
+		priv->rx_queue[i]->rxic = rxic;
+	}
+
+	gfar_configure_coalescing(priv, 0, grp->rx_bit_map);
+out:
+	dim->state = DIM_START_MEASURE;
+}
+
+static void gfar_rx_net_dim(struct gfar_priv_grp *grp)
+{
+	struct gfar_private *priv = grp->priv;
+	struct dim_sample dim_sample;
+	u64 packets = 0, bytes = 0;
+	int i;
+
+	for_each_set_bit(i, &grp->rx_bit_map, priv->num_rx_queues) {
+		packets += priv->rx_queue[i]->stats.rx_packets;
+		bytes += priv->rx_queue[i]->stats.rx_bytes;
+	}
+
+	dim_update_sample(++grp->rx_dim_events, packets, bytes, &dim_sample);
+	net_dim(&grp->rx_dim, dim_sample);
+}
+
 static struct net_device_stats *gfar_get_stats(struct net_device *dev)
 {
 	struct gfar_private *priv = netdev_priv(dev);
@@ -409,7 +461,6 @@ static int gfar_alloc_tx_queues(struct gfar_private *priv)
 		priv->tx_queue[i]->tx_skbuff = NULL;
 		priv->tx_queue[i]->qindex = i;
 		priv->tx_queue[i]->dev = priv->ndev;
-		spin_lock_init(&(priv->tx_queue[i]->txlock));
 	}
 	return 0;
 }
@@ -1179,6 +1230,7 @@ static void free_skb_resources(struct gfar_private *priv)
 void stop_gfar(struct net_device *dev)
 {
 	struct gfar_private *priv = netdev_priv(dev);
+	int i;
 
 	netif_tx_stop_all_queues(dev);
 
@@ -1188,6 +1240,9 @@ void stop_gfar(struct net_device *dev)
 
 	disable_napi(priv);
 
+	for (i = 0; i < priv->num_grps; i++)
+		cancel_work_sync(&priv->gfargrp[i].rx_dim.work);
+
 	/* disable ints and gracefully shut down Rx/Tx DMA */
 	gfar_halt(priv);
 
@@ -1317,7 +1372,8 @@ static void gfar_init_bds(struct net_device *ndev)
 	for (i = 0; i < priv->num_tx_queues; i++) {
 		tx_queue = priv->tx_queue[i];
 		/* Initialize some variables in our dev structure */
-		tx_queue->num_txbdfree = tx_queue->tx_ring_size;
+		tx_queue->num_txbds_queued = 0;
+		tx_queue->num_txbds_cleaned = 0;
 		tx_queue->dirty_tx = tx_queue->tx_bd_base;
 		tx_queue->cur_tx = tx_queue->tx_bd_base;
 		tx_queue->skb_curtx = 0;
@@ -1851,11 +1907,16 @@ static netdev_tx_t gfar_start_xmit(struct sk_buff *skb, struct net_device *dev)
 		nr_txbds = nr_frags + 1;
 
 	/* check if there is space to queue this packet */
-	if (nr_txbds > tx_queue->num_txbdfree) {
+	if (unlikely(nr_txbds > gfar_txbd_free(tx_queue))) {
 		/* no space, stop the queue */
 		netif_tx_stop_queue(txq);
-		dev->stats.tx_fifo_errors++;
-		return NETDEV_TX_BUSY;
+		/* Pairs with the barrier in gfar_clean_tx_ring() */
+		smp_mb();
+		if (nr_txbds > gfar_txbd_free(tx_queue)) {
+			dev->stats.tx_fifo_errors++;
+			return NETDEV_TX_BUSY;
+		}
+		netif_tx_start_queue(txq);
 	}
 
 	/* Update transmit stats */
@@ -1995,23 +2056,28 @@ static netdev_tx_t gfar_start_xmit(struct sk_buff *skb, struct net_device *dev)
 
 	tx_queue->cur_tx = next_txbd(txbdp, base, tx_queue->tx_ring_size);
 
-	/* We can work in parallel with gfar_clean_tx_ring(), except
-	 * when modifying num_txbdfree. Note that we didn't grab the lock
-	 * when we were reading the num_txbdfree and checking for available
-	 * space, that's because outside of this function it can only grow.
+	/* We work in parallel with gfar_clean_tx_ring(), which only ever
+	 * advances num_txbds_cleaned, so the free TxBD count seen here can
+	 * only grow behind our back.
 	 */
-	spin_lock_bh(&tx_queue->txlock);
-	/* reduce TxBD free count */
-	tx_queue->num_txbdfree -= (nr_txbds);
-	spin_unlock_bh(&tx_queue->txlock);
+	WRITE_ONCE(tx_queue->num_txbds_queued,
+		   tx_queue->num_txbds_queued + nr_txbds);
 
 	/* If the next BD still needs to be cleaned up, then the bds
 	 * are full.  We need to tell the kernel to stop sending us stuff.
 	 */
-	if (!tx_queue->num_txbdfree) {
+	if (!gfar_txbd_free(tx_queue)) {
 		netif_tx_stop_queue(txq);
 
 		dev->stats.tx_fifo_errors++;
+
+		/* The cleanup may have freed BDs before it could see the
+		 * queue stopped. Pairs with the barrier in
+		 * gfar_clean_tx_ring().
+		 */
+		smp_mb();
+		if (gfar_txbd_free(tx_queue))
+			netif_tx_start_queue(txq);
 	}
 
 	/* Tell the DMA to go go go */
@@ -2197,12 +2263,14 @@ static void gfar_clean_tx_ring(struct gfar_priv_tx_q *tx_queue)
 	int howmany = 0;
 	int tqi = tx_queue->qindex;
 	unsigned int bytes_sent = 0;
+	unsigned int num_txbds_cleaned;
 	u32 lstatus;
 	size_t buflen;
 
 	txq = netdev_get_tx_queue(dev, tqi);
 	bdp = tx_queue->dirty_tx;
 	skb_dirtytx = tx_queue->skb_dirtytx;
+	num_txbds_cleaned = tx_queue->num_txbds_cleaned;
 
 	while ((skb = tx_queue->tx_skbuff[skb_dirtytx])) {
 		bool do_tstamp;
@@ -2273,16 +2341,27 @@ static void gfar_clean_tx_ring(struct gfar_priv_tx_q *tx_queue)
 			      TX_RING_MOD_MASK(tx_ring_size);
 
 		howmany++;
-		spin_lock(&tx_queue->txlock);
-		tx_queue->num_txbdfree += nr_txbds;
-		spin_unlock(&tx_queue->txlock);
+		num_txbds_cleaned += nr_txbds;
 	}
 
-	/* If we freed a buffer, we can restart transmission, if necessary */
-	if (tx_queue->num_txbdfree &&
-	    netif_tx_queue_stopped(txq) &&
-	    !(test_bit(GFAR_DOWN, &priv->state)))
-		netif_wake_subqueue(priv->ndev, tqi);
+	if (howmany) {
+		/* Hand the BDs back to the xmit path only after they were
+		 * cleared.
+		 */
+		smp_store_release(&tx_queue->num_txbds_cleaned,
+				  num_txbds_cleaned);
+
+		/* Either we see the queue stopped here, or gfar_start_xmit()
+		 * sees the BDs freed above after stopping it. Pairs with the
+		 * barriers in gfar_start_xmit().
+		 */
+		smp_mb();
+
+		/* We freed a buffer, so restart transmission if necessary */
+		if (netif_tx_queue_stopped(txq) &&
+		    !(test_bit(GFAR_DOWN, &priv->state)))
+			netif_wake_subqueue(priv->ndev, tqi);
+	}
 
 	/* Update dirty indicators */
 	tx_queue->skb_dirtytx = skb_dirtytx;
@@ -2640,6 +2719,10 @@ static int gfar_poll_rx_sq(struct napi_struct *napi, int budget)
 	if (work_done < budget) {
 		u32 imask;
 		napi_complete_done(napi, work_done);
+
+		if (gfargrp->priv->rx_dim_en)
+			gfar_rx_net_dim(gfargrp);
+
 		/* Clear the halt bit in RSTAT */
 		gfar_write(&regs->rstat, gfargrp->rstat);
 
@@ -2730,6 +2813,9 @@ static int gfar_poll_rx(struct napi_struct *napi, int budget)
 		u32 imask;
 		napi_complete_done(napi, work_done);
 
+		if (priv->rx_dim_en)
+			gfar_rx_net_dim(gfargrp);
+
 		/* Clear the halt bit in RSTAT */
 		gfar_write(&regs->rstat, gfargrp->rstat);
 
@@ -2977,6 +3063,57 @@ static int register_grp_irqs(struct gfar_priv_grp *grp)
 
 }
 
+static void gfar_irq_set_affinity(unsigned int irq,
+				  const struct cpumask *mask)
+{
+	/* Sets the affinity, which outlives free_irq(), but the hint must
+	 * not be left behind for it
+	 */
+	irq_set_affinity_hint(irq, mask);
+	irq_set_affinity_hint(irq, NULL);
+}
+
+static void gfar_grp_irq_set_affinity(struct gfar_priv_grp *grp,
+				      const struct cpumask *mask)
+{
+	struct gfar_private *priv = grp->priv;
+
+	gfar_irq_set_affinity(gfar_irq(grp, TX)->irq, mask);
+	if (priv->device_flags & FSL_GIANFAR_DEV_HAS_MULTI_INTR) {
+		gfar_irq_set_affinity(gfar_irq(grp, RX)->irq, mask);
+		gfar_irq_set_affinity(gfar_irq(grp, ER)->irq, mask);
+	}
+}
+
+/* Spread the groups over the CPUs, and have each CPU transmit on the Tx
+ * queues of the group whose interrupts (and so NAPI instances) it serves.
+ * A Tx queue is then filled and cleaned up from the same CPU, and the only
+ * state shared by the two paths, the TxBD counters, stays local to it.
+ *
+ * These are only defaults, set once at probe time: both the IRQ affinity
+ * and the XPS map are kept across close and open, so that whatever the
+ * user configured instead stays in effect.
+ */
+static void gfar_set_grp_affinity(struct gfar_private *priv)
+{
+	int i, cpu = cpumask_first(cpu_online_mask);
+
+	for (i = 0; i < priv->num_grps; i++) {
+		struct gfar_priv_grp *grp = &priv->gfargrp[i];
+		const struct cpumask *mask = cpumask_of(cpu);
+		int q;
+
+		gfar_grp_irq_set_affinity(grp, mask);
+
+		for_each_set_bit(q, &grp->tx_bit_map, priv->num_tx_queues)
+			netif_set_xps_queue(priv->ndev, mask, q);
+
+		cpu = cpumask_next(cpu, cpu_online_mask);
+		if (cpu >= nr_cpu_ids)
+			cpu = cpumask_first(cpu_online_mask);
+	}
+}
+
 static void gfar_free_irq(struct gfar_private *priv)
 {
 	int i;
@@ -3349,6 +3486,9 @@ static int gfar_probe(struct platform_device *ofdev)
 			netif_tx_napi_add(dev, &priv->gfargrp[i].napi_tx,
 				       gfar_poll_tx, 2);
 		}
+
+		INIT_WORK(&priv->gfargrp[i].rx_dim.work, gfar_rx_dim_work);
+		priv->gfargrp[i].rx_dim.mode = DIM_CQ_PERIOD_MODE_START_FROM_EQE;
 	}
 
 	if (priv->device_flags & FSL_GIANFAR_DEV_HAS_CSUM) {
@@ -3364,6 +3504,16 @@ static int gfar_probe(struct platform_device *ofdev)
 		dev->features |= NETIF_F_HW_VLAN_CTAG_RX;
 	}
 
+	/* Room for the TxFCB, and for the alignment padding which comes
+	 * with it for time stamped frames, so that gfar_start_xmit()
+	 * doesn't have to reallocate the skb.
+	 */
+	if (priv->device_flags & (FSL_GIANFAR_DEV_HAS_CSUM |
+				  FSL_GIANFAR_DEV_HAS_VLAN))
+		dev->needed_headroom = GMAC_FCB_LEN;
+	if (priv->device_flags & FSL_GIANFAR_DEV_HAS_TIMER)
+		dev->needed_headroom = GMAC_FCB_LEN + GMAC_TXPAL_LEN;
+
 	dev->priv_flags |= IFF_LIVE_ADDR_CHANGE;
 
 	gfar_init_addr_hash_table(priv);
@@ -3381,7 +3531,6 @@ static int gfar_probe(struct platform_device *ofdev)
 	/* Initializing some of the rx/tx queue level parameters */
 	for (i = 0; i < priv->num_tx_queues; i++) {
 		priv->tx_queue[i]->tx_ring_size = DEFAULT_TX_RING_SIZE;
-		priv->tx_queue[i]->num_txbdfree = DEFAULT_TX_RING_SIZE;
 		priv->tx_queue[i]->txcoalescing = DEFAULT_TX_COALESCE;
 		priv->tx_queue[i]->txic = DEFAULT_TXIC;
 	}
@@ -3392,6 +3541,10 @@ static int gfar_probe(struct platform_device *ofdev)
 		priv->rx_queue[i]->rxic = DEFAULT_RXIC;
 	}
 
+	/* Let the rx coalescing follow the load, where supported */
+	if (priv->device_flags & FSL_GIANFAR_DEV_HAS_COALESCE)
+		priv->rx_dim_en = 1;
+
 	/* Always enable rx filer if available */
 	priv->rx_filer_enable =
 	    (priv->device_flags & FSL_GIANFAR_DEV_HAS_RX_FILER) ? 1 : 0;
@@ -3438,6 +3591,8 @@ static int gfar_probe(struct platform_device *ofdev)
 			strcpy(gfar_irq(grp, TX)->name, dev->name);
 	}
 
+	gfar_set_grp_affinity(priv);
+
 	/* Initialize the filer table */
 	gfar_init_filer_table(priv);
 
@@ -41,6 +41,7 @@
 #include <linux/crc32.h>
 #include <linux/workqueue.h>
 #include <linux/ethtool.h>
+#include <linux/dim.h>
 
 struct ethtool_flow_spec_container {
 	struct ethtool_rx_flow_spec fs;
@@ -243,6 +244,9 @@ extern const char gfar_driver_version[];
 				 IC_ICFT_SHIFT)
 #define get_ictt_value(ic)	((unsigned long)ic & IC_ICTT_MASK)
 
+#define GFAR_MAX_COAL_USECS 0xffff
+#define GFAR_MAX_COAL_FRAMES 0xff
+
 #define DEFAULT_TXIC mk_ic_value(DEFAULT_TXCOUNT, DEFAULT_TXTIME)
 #define DEFAULT_RXIC mk_ic_value(DEFAULT_RXCOUNT, DEFAULT_RXTIME)
 
@@ -936,7 +940,6 @@ struct tx_q_stats {
 
 /**
  *	struct gfar_priv_tx_q - per tx queue structure
- *	@txlock: per queue tx spin lock
  *	@tx_skbuff:skb pointers
  *	@skb_curtx: to be used skb pointer
  *	@skb_dirtytx:the last used skb pointer
@@ -948,26 +951,27 @@ struct tx_q_stats {
  *	@cur_tx: Next free ring entry
  *	@dirty_tx: First buffer in line to be transmitted
  *	@tx_ring_size: Tx ring size
- *	@num_txbdfree: number of free TxBds
+ *	@num_txbds_queued: number of TxBds handed to the hardware so far
+ *	@num_txbds_cleaned: number of TxBds reclaimed by the cleanup so far
  *	@txcoalescing: enable/disable tx coalescing
  *	@txic: transmit interrupt coalescing value
  *	@txcount: coalescing value if based on tx frame count
  *	@txtime: coalescing value if based on time
  */
 struct gfar_priv_tx_q {
-	/* cacheline 1 */
-	spinlock_t txlock __attribute__ ((aligned (SMP_CACHE_BYTES)));
-	struct	txbd8 *tx_bd_base;
+	/* cacheline 1, written by the xmit path only */
+	struct	txbd8 *tx_bd_base ____cacheline_aligned_in_smp;
 	struct	txbd8 *cur_tx;
-	unsigned int num_txbdfree;
+	unsigned int num_txbds_queued;
 	unsigned short skb_curtx;
 	unsigned short tx_ring_size;
 	struct tx_q_stats stats;
 	struct gfar_priv_grp *grp;
-	/* cacheline 2 */
-	struct net_device *dev;
+	/* cacheline 2, written by the cleanup path only */
+	struct net_device *dev ____cacheline_aligned_in_smp;
 	struct sk_buff **tx_skbuff;
 	struct	txbd8 *dirty_tx;
+	unsigned int num_txbds_cleaned;
 	unsigned short skb_dirtytx;
 	unsigned short qindex;
 	/* Configuration info for the coalescing features */
@@ -1041,6 +1045,8 @@ struct gfar_irqinfo {
  *	@priv: back pointer to the priv structure
  *	@regs: the ioremapped register space for this group
  *	@irqinfo: TX/RX/ER irq data for this group
+ *	@rx_dim: adaptive moderation state of the group's rx queues
+ *	@rx_dim_events: number of rx napi completions, sampled by rx_dim
  */
 
 struct gfar_priv_grp {
@@ -1060,6 +1066,9 @@ struct gfar_priv_grp {
 	unsigned long rx_bit_map;
 
 	struct gfar_irqinfo *irqinfo[GFAR_NUM_IRQS];
+
+	struct dim rx_dim;
+	u16 rx_dim_events;
 };
 
 #define gfar_irq(grp, ID) \
@@ -1138,7 +1147,9 @@ struct gfar_private {
 		/* Flow control flags */
 		pause_aneg_en:1,
 		tx_pause_en:1,
-		rx_pause_en:1;
+		rx_pause_en:1,
+		/* Adaptive rx interrupt coalescing */
+		rx_dim_en:1;
 
 	/* The total tx and rx ring size for the enabled queues */
 	unsigned int total_tx_ring_size;
@@ -1273,6 +1284,19 @@ static inline void gfar_clear_txbd_status(struct txbd8 *bdp)
 	bdp->lstatus = cpu_to_be32(lstatus);
 }
 
+/* Each of the two counters has a single writer, the xmit path for
+ * num_txbds_queued and gfar_clean_tx_ring() for num_txbds_cleaned, so both
+ * sides can tell how many TxBDs are free without a lock. The acquire pairs
+ * with the release in gfar_clean_tx_ring(), so that xmit doesn't reuse BDs
+ * before the cleanup is done with them.
+ */
+static inline unsigned int gfar_txbd_free(struct gfar_priv_tx_q *txq)
+{
+	return txq->tx_ring_size -
+	       (READ_ONCE(txq->num_txbds_queued) -
+		smp_load_acquire(&txq->num_txbds_cleaned));
+}
+
 static inline int gfar_rxbd_unused(struct gfar_priv_rx_q *rxq)
 {
 	if (rxq->next_to_clean > rxq->next_to_use)
@@ -1298,6 +1322,7 @@ static inline u32 gfar_rxbd_dma_lastfree(struct gfar_priv_rx_q *rxq)
 int startup_gfar(struct net_device *dev);
 void stop_gfar(struct net_device *dev);
 void gfar_mac_reset(struct gfar_private *priv);
+unsigned int gfar_usecs2ticks(struct gfar_private *priv, unsigned int usecs);
 int gfar_set_features(struct net_device *dev, netdev_features_t features);
 
 extern const struct ethtool_ops gfar_ethtool_ops;
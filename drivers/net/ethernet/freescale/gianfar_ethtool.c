@@ -43,9 +43,6 @@
 
 #include "gianfar.h"
 
-#define GFAR_MAX_COAL_USECS 0xffff
-#define GFAR_MAX_COAL_FRAMES 0xff
-
 static const char stat_gstrings[][ETH_GSTRING_LEN] = {
 	/* extra stats */
 	"rx-allocation-errors",
@@ -191,8 +188,7 @@ static void gfar_get_regs(struct net_device *dev, struct ethtool_regs *regs,
 
 /* Convert microseconds to ethernet clock ticks, which changes
  * depending on what speed the controller is running at */
-static unsigned int gfar_usecs2ticks(struct gfar_private *priv,
-				     unsigned int usecs)
+unsigned int gfar_usecs2ticks(struct gfar_private *priv, unsigned int usecs)
 {
 	struct net_device *ndev = priv->ndev;
 	struct phy_device *phydev = ndev->phydev;
@@ -276,7 +272,7 @@ static int gfar_gcoalesce(struct net_device *dev,
 	cvals->tx_coalesce_usecs = gfar_ticks2usecs(priv, txtime);
 	cvals->tx_max_coalesced_frames = txcount;
 
-	cvals->use_adaptive_rx_coalesce = 0;
+	cvals->use_adaptive_rx_coalesce = priv->rx_dim_en;
 	cvals->use_adaptive_tx_coalesce = 0;
 
 	cvals->pkt_rate_low = 0;
@@ -350,23 +346,25 @@ static int gfar_scoalesce(struct net_device *dev,
 		return -EINVAL;
 	}
 
+	if (cvals->use_adaptive_tx_coalesce)
+		return -EOPNOTSUPP;
+
 	while (test_and_set_bit_lock(GFAR_RESETTING, &priv->state))
 		cpu_relax();
 
-	/* Set up rx coalescing */
-	if ((cvals->rx_coalesce_usecs == 0) ||
-	    (cvals->rx_max_coalesced_frames == 0)) {
-		for (i = 0; i < priv->num_rx_queues; i++)
-			priv->rx_queue[i]->rxcoalescing = 0;
-	} else {
-		for (i = 0; i < priv->num_rx_queues; i++)
-			priv->rx_queue[i]->rxcoalescing = 1;
-	}
+	priv->rx_dim_en = !!cvals->use_adaptive_rx_coalesce;
+
+	/* Set up rx coalescing, unless it is adjusted at runtime */
+	if (!priv->rx_dim_en) {
+		for (i = 0; i < priv->num_rx_queues; i++) {
+			struct gfar_priv_rx_q *rx_queue = priv->rx_queue[i];
 
-	for (i = 0; i < priv->num_rx_queues; i++) {
-		priv->rx_queue[i]->rxic = mk_ic_value(
-			cvals->rx_max_coalesced_frames,
-			gfar_usecs2ticks(priv, cvals->rx_coalesce_usecs));
+			rx_queue->rxcoalescing = cvals->rx_coalesce_usecs &&
+						 cvals->rx_max_coalesced_frames;
+			rx_queue->rxic = mk_ic_value(
+				cvals->rx_max_coalesced_frames,
+				gfar_usecs2ticks(priv, cvals->rx_coalesce_usecs));
+		}
 	}
 
 	/* Set up tx coalescing */
@@ -586,8 +586,7 @@ int ocelot_port_add_txtstamp_skb(struct ocelot_port *ocelot_port,
 	    ocelot_port->ptp_cmd == IFH_REW_OP_TWO_STEP_PTP) {
 		shinfo->tx_flags |= SKBTX_IN_PROGRESS;
 		/* Store timestamp ID in cb[0] of sk_buff */
-		skb->cb[0] = ocelot_port->ts_id % 4;
-		skb_queue_tail(&ocelot_port->tx_skbs, skb);
+		skb->cb[0] = dsa_txtstamp_add(&ocelot_port->tx_tstamps, skb);
 		return 0;
 	}
 	return -ENODATA;
@@ -605,6 +604,8 @@ static int ocelot_port_xmit(struct sk_buff *skb, struct net_device *dev)
 	u8 grp = 0; /* Send everything on CPU group 0 */
 	unsigned int i, count, last;
 	int port = priv->chip_port;
+	unsigned int len = skb->len;
+	bool txtstamp = false;
 
 	val = ocelot_read(ocelot, QS_INJ_STATUS);
 	if (!(val & QS_INJ_STATUS_FIFO_RDY(BIT(grp))) ||
@@ -618,11 +619,17 @@ static int ocelot_port_xmit(struct sk_buff *skb, struct net_device *dev)
 	info.tag_type = IFH_TAG_TYPE_C;
 	info.vid = skb_vlan_tag_get(skb);
 
-	/* Check if timestamping is needed */
+	/* Check if timestamping is needed. The skb is queued for the TX
+	 * timestamp before injection, so that the timestamp interrupt can
+	 * always find it. Which also means that once the frame is complete,
+	 * the interrupt may free it, so it must not be touched past EOF.
+	 */
 	if (ocelot->ptp && shinfo->tx_flags & SKBTX_HW_TSTAMP) {
 		info.rew_op = ocelot_port->ptp_cmd;
-		if (ocelot_port->ptp_cmd == IFH_REW_OP_TWO_STEP_PTP)
-			info.rew_op |= (ocelot_port->ts_id  % 4) << 3;
+		if (!ocelot_port_add_txtstamp_skb(ocelot_port, skb)) {
+			info.rew_op |= skb->cb[0] << 3;
+			txtstamp = true;
+		}
 	}
 
 	ocelot_gen_ifh(ifh, &info);
@@ -631,8 +638,8 @@ static int ocelot_port_xmit(struct sk_buff *skb, struct net_device *dev)
 		ocelot_write_rix(ocelot, (__force u32)cpu_to_be32(ifh[i]),
 				 QS_INJ_WR, grp);
 
-	count = (skb->len + 3) / 4;
-	last = skb->len % 4;
+	count = (len + 3) / 4;
+	last = len % 4;
 	for (i = 0; i < count; i++) {
 		ocelot_write_rix(ocelot, ((u32 *)skb->data)[i], QS_INJ_WR, grp);
 	}
@@ -643,23 +650,22 @@ static int ocelot_port_xmit(struct sk_buff *skb, struct net_device *dev)
 		i++;
 	}
 
+	skb_tx_timestamp(skb);
+
 	/* Indicate EOF and valid bytes in last word */
 	ocelot_write_rix(ocelot, QS_INJ_CTRL_GAP_SIZE(1) |
-			 QS_INJ_CTRL_VLD_BYTES(skb->len < OCELOT_BUFFER_CELL_SZ ? 0 : last) |
+			 QS_INJ_CTRL_VLD_BYTES(len < OCELOT_BUFFER_CELL_SZ ? 0 : last) |
 			 QS_INJ_CTRL_EOF,
 			 QS_INJ_CTRL, grp);
 
 	/* Add dummy CRC */
 	ocelot_write_rix(ocelot, 0, QS_INJ_WR, grp);
-	skb_tx_timestamp(skb);
 
 	dev->stats.tx_packets++;
-	dev->stats.tx_bytes += skb->len;
+	dev->stats.tx_bytes += len;
 
-	if (!ocelot_port_add_txtstamp_skb(ocelot_port, skb)) {
-		ocelot_port->ts_id++;
+	if (txtstamp)
 		return NETDEV_TX_OK;
-	}
 
 	dev_kfree_skb_any(skb);
 	return NETDEV_TX_OK;
@@ -695,13 +701,13 @@ static void ocelot_get_hwtimestamp(struct ocelot *ocelot,
 void ocelot_get_txtstamp(struct ocelot *ocelot)
 {
 	int budget = OCELOT_PTP_QUEUE_SZ;
+	struct ocelot_port *port;
+	int i;
 
 	while (budget--) {
-		struct sk_buff *skb, *skb_tmp, *skb_match = NULL;
 		struct skb_shared_hwtstamps shhwtstamps;
-		struct ocelot_port *port;
+		struct sk_buff *skb;
 		struct timespec64 ts;
-		unsigned long flags;
 		u32 val, id, txport;
 
 		val = ocelot_read(ocelot, SYS_PTP_STATUS);
@@ -718,23 +724,12 @@ void ocelot_get_txtstamp(struct ocelot *ocelot)
 
 		/* Retrieve its associated skb */
 		port = ocelot->ports[txport];
-
-		spin_lock_irqsave(&port->tx_skbs.lock, flags);
-
-		skb_queue_walk_safe(&port->tx_skbs, skb, skb_tmp) {
-			if (skb->cb[0] != id)
-				continue;
-			__skb_unlink(skb, &port->tx_skbs);
-			skb_match = skb;
-			break;
-		}
-
-		spin_unlock_irqrestore(&port->tx_skbs.lock, flags);
+		skb = dsa_txtstamp_match(&port->tx_tstamps, id);
 
 		/* Next ts */
 		ocelot_write(ocelot, SYS_PTP_NXT_PTP_NXT, SYS_PTP_NXT);
 
-		if (unlikely(!skb_match))
+		if (unlikely(!skb))
 			continue;
 
 		/* Get the h/w timestamp */
@@ -743,9 +738,18 @@ void ocelot_get_txtstamp(struct ocelot *ocelot)
 		/* Set the timestamp into the skb */
 		memset(&shhwtstamps, 0, sizeof(shhwtstamps));
 		shhwtstamps.hwtstamp = ktime_set(ts.tv_sec, ts.tv_nsec);
-		skb_tstamp_tx(skb_match, &shhwtstamps);
+		skb_tstamp_tx(skb, &shhwtstamps);
+
+		dev_kfree_skb_any(skb);
+	}
+
+	/* Drop the requests for which the hardware never sent a timestamp */
+	for (i = 0; i < ocelot->num_phys_ports; i++) {
+		port = ocelot->ports[i];
+		if (!port)
+			continue;
 
-		dev_kfree_skb_any(skb_match);
+		dsa_txtstamp_reap(&port->tx_tstamps);
 	}
 }
 EXPORT_SYMBOL(ocelot_get_txtstamp);
@@ -1222,6 +1226,17 @@ static const struct net_device_ops ocelot_port_netdev_ops = {
 	.ndo_do_ioctl			= ocelot_ioctl,
 };
 
+/* Software counters, appended after the hardware ones */
+static const char ocelot_txtstamp_stats_strings[][ETH_GSTRING_LEN] = {
+	"tx_tstamp_requests",
+	"tx_tstamp_matched",
+	"tx_tstamp_orphans",
+	"tx_tstamp_timeouts",
+	"tx_tstamp_overruns",
+};
+
+#define OCELOT_NUM_TXTSTAMP_STATS ARRAY_SIZE(ocelot_txtstamp_stats_strings)
+
 void ocelot_get_strings(struct ocelot *ocelot, int port, u32 sset, u8 *data)
 {
 	int i;
@@ -1232,6 +1247,9 @@ void ocelot_get_strings(struct ocelot *ocelot, int port, u32 sset, u8 *data)
 	for (i = 0; i < ocelot->num_stats; i++)
 		memcpy(data + i * ETH_GSTRING_LEN, ocelot->stats_layout[i].name,
 		       ETH_GSTRING_LEN);
+
+	memcpy(data + i * ETH_GSTRING_LEN, ocelot_txtstamp_stats_strings,
+	       sizeof(ocelot_txtstamp_stats_strings));
 }
 EXPORT_SYMBOL(ocelot_get_strings);
 
@@ -1287,6 +1305,8 @@ static void ocelot_check_stats_work(struct work_struct *work)
 
 void ocelot_get_ethtool_stats(struct ocelot *ocelot, int port, u64 *data)
 {
+	struct ocelot_port *ocelot_port = ocelot->ports[port];
+	struct dsa_txtstamp_stats txtstamp_stats = {0};
 	int i;
 
 	/* check and update now */
@@ -1295,6 +1315,16 @@ void ocelot_get_ethtool_stats(struct ocelot *ocelot, int port, u64 *data)
 	/* Copy all counters */
 	for (i = 0; i < ocelot->num_stats; i++)
 		*data++ = ocelot->stats[port * ocelot->num_stats + i];
+
+	if (ocelot_port)
+		dsa_txtstamp_get_stats(&ocelot_port->tx_tstamps,
+				       &txtstamp_stats);
+
+	*data++ = txtstamp_stats.requests;
+	*data++ = txtstamp_stats.matched;
+	*data++ = txtstamp_stats.orphans;
+	*data++ = txtstamp_stats.timeouts;
+	*data++ = txtstamp_stats.overruns;
 }
 EXPORT_SYMBOL(ocelot_get_ethtool_stats);
 
@@ -1314,7 +1344,7 @@ int ocelot_get_sset_count(struct ocelot *ocelot, int port, int sset)
 	if (sset != ETH_SS_STATS)
 		return -EOPNOTSUPP;
 
-	return ocelot->num_stats;
+	return ocelot->num_stats + OCELOT_NUM_TXTSTAMP_STATS;
 }
 EXPORT_SYMBOL(ocelot_get_sset_count);
 
@@ -2202,7 +2232,8 @@ void ocelot_init_port(struct ocelot *ocelot, int port)
 {
 	struct ocelot_port *ocelot_port = ocelot->ports[port];
 
-	skb_queue_head_init(&ocelot_port->tx_skbs);
+	dsa_txtstamp_ring_init(&ocelot_port->tx_tstamps, OCELOT_MAX_PTP_ID,
+			       OCELOT_PTP_TS_TIMEOUT);
 
 	/* Basic L2 initialization */
 
@@ -2499,7 +2530,8 @@ void ocelot_deinit(struct ocelot *ocelot)
 
 	for (i = 0; i < ocelot->num_phys_ports; i++) {
 		port = ocelot->ports[i];
-		skb_queue_purge(&port->tx_skbs);
+		if (port)
+			dsa_txtstamp_purge(&port->tx_tstamps);
 	}
 }
 EXPORT_SYMBOL(ocelot_deinit);
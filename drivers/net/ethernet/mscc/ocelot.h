@@ -43,6 +43,9 @@
 #define OCELOT_STATS_CHECK_DELAY (2 * HZ)
 
 #define OCELOT_PTP_QUEUE_SZ	128
+/* Number of IDs which TX timestamp requests are tagged with */
+#define OCELOT_MAX_PTP_ID	4
+#define OCELOT_PTP_TS_TIMEOUT	HZ
 
 struct frame_info {
 	u32 len;
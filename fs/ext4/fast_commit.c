@@ -0,0 +1,502 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * fs/ext4/fast_commit.c
+ *
+ * Fast commits: instead of committing the whole running transaction, an
+ * fsync of a file whose changes fit in its raw inode logs just that inode
+ * into the jbd2 fast commit area.  See fast_commit.h for the format.
+ */
+
+#include <linux/quotaops.h>
+#include "ext4.h"
+#include "ext4_jbd2.h"
+#include "ext4_extents.h"
+
+/*
+ * Record that the transaction @handle belongs to made changes that fast
+ * commits can't log, e.g. to directories, the orphan list or the group
+ * layout.  Every fsync in that transaction waits for the full commit.
+ */
+void ext4_fc_mark_ineligible(struct super_block *sb, handle_t *handle)
+{
+	if (!test_opt2(sb, JOURNAL_FAST_COMMIT) || !ext4_handle_valid(handle))
+		return;
+	WRITE_ONCE(EXT4_SB(sb)->s_fc_ineligible_tid,
+		   handle->h_transaction->t_tid);
+}
+
+/*
+ * Likewise, for changes to @inode that its raw inode doesn't capture, such
+ * as freed blocks, external xattrs or new links.
+ */
+void ext4_fc_mark_inode_ineligible(struct inode *inode, handle_t *handle)
+{
+	if (!test_opt2(inode->i_sb, JOURNAL_FAST_COMMIT) ||
+	    !ext4_handle_valid(handle))
+		return;
+	WRITE_ONCE(EXT4_I(inode)->i_fc_ineligible_tid,
+		   handle->h_transaction->t_tid);
+}
+
+/*
+ * Copy the raw inode for a fast commit of transaction @tid.  Handles may be
+ * changing the inode meanwhile: every change that rules out a fast commit
+ * is recorded before the raw inode is updated, so the checks that follow
+ * the copy see the records of all changes the copy holds.
+ */
+static int ext4_fc_copy_inode(struct inode *inode, tid_t tid, void *raw)
+{
+	struct super_block *sb = inode->i_sb;
+	struct ext4_sb_info *sbi = EXT4_SB(sb);
+	struct ext4_inode_info *ei = EXT4_I(inode);
+	journal_t *journal = sbi->s_journal;
+	struct ext4_extent_header *eh;
+	struct ext4_iloc iloc;
+	bool running;
+	int ret;
+
+	if (!ext4_test_inode_flag(inode, EXT4_INODE_EXTENTS) ||
+	    ext4_has_inline_data(inode) || IS_DAX(inode) ||
+	    sb_any_quota_loaded(sb))
+		return -EAGAIN;
+
+	ret = ext4_get_inode_loc(inode, &iloc);
+	if (ret)
+		return ret;
+	spin_lock(&ei->i_raw_lock);
+	memcpy(raw, ext4_raw_inode(&iloc), EXT4_INODE_SIZE(sb));
+	spin_unlock(&ei->i_raw_lock);
+	brelse(iloc.bh);
+
+	/* Changes of later transactions may only be in the copy once @tid
+	 * stopped running.
+	 */
+	read_lock(&journal->j_state_lock);
+	running = journal->j_running_transaction &&
+		  journal->j_running_transaction->t_tid == tid;
+	read_unlock(&journal->j_state_lock);
+
+	if (!running ||
+	    READ_ONCE(sbi->s_fc_ineligible_tid) == tid ||
+	    READ_ONCE(ei->i_fc_ineligible_tid) == tid ||
+	    atomic_read(&ei->i_unwritten))
+		return -EAGAIN;
+
+	/* Replay can't rebuild extent tree blocks */
+	eh = (struct ext4_extent_header *)((struct ext4_inode *)raw)->i_block;
+	if (eh->eh_magic != EXT4_EXT_MAGIC || eh->eh_depth)
+		return -EAGAIN;
+
+	return 0;
+}
+
+/*
+ * Write out and wait for the data a full commit would have waited for
+ * before exposing the inode's new blocks: the ordered range of its jbd2
+ * inode, which covers every block allocated since the last full commit.
+ */
+static int ext4_fc_wait_data(struct inode *inode, loff_t start, loff_t end,
+			     unsigned long flags)
+{
+	struct address_space *mapping = inode->i_mapping;
+	int ret = 0;
+
+	if (flags & JI_WRITE_DATA)
+		ret = filemap_fdatawrite_range(mapping, start, end);
+	if (!ret && flags & (JI_WRITE_DATA | JI_WAIT_DATA))
+		ret = filemap_fdatawait_range_keep_errors(mapping, start, end);
+	return ret;
+}
+
+static u8 *ext4_fc_put_tl(u8 *dst, u16 tag, u16 len)
+{
+	struct ext4_fc_tl tl;
+
+	tl.fc_tag = cpu_to_le16(tag);
+	tl.fc_len = cpu_to_le16(len);
+	memcpy(dst, &tl, sizeof(tl));
+	return dst + sizeof(tl);
+}
+
+static void ext4_fc_write_block(struct super_block *sb,
+				struct buffer_head *bh, struct inode *inode,
+				void *raw, tid_t tid)
+{
+	struct ext4_fc_head head;
+	struct ext4_fc_tail tail;
+	__le32 fc_ino = cpu_to_le32(inode->i_ino);
+	int inode_len = EXT4_INODE_SIZE(sb);
+	u8 *start = bh->b_data;
+	u8 *dst = start;
+
+	head.fc_features = cpu_to_le32(EXT4_FC_SUPPORTED_FEATURES);
+	head.fc_tid = cpu_to_le32(tid);
+	dst = ext4_fc_put_tl(dst, EXT4_FC_TAG_HEAD, sizeof(head));
+	memcpy(dst, &head, sizeof(head));
+	dst += sizeof(head);
+
+	dst = ext4_fc_put_tl(dst, EXT4_FC_TAG_INODE,
+			     sizeof(fc_ino) + inode_len);
+	memcpy(dst, &fc_ino, sizeof(fc_ino));
+	dst += sizeof(fc_ino);
+	memcpy(dst, raw, inode_len);
+	dst += inode_len;
+
+	/* The tail runs to the end of the block */
+	dst = ext4_fc_put_tl(dst, EXT4_FC_TAG_TAIL,
+			     start + sb->s_blocksize - dst -
+			     sizeof(struct ext4_fc_tl));
+	tail.fc_tid = cpu_to_le32(tid);
+	memcpy(dst, &tail.fc_tid, sizeof(tail.fc_tid));
+	dst += sizeof(tail.fc_tid);
+	tail.fc_crc = cpu_to_le32(ext4_chksum(EXT4_SB(sb), 0, start,
+					      dst - start));
+	memcpy(dst, &tail.fc_crc, sizeof(tail.fc_crc));
+}
+
+/*
+ * Try to make the changes to @inode in transaction @commit_tid durable with
+ * a fast commit.  The caller has written out and waited for the range being
+ * synced.  Returns -EAGAIN if the caller has to wait for the full commit
+ * instead.
+ */
+int ext4_fc_commit(struct inode *inode, tid_t commit_tid)
+{
+	struct super_block *sb = inode->i_sb;
+	struct ext4_sb_info *sbi = EXT4_SB(sb);
+	struct ext4_inode_info *ei = EXT4_I(inode);
+	journal_t *journal = sbi->s_journal;
+	struct jbd2_inode *jinode = ei->jinode;
+	unsigned long flags = 0;
+	loff_t start = 0, end = 0;
+	struct buffer_head *bh;
+	unsigned int seq;
+	void *raw;
+	int ret, err;
+
+	raw = kmalloc(EXT4_INODE_SIZE(sb), GFP_KERNEL);
+	if (!raw)
+		return -EAGAIN;
+
+	/*
+	 * Keep writeback of this inode out while copying it, so that any
+	 * block in the copy already has its data under writeback and in the
+	 * ordered range of the jbd2 inode.  Nothing else is held up.
+	 */
+	down_write(&ei->i_fc_rwsem);
+	ret = ext4_fc_copy_inode(inode, commit_tid, raw);
+	seq = ++ei->i_fc_copy_seq;
+	if (!ret && jinode) {
+		spin_lock(&journal->j_list_lock);
+		if (jinode->i_transaction || jinode->i_next_transaction) {
+			flags = jinode->i_flags;
+			start = jinode->i_dirty_start;
+			end = jinode->i_dirty_end;
+		}
+		spin_unlock(&journal->j_list_lock);
+	}
+	up_write(&ei->i_fc_rwsem);
+	if (ret)
+		goto out;
+
+	ret = ext4_fc_wait_data(inode, start, end, flags);
+	if (ret)
+		goto out;
+
+	mutex_lock(&sbi->s_fc_lock);
+	/*
+	 * A racing fsync already logged a later copy of the inode: logging
+	 * ours after it would roll the inode back on replay, and isn't
+	 * needed either.
+	 */
+	if ((int)(ei->i_fc_logged_seq - seq) >= 0)
+		goto out_unlock;
+	if (jbd2_fc_begin_commit(journal, commit_tid)) {
+		ret = -EAGAIN;
+		goto out_unlock;
+	}
+	ret = jbd2_fc_get_buf(journal, &bh);
+	if (!ret)
+		ext4_fc_write_block(sb, bh, inode, raw, commit_tid);
+	err = jbd2_fc_end_commit(journal, ret != 0);
+	if (ret || err)
+		ret = -EAGAIN;
+	else
+		ei->i_fc_logged_seq = seq;
+out_unlock:
+	mutex_unlock(&sbi->s_fc_lock);
+out:
+	kfree(raw);
+	return ret;
+}
+
+/*
+ * Scan pass: count the tags covered by a valid tail.  Each fast commit
+ * block starts with a head and is closed by a tail.
+ */
+static int ext4_fc_replay_scan(struct super_block *sb,
+			       struct buffer_head *bh, int off,
+			       tid_t expected_tid)
+{
+	struct ext4_fc_replay_state *state = &EXT4_SB(sb)->s_fc_replay_state;
+	u8 *start = bh->b_data, *end = start + bh->b_size;
+	struct ext4_fc_head head;
+	struct ext4_fc_tail tail;
+	struct ext4_fc_tl tl;
+	bool unknown = false;
+	u8 *cur, *val;
+	u32 features;
+	u16 tag, len;
+	int tags;
+
+	if (off == 0) {
+		state->fc_replay_num_tags = 0;
+		state->fc_cur_tag = 0;
+	}
+
+	/*
+	 * The log ends at the first block that is unused or that holds a
+	 * fast commit of another transaction.  Any other block has to start
+	 * with a head.
+	 */
+	memcpy(&tl, start, sizeof(tl));
+	if (!tl.fc_tag && !tl.fc_len)
+		return 1;
+	if (le16_to_cpu(tl.fc_tag) != EXT4_FC_TAG_HEAD ||
+	    le16_to_cpu(tl.fc_len) != sizeof(head)) {
+		ext4_msg(sb, KERN_ERR, "no valid head in fast commit "
+			 "journal block %d", off);
+		return -EFSCORRUPTED;
+	}
+	memcpy(&head, start + sizeof(tl), sizeof(head));
+	if (le32_to_cpu(head.fc_tid) != expected_tid)
+		return 1;
+	features = le32_to_cpu(head.fc_features);
+	tags = 1;
+
+	/* A torn last fast commit has no valid tail and ends the log too */
+	for (cur = start + sizeof(tl) + sizeof(head);
+	     cur + sizeof(tl) <= end; cur = val + len) {
+		memcpy(&tl, cur, sizeof(tl));
+		tag = le16_to_cpu(tl.fc_tag);
+		len = le16_to_cpu(tl.fc_len);
+		val = cur + sizeof(tl);
+		if (val + len > end || tag == EXT4_FC_TAG_HEAD)
+			return 1;
+		tags++;
+
+		switch (tag) {
+		case EXT4_FC_TAG_INODE:
+			if (len != sizeof(struct ext4_fc_inode) +
+				   EXT4_INODE_SIZE(sb))
+				return 1;
+			break;
+		case EXT4_FC_TAG_PAD:
+			break;
+		case EXT4_FC_TAG_TAIL:
+			if (len < sizeof(tail))
+				return 1;
+			memcpy(&tail, val, sizeof(tail));
+			if (le32_to_cpu(tail.fc_tid) != expected_tid ||
+			    le32_to_cpu(tail.fc_crc) !=
+			    ext4_chksum(EXT4_SB(sb), 0, start,
+					val + offsetof(struct ext4_fc_tail,
+						       fc_crc) - start))
+				return 1;
+			/* Written by someone we can't follow? */
+			if (unknown || features & ~EXT4_FC_SUPPORTED_FEATURES) {
+				ext4_msg(sb, KERN_ERR, "unsupported fast commit "
+					 "in journal block %d", off);
+				return -EOPNOTSUPP;
+			}
+			state->fc_cur_tag += tags;
+			state->fc_replay_num_tags = state->fc_cur_tag;
+			return 0;
+		default:
+			unknown = true;
+			break;
+		}
+	}
+
+	return 1;
+}
+
+/* Mark the blocks of an extent being replayed in use */
+static int ext4_fc_replay_mark_used(struct super_block *sb,
+				    ext4_fsblk_t block, unsigned int len)
+{
+	struct ext4_super_block *es = EXT4_SB(sb)->s_es;
+	struct buffer_head *bitmap_bh, *gdp_bh;
+	struct ext4_group_desc *gdp;
+	ext4_grpblk_t offset, i;
+	ext4_group_t group;
+	unsigned int n, newly;
+	int err;
+
+	if (!len || block < le32_to_cpu(es->s_first_data_block) ||
+	    block + len > ext4_blocks_count(es))
+		return -EFSCORRUPTED;
+
+	while (len) {
+		ext4_get_group_no_and_offset(sb, block, &group, &offset);
+		n = min_t(unsigned int, len,
+			  EXT4_BLOCKS_PER_GROUP(sb) - offset);
+
+		gdp = ext4_get_group_desc(sb, group, &gdp_bh);
+		if (!gdp)
+			return -EFSCORRUPTED;
+		/* Initialising a group's bitmap makes a fast commit ineligible */
+		if (gdp->bg_flags & cpu_to_le16(EXT4_BG_BLOCK_UNINIT))
+			return -EFSCORRUPTED;
+
+		bitmap_bh = sb_bread(sb, ext4_block_bitmap(sb, gdp));
+		if (!bitmap_bh)
+			return -EIO;
+
+		newly = 0;
+		for (i = offset; i < offset + n; i++)
+			if (!ext4_test_and_set_bit(i, bitmap_bh->b_data))
+				newly++;
+
+		err = 0;
+		if (newly) {
+			ext4_free_group_clusters_set(sb, gdp,
+				ext4_free_group_clusters(sb, gdp) - newly);
+			ext4_block_bitmap_csum_set(sb, group, gdp, bitmap_bh);
+			ext4_group_desc_csum_set(sb, group, gdp);
+			mark_buffer_dirty(bitmap_bh);
+			mark_buffer_dirty(gdp_bh);
+			err = sync_dirty_buffer(bitmap_bh);
+			if (!err)
+				err = sync_dirty_buffer(gdp_bh);
+		}
+		brelse(bitmap_bh);
+		if (err)
+			return err;
+
+		block += n;
+		len -= n;
+	}
+
+	return 0;
+}
+
+static int ext4_fc_replay_write_inode(struct super_block *sb,
+				      unsigned long ino,
+				      struct ext4_inode *raw)
+{
+	unsigned long index = (ino - 1) % EXT4_INODES_PER_GROUP(sb);
+	ext4_group_t group = (ino - 1) / EXT4_INODES_PER_GROUP(sb);
+	struct ext4_group_desc *gdp;
+	struct buffer_head *bh;
+	int err;
+
+	gdp = ext4_get_group_desc(sb, group, NULL);
+	if (!gdp)
+		return -EFSCORRUPTED;
+
+	bh = sb_bread(sb, ext4_inode_table(sb, gdp) +
+			  index / EXT4_INODES_PER_BLOCK(sb));
+	if (!bh)
+		return -EIO;
+
+	lock_buffer(bh);
+	memcpy(bh->b_data +
+	       (index % EXT4_INODES_PER_BLOCK(sb)) * EXT4_INODE_SIZE(sb),
+	       raw, EXT4_INODE_SIZE(sb));
+	unlock_buffer(bh);
+	mark_buffer_dirty(bh);
+	err = sync_dirty_buffer(bh);
+	brelse(bh);
+	return err;
+}
+
+static int ext4_fc_replay_inode(struct super_block *sb, u8 *val)
+{
+	struct ext4_super_block *es = EXT4_SB(sb)->s_es;
+	struct ext4_extent_header *eh;
+	struct ext4_fc_inode fc_inode;
+	struct ext4_extent *ex;
+	struct ext4_inode *raw;
+	unsigned long ino;
+	int i, ret;
+
+	memcpy(&fc_inode, val, sizeof(fc_inode));
+	ino = le32_to_cpu(fc_inode.fc_ino);
+	raw = kmemdup(val + sizeof(fc_inode), EXT4_INODE_SIZE(sb), GFP_NOFS);
+	if (!raw)
+		return -ENOMEM;
+
+	eh = (struct ext4_extent_header *)raw->i_block;
+	if (ino < EXT4_FIRST_INO(sb) || ino > le32_to_cpu(es->s_inodes_count) ||
+	    !S_ISREG(le16_to_cpu(raw->i_mode)) ||
+	    !(le32_to_cpu(raw->i_flags) & EXT4_EXTENTS_FL) ||
+	    eh->eh_magic != EXT4_EXT_MAGIC || eh->eh_depth ||
+	    le16_to_cpu(eh->eh_entries) >
+	    (sizeof(raw->i_block) - sizeof(*eh)) / sizeof(*ex)) {
+		ret = -EFSCORRUPTED;
+		goto out;
+	}
+
+	ex = EXT_FIRST_EXTENT(eh);
+	for (i = 0; i < le16_to_cpu(eh->eh_entries); i++, ex++) {
+		ret = ext4_fc_replay_mark_used(sb, ext4_ext_pblock(ex),
+					       ext4_ext_get_actual_len(ex));
+		if (ret)
+			goto out;
+	}
+
+	ret = ext4_fc_replay_write_inode(sb, ino, raw);
+	ext4_debug("fast commit replay of inode %lu: %d\n", ino, ret);
+out:
+	if (ret)
+		ext4_msg(sb, KERN_ERR, "failed to replay fast commit of "
+			 "inode %lu: %d", ino, ret);
+	kfree(raw);
+	return ret;
+}
+
+/* Replay pass: apply the tags the scan pass found valid, in order */
+static int ext4_fc_replay_block(struct super_block *sb,
+				struct buffer_head *bh, int off)
+{
+	struct ext4_fc_replay_state *state = &EXT4_SB(sb)->s_fc_replay_state;
+	u8 *start = bh->b_data, *end = start + bh->b_size;
+	struct ext4_fc_tl tl;
+	u8 *cur, *val;
+	u16 len;
+	int ret;
+
+	if (off == 0)
+		state->fc_cur_tag = 0;
+
+	for (cur = start; cur + sizeof(tl) <= end; cur = val + len) {
+		if (state->fc_cur_tag >= state->fc_replay_num_tags)
+			return 1;
+		state->fc_cur_tag++;
+
+		memcpy(&tl, cur, sizeof(tl));
+		len = le16_to_cpu(tl.fc_len);
+		val = cur + sizeof(tl);
+		if (le16_to_cpu(tl.fc_tag) == EXT4_FC_TAG_INODE) {
+			ret = ext4_fc_replay_inode(sb, val);
+			if (ret)
+				return ret;
+		}
+	}
+
+	return 0;
+}
+
+/* jbd2 recovery callback, see journal_t::j_fc_replay_callback */
+int ext4_fc_replay(journal_t *journal, struct buffer_head *bh,
+		   enum passtype pass, int off, tid_t expected_tid)
+{
+	struct super_block *sb = journal->j_private;
+
+	if (pass == PASS_SCAN)
+		return ext4_fc_replay_scan(sb, bh, off, expected_tid);
+	if (pass == PASS_REPLAY)
+		return ext4_fc_replay_block(sb, bh, off);
+	return 1;
+}
@@ -0,0 +1,74 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ *  fs/ext4/fast_commit.h
+ *
+ *  On-disk format and replay state of ext4 fast commits.
+ */
+
+#ifndef _EXT4_FAST_COMMIT_H
+#define _EXT4_FAST_COMMIT_H
+
+/*
+ * A fast commit logs the raw on-disk inode of a single regular file into
+ * one block of the jbd2 fast commit area.  The block holds a sequence of
+ * tag-length-value records:
+ *
+ *   HEAD  - format features and the tid of the running transaction
+ *   INODE - inode number and a copy of the raw inode
+ *   TAIL  - tid and crc32c of the block up to the crc; its length runs
+ *           to the end of the block
+ *
+ * Fast commits are only taken for inodes whose extents all live in the
+ * inode itself and whose changes since the last full commit need nothing
+ * beyond the raw inode and the block bitmap bits of their extents.
+ * Replay marks the blocks of the logged extents in use and writes the
+ * raw inode back to the inode table.
+ */
+
+/* Fast commit tags */
+#define EXT4_FC_TAG_INODE		0x0006
+#define EXT4_FC_TAG_PAD			0x0007
+#define EXT4_FC_TAG_TAIL		0x0008
+#define EXT4_FC_TAG_HEAD		0x0009
+
+#define EXT4_FC_SUPPORTED_FEATURES	0x0
+
+/* On disk fast commit tlv value structures */
+
+/* Fast commit on disk tag length structure */
+struct ext4_fc_tl {
+	__le16 fc_tag;
+	__le16 fc_len;
+};
+
+/* Value structure for tag EXT4_FC_TAG_HEAD. */
+struct ext4_fc_head {
+	__le32 fc_features;
+	__le32 fc_tid;
+};
+
+/* Value structure for tag EXT4_FC_TAG_INODE. */
+struct ext4_fc_inode {
+	__le32 fc_ino;
+	__u8 fc_raw_inode[0];
+};
+
+/* Value structure for tag EXT4_FC_TAG_TAIL. */
+struct ext4_fc_tail {
+	__le32 fc_tid;
+	__le32 fc_crc;
+};
+
+/* Space one fast commit block needs besides the raw inode */
+#define EXT4_FC_BLOCK_OVERHEAD	(3 * sizeof(struct ext4_fc_tl) +	\
+				 sizeof(struct ext4_fc_head) +		\
+				 sizeof(struct ext4_fc_inode) +		\
+				 sizeof(struct ext4_fc_tail))
+
+/* State carried from the scan to the replay pass of recovery */
+struct ext4_fc_replay_state {
+	int fc_replay_num_tags;		/* Tags covered by a valid tail */
+	int fc_cur_tag;			/* Tags seen so far in this pass */
+};
+
+#endif /* _EXT4_FAST_COMMIT_H */
@@ -109,6 +109,14 @@ static int ext4_fsync_journal(struct inode *inode, bool datasync,
 	struct ext4_inode_info *ei = EXT4_I(inode);
 	journal_t *journal = EXT4_SB(inode->i_sb)->s_journal;
 	tid_t commit_tid = datasync ? ei->i_datasync_tid : ei->i_sync_tid;
+	int ret;
+
+	/* A fast commit flushes the device cache itself */
+	if (test_opt2(inode->i_sb, JOURNAL_FAST_COMMIT)) {
+		ret = ext4_fc_commit(inode, commit_tid);
+		if (ret != -EAGAIN)
+			return ret;
+	}
 
 	if (journal->j_flags & JBD2_BARRIER &&
 	    !jbd2_trans_will_send_data_barrier(journal, commit_tid))
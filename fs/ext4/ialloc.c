@@ -929,6 +929,8 @@ struct inode *__ext4_new_inode(handle_t *handle, struct inode *dir,
 				goto out;
 			}
 		}
+		/* New inodes and their links are beyond fast commits */
+		ext4_fc_mark_ineligible(sb, handle);
 		BUFFER_TRACE(inode_bitmap_bh, "get_write_access");
 		err = ext4_journal_get_write_access(handle, inode_bitmap_bh);
 		if (err) {
@@ -1160,6 +1160,11 @@ static int ext4_write_begin(struct file *file, struct address_space *mapping,
 		put_page(page);
 		return PTR_ERR(handle);
 	}
+	/*
+	 * Blocks allocated here are only dirty in the page cache; fast
+	 * commits count on them being under writeback.
+	 */
+	ext4_fc_mark_inode_ineligible(inode, handle);
 
 	lock_page(page);
 	if (page->mapping != mapping) {
@@ -2628,6 +2633,8 @@ static int ext4_writepages(struct address_space *mapping,
 		return -EIO;
 
 	percpu_down_read(&sbi->s_journal_flag_rwsem);
+	if (test_opt2(inode->i_sb, JOURNAL_FAST_COMMIT))
+		down_read(&EXT4_I(inode)->i_fc_rwsem);
 	trace_ext4_writepages(inode, wbc);
 
 	/*
@@ -2848,6 +2855,8 @@ static int ext4_writepages(struct address_space *mapping,
 out_writepages:
 	trace_ext4_writepages_result(inode, wbc, ret,
 				     nr_to_write - wbc->nr_to_write);
+	if (test_opt2(inode->i_sb, JOURNAL_FAST_COMMIT))
+		up_read(&EXT4_I(inode)->i_fc_rwsem);
 	percpu_up_read(&sbi->s_journal_flag_rwsem);
 	return ret;
 }
@@ -5946,6 +5955,7 @@ vm_fault_t ext4_page_mkwrite(struct vm_fault *vmf)
 		ret = VM_FAULT_SIGBUS;
 		goto out;
 	}
+	ext4_fc_mark_inode_ineligible(inode, handle);
 	err = block_page_mkwrite(vma, vmf, get_block);
 	if (!err && ext4_should_journal_data(inode)) {
 		if (ext4_walk_page_buffers(handle, page_buffers(page), 0,
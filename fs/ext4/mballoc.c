@@ -2996,6 +2996,8 @@ ext4_mb_mark_diskspace_used(struct ext4_allocation_context *ac,
 		      ac->ac_b_ex.fe_len);
 	if (ext4_has_group_desc_csum(sb) &&
 	    (gdp->bg_flags & cpu_to_le16(EXT4_BG_BLOCK_UNINIT))) {
+		/* Fast commit replay only handles initialised bitmaps */
+		ext4_fc_mark_ineligible(sb, handle);
 		gdp->bg_flags &= cpu_to_le16(~EXT4_BG_BLOCK_UNINIT);
 		ext4_free_group_clusters_set(sb, gdp,
 					     ext4_free_clusters_after_init(sb,
@@ -4719,6 +4721,7 @@ void ext4_free_blocks(handle_t *handle, struct inode *inode,
 	int ret;
 
 	might_sleep();
+	ext4_fc_mark_inode_ineligible(inode, handle);
 	if (bh) {
 		if (block)
 			BUG_ON(block != bh->b_blocknr);
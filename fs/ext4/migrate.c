@@ -443,6 +443,7 @@ int ext4_ext_migrate(struct inode *inode)
 		retval = PTR_ERR(handle);
 		return retval;
 	}
+	ext4_fc_mark_inode_ineligible(inode, handle);
 	goal = (((inode->i_ino - 1) / EXT4_INODES_PER_GROUP(inode->i_sb)) *
 		EXT4_INODES_PER_GROUP(inode->i_sb)) + 1;
 	owner[0] = i_uid_read(inode);
@@ -496,6 +497,7 @@ int ext4_ext_migrate(struct inode *inode)
 		retval = PTR_ERR(handle);
 		goto out;
 	}
+	ext4_fc_mark_inode_ineligible(inode, handle);
 
 	ei = EXT4_I(inode);
 	i_data = ei->i_data;
@@ -616,6 +618,7 @@ int ext4_ind_migrate(struct inode *inode)
 	handle = ext4_journal_start(inode, EXT4_HT_MIGRATE, 1);
 	if (IS_ERR(handle))
 		return PTR_ERR(handle);
+	ext4_fc_mark_inode_ineligible(inode, handle);
 
 	down_write(&EXT4_I(inode)->i_data_sem);
 	ret = ext4_ext_check_inode(inode);
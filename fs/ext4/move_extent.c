@@ -274,6 +274,8 @@ move_extent_per_page(struct file *o_filp, struct inode *donor_inode,
 		*err = PTR_ERR(handle);
 		return 0;
 	}
+	ext4_fc_mark_inode_ineligible(orig_inode, handle);
+	ext4_fc_mark_inode_ineligible(donor_inode, handle);
 
 	orig_blk_offset = orig_page_offset * blocks_per_page +
 		data_offset_in_page;
@@ -2928,6 +2928,8 @@ int ext4_orphan_add(handle_t *handle, struct inode *inode)
 	if (!list_empty(&EXT4_I(inode)->i_orphan))
 		return 0;
 
+	ext4_fc_mark_ineligible(sb, handle);
+
 	/*
 	 * Orphan handling is only valid for files with data blocks
 	 * being truncated, or files being unlinked. Note that we either
@@ -3009,6 +3011,8 @@ int ext4_orphan_del(handle_t *handle, struct inode *inode)
 	if (list_empty(&ei->i_orphan))
 		return 0;
 
+	ext4_fc_mark_ineligible(inode->i_sb, handle);
+
 	if (handle) {
 		/* Grab inode buffer early before taking global s_orphan_lock */
 		err = ext4_reserve_inode_write(handle, inode, &iloc);
@@ -3198,6 +3202,7 @@ static int ext4_unlink(struct inode *dir, struct dentry *dentry)
 		handle = NULL;
 		goto end_unlink;
 	}
+	ext4_fc_mark_inode_ineligible(inode, handle);
 
 	if (IS_DIRSYNC(dir))
 		ext4_handle_sync(handle);
@@ -3395,6 +3400,7 @@ static int ext4_link(struct dentry *old_dentry,
 		 EXT4_INDEX_EXTRA_TRANS_BLOCKS) + 1);
 	if (IS_ERR(handle))
 		return PTR_ERR(handle);
+	ext4_fc_mark_inode_ineligible(inode, handle);
 
 	if (IS_DIRSYNC(dir))
 		ext4_handle_sync(handle);
@@ -3738,6 +3744,9 @@ static int ext4_rename(struct inode *old_dir, struct dentry *old_dentry,
 			goto end_rename;
 		}
 	}
+	ext4_fc_mark_inode_ineligible(old.inode, handle);
+	if (new.inode)
+		ext4_fc_mark_inode_ineligible(new.inode, handle);
 
 	if (IS_DIRSYNC(old.dir) || IS_DIRSYNC(new.dir))
 		ext4_handle_sync(handle);
@@ -3919,6 +3928,8 @@ static int ext4_cross_rename(struct inode *old_dir, struct dentry *old_dentry,
 		handle = NULL;
 		goto end_rename;
 	}
+	ext4_fc_mark_inode_ineligible(old.inode, handle);
+	ext4_fc_mark_inode_ineligible(new.inode, handle);
 
 	if (IS_DIRSYNC(old.dir) || IS_DIRSYNC(new.dir))
 		ext4_handle_sync(handle);
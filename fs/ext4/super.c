@@ -1098,6 +1098,9 @@ static struct inode *ext4_alloc_inode(struct super_block *sb)
 	spin_lock_init(&ei->i_completed_io_lock);
 	ei->i_sync_tid = 0;
 	ei->i_datasync_tid = 0;
+	ei->i_fc_ineligible_tid = 0;
+	ei->i_fc_copy_seq = 0;
+	ei->i_fc_logged_seq = 0;
 	atomic_set(&ei->i_unwritten, 0);
 	INIT_WORK(&ei->i_rsv_conversion_work, ext4_end_io_rsv_work);
 	return &ei->vfs_inode;
@@ -1141,6 +1144,7 @@ static void init_once(void *foo)
 	init_rwsem(&ei->xattr_sem);
 	init_rwsem(&ei->i_data_sem);
 	init_rwsem(&ei->i_mmap_sem);
+	init_rwsem(&ei->i_fc_rwsem);
 	inode_init_once(&ei->vfs_inode);
 }
 
@@ -4316,6 +4320,7 @@ static int ext4_fill_super(struct super_block *sb, void *data, int silent)
 
 	INIT_LIST_HEAD(&sbi->s_orphan); /* unlinked but open files */
 	mutex_init(&sbi->s_orphan_lock);
+	mutex_init(&sbi->s_fc_lock);
 
 	sb->s_root = NULL;
 
@@ -4384,6 +4389,17 @@ static int ext4_fill_super(struct super_block *sb, void *data, int silent)
 		goto failed_mount_wq;
 	}
 
+	if (ext4_has_feature_fast_commit(sb) &&
+	    jbd2_has_feature_fast_commit(sbi->s_journal)) {
+		if (ext4_has_feature_bigalloc(sb) ||
+		    EXT4_INODE_SIZE(sb) + EXT4_FC_BLOCK_OVERHEAD >
+		    sb->s_blocksize)
+			ext4_msg(sb, KERN_INFO, "fast commits not supported "
+				 "with this filesystem geometry");
+		else
+			set_opt2(sb, JOURNAL_FAST_COMMIT);
+	}
+
 	/* We have now updated the journal if required, so we can
 	 * validate the data journaling mode. */
 	switch (test_opt(sb, DATA_FLAGS)) {
@@ -4715,6 +4731,8 @@ static void ext4_init_journal_params(struct super_block *sb, journal_t *journal)
 	journal->j_commit_interval = sbi->s_commit_interval;
 	journal->j_min_batch_time = sbi->s_min_batch_time;
 	journal->j_max_batch_time = sbi->s_max_batch_time;
+	if (ext4_has_feature_fast_commit(sb))
+		journal->j_fc_replay_callback = ext4_fc_replay;
 
 	write_lock(&journal->j_state_lock);
 	if (test_opt(sb, BARRIER))
@@ -837,6 +837,12 @@ static int parse_options(struct super_block *sb, char *options)
 	}
 #endif
 
+	/* Compressed clusters can't be read or written by this kernel */
+	if (f2fs_sb_has_compression(sbi)) {
+		f2fs_err(sbi, "Filesystem with compression feature is not supported");
+		return -EOPNOTSUPP;
+	}
+
 	if (F2FS_IO_SIZE_BITS(sbi) && !test_opt(sbi, LFS)) {
 		f2fs_err(sbi, "Should set mode=lfs with %uKB-sized IO",
 			 F2FS_IO_SIZE_KB(sbi));
@@ -95,6 +95,9 @@ EXPORT_SYMBOL(jbd2_journal_init_jbd_inode);
 EXPORT_SYMBOL(jbd2_journal_release_jbd_inode);
 EXPORT_SYMBOL(jbd2_journal_begin_ordered_truncate);
 EXPORT_SYMBOL(jbd2_inode_cache);
+EXPORT_SYMBOL(jbd2_fc_begin_commit);
+EXPORT_SYMBOL(jbd2_fc_get_buf);
+EXPORT_SYMBOL(jbd2_fc_end_commit);
 
 static void __journal_abort_soft (journal_t *journal, int errno);
 static int jbd2_journal_create_slab(size_t slab_size);
@@ -763,6 +766,155 @@ int jbd2_complete_transaction(journal_t *journal, tid_t tid)
 }
 EXPORT_SYMBOL(jbd2_complete_transaction);
 
+/**
+ * int jbd2_fc_begin_commit() - Start a fast commit.
+ * @journal: Journal to act on.
+ * @tid: Transaction whose changes the fast commit is going to log.
+ *
+ * A fast commit logs a compact, filesystem-defined record of some of the
+ * changes made by the running transaction into the fast commit area at
+ * the end of the journal, without committing the transaction itself.
+ * It is only possible while @tid is still running and no full commit is
+ * in progress, and the fast commit records stay valid until @tid commits.
+ * On error, the caller has to fall back to jbd2_complete_transaction().
+ */
+int jbd2_fc_begin_commit(journal_t *journal, tid_t tid)
+{
+	int err = 0;
+
+	if (!journal->j_fc_wbuf)
+		return -EOPNOTSUPP;
+
+	write_lock(&journal->j_state_lock);
+	/*
+	 * Recovery only looks at the fast commit area when the on-disk
+	 * superblock says there is a log to recover, so stay away until the
+	 * next full commit after a flush has updated it.
+	 */
+	if (journal->j_flags & (JBD2_ABORT | JBD2_FLUSHED |
+				JBD2_FAST_COMMIT_ONGOING |
+				JBD2_FULL_COMMIT_ONGOING) ||
+	    !journal->j_running_transaction ||
+	    journal->j_running_transaction->t_tid != tid) {
+		err = -EBUSY;
+	} else {
+		journal->j_flags |= JBD2_FAST_COMMIT_ONGOING;
+		journal->j_fc_nbufs = 0;
+	}
+	write_unlock(&journal->j_state_lock);
+	return err;
+}
+
+/**
+ * int jbd2_fc_get_buf() - Get the next block of the fast commit area.
+ * @journal: Journal to act on.
+ * @bh_out: Returns a zeroed, uptodate buffer for the block.
+ *
+ * The buffer is written out by jbd2_fc_end_commit().  Returns -ENOSPC
+ * once the fast commit area is full.
+ */
+int jbd2_fc_get_buf(journal_t *journal, struct buffer_head **bh_out)
+{
+	unsigned long long pblock;
+	unsigned long blocknr;
+	struct buffer_head *bh;
+	int err;
+
+	J_ASSERT(journal->j_flags & JBD2_FAST_COMMIT_ONGOING);
+
+	blocknr = journal->j_fc_first + journal->j_fc_off +
+		  journal->j_fc_nbufs;
+	if (blocknr >= journal->j_fc_last)
+		return -ENOSPC;
+
+	err = jbd2_journal_bmap(journal, blocknr, &pblock);
+	if (err)
+		return err;
+
+	bh = __getblk(journal->j_dev, pblock, journal->j_blocksize);
+	if (!bh)
+		return -ENOMEM;
+
+	lock_buffer(bh);
+	memset(bh->b_data, 0, journal->j_blocksize);
+	set_buffer_uptodate(bh);
+	unlock_buffer(bh);
+
+	journal->j_fc_wbuf[journal->j_fc_nbufs++] = bh;
+	*bh_out = bh;
+	return 0;
+}
+
+static void jbd2_fc_submit_buf(struct buffer_head *bh, int op_flags)
+{
+	lock_buffer(bh);
+	clear_buffer_dirty(bh);
+	set_buffer_uptodate(bh);
+	bh->b_end_io = end_buffer_write_sync;
+	get_bh(bh);
+	submit_bh(REQ_OP_WRITE, op_flags, bh);
+}
+
+/**
+ * int jbd2_fc_end_commit() - Finish a fast commit.
+ * @journal: Journal to act on.
+ * @fallback: Drop the blocks instead of writing them.
+ *
+ * Writes out the blocks handed out by jbd2_fc_get_buf() and waits for them
+ * to reach stable storage.  The block holding the end of the fast commit
+ * goes out last, behind a cache flush, so that it is never found on disk
+ * without everything it covers.  If @fallback is set or the write fails,
+ * the fast commit area is rewound; the caller must then fall back to a
+ * full commit.
+ */
+int jbd2_fc_end_commit(journal_t *journal, bool fallback)
+{
+	int nbufs = journal->j_fc_nbufs;
+	int flags = REQ_SYNC;
+	struct buffer_head *bh;
+	int i, err = 0;
+
+	if (!fallback && nbufs) {
+		for (i = 0; i < nbufs - 1; i++)
+			jbd2_fc_submit_buf(journal->j_fc_wbuf[i], REQ_SYNC);
+		for (i = 0; i < nbufs - 1; i++) {
+			bh = journal->j_fc_wbuf[i];
+			wait_on_buffer(bh);
+			if (unlikely(!buffer_uptodate(bh)))
+				err = -EIO;
+		}
+
+		if (journal->j_flags & JBD2_BARRIER) {
+			if (journal->j_fs_dev != journal->j_dev)
+				blkdev_issue_flush(journal->j_fs_dev, GFP_NOFS,
+						   NULL);
+			flags |= REQ_PREFLUSH | REQ_FUA;
+		}
+		if (!err) {
+			bh = journal->j_fc_wbuf[nbufs - 1];
+			jbd2_fc_submit_buf(bh, flags);
+			wait_on_buffer(bh);
+			if (unlikely(!buffer_uptodate(bh)))
+				err = -EIO;
+		}
+	}
+
+	for (i = 0; i < nbufs; i++) {
+		brelse(journal->j_fc_wbuf[i]);
+		journal->j_fc_wbuf[i] = NULL;
+	}
+
+	write_lock(&journal->j_state_lock);
+	if (!fallback && !err)
+		journal->j_fc_off += nbufs;
+	journal->j_fc_nbufs = 0;
+	journal->j_flags &= ~JBD2_FAST_COMMIT_ONGOING;
+	write_unlock(&journal->j_state_lock);
+	wake_up(&journal->j_fc_wait);
+
+	return err;
+}
+
 /*
  * Log buffer allocation routines:
  */
@@ -1137,6 +1289,7 @@ static journal_t *journal_init_common(struct block_device *bdev,
 	init_waitqueue_head(&journal->j_wait_commit);
 	init_waitqueue_head(&journal->j_wait_updates);
 	init_waitqueue_head(&journal->j_wait_reserved);
+	init_waitqueue_head(&journal->j_fc_wait);
 	mutex_init(&journal->j_barrier);
 	mutex_init(&journal->j_checkpoint_mutex);
 	spin_lock_init(&journal->j_revoke_lock);
@@ -1285,6 +1438,30 @@ static void journal_fail_superblock (journal_t *journal)
 	journal->j_sb_buffer = NULL;
 }
 
+/*
+ * With fast commits enabled, the tail end of the journal is set aside for
+ * fast commit blocks.  Returns the end of the area left for the log proper.
+ */
+static unsigned long long journal_fc_reserve(journal_t *journal,
+					     unsigned long long last)
+{
+	unsigned long num_fc_blks;
+
+	if (!jbd2_has_feature_fast_commit(journal))
+		return last;
+
+	num_fc_blks = be32_to_cpu(journal->j_superblock->s_num_fc_blks);
+	if (!num_fc_blks)
+		num_fc_blks = JBD2_DEFAULT_FAST_COMMIT_BLOCKS;
+	if (num_fc_blks >= last)
+		return 0;
+
+	journal->j_fc_last = last;
+	journal->j_fc_first = last - num_fc_blks + 1;
+	journal->j_fc_off = 0;
+	return last - num_fc_blks;
+}
+
 /*
  * Given a journal_t structure, initialise the various fields for
  * startup of a new journaling session.  We use this both when creating
@@ -1298,7 +1475,7 @@ static int journal_reset(journal_t *journal)
 	unsigned long long first, last;
 
 	first = be32_to_cpu(sb->s_first);
-	last = be32_to_cpu(sb->s_maxlen);
+	last = journal_fc_reserve(journal, be32_to_cpu(sb->s_maxlen));
 	if (first + JBD2_MIN_JOURNAL_BLOCKS > last + 1) {
 		printk(KERN_ERR "JBD2: Journal too short (blocks %llu-%llu).\n",
 		       first, last);
@@ -1653,9 +1830,28 @@ static int load_superblock(journal_t *journal)
 	journal->j_tail_sequence = be32_to_cpu(sb->s_sequence);
 	journal->j_tail = be32_to_cpu(sb->s_start);
 	journal->j_first = be32_to_cpu(sb->s_first);
-	journal->j_last = be32_to_cpu(sb->s_maxlen);
+	journal->j_last = journal_fc_reserve(journal,
+					     be32_to_cpu(sb->s_maxlen));
 	journal->j_errno = be32_to_cpu(sb->s_errno);
 
+	if (jbd2_has_feature_fast_commit(journal)) {
+		if (journal->j_first + JBD2_MIN_JOURNAL_BLOCKS >
+		    journal->j_last + 1) {
+			printk(KERN_ERR "JBD2: Journal too short for %lu fast "
+			       "commit blocks.\n",
+			       journal->j_fc_last - journal->j_fc_first + 1);
+			return -EINVAL;
+		}
+		if (!journal->j_fc_wbuf) {
+			journal->j_fc_wbuf = kmalloc_array(
+					journal->j_fc_last - journal->j_fc_first,
+					sizeof(struct buffer_head *),
+					GFP_KERNEL);
+			if (!journal->j_fc_wbuf)
+				return -ENOMEM;
+		}
+	}
+
 	return 0;
 }
 
@@ -1795,6 +1991,7 @@ int jbd2_journal_destroy(journal_t *journal)
 		jbd2_journal_destroy_revoke(journal);
 	if (journal->j_chksum_driver)
 		crypto_free_shash(journal->j_chksum_driver);
+	kfree(journal->j_fc_wbuf);
 	kfree(journal->j_wbuf);
 	kfree(journal);
 
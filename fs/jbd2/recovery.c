@@ -35,11 +35,12 @@ struct recovery_info
 	int		nr_revoke_hits;
 };
 
-enum passtype {PASS_SCAN, PASS_REVOKE, PASS_REPLAY};
 static int do_one_pass(journal_t *journal,
 				struct recovery_info *info, enum passtype pass);
 static int scan_revoke_records(journal_t *, struct buffer_head *,
 				tid_t, struct recovery_info *);
+static int fc_do_one_pass(journal_t *journal,
+			  struct recovery_info *info, enum passtype pass);
 
 #ifdef __KERNEL__
 
@@ -269,6 +270,10 @@ int jbd2_journal_recover(journal_t *journal)
 		err = do_one_pass(journal, &info, PASS_REVOKE);
 	if (!err)
 		err = do_one_pass(journal, &info, PASS_REPLAY);
+	if (!err)
+		err = fc_do_one_pass(journal, &info, PASS_SCAN);
+	if (!err)
+		err = fc_do_one_pass(journal, &info, PASS_REPLAY);
 
 	jbd_debug(1, "JBD2: recovery, exit status %d, "
 		  "recovered transactions %u to %u\n",
@@ -334,6 +339,49 @@ int jbd2_journal_skip_recovery(journal_t *journal)
 	return err;
 }
 
+/*
+ * Hand the fast commit area to the filesystem, block by block.  Only fast
+ * commits of the transaction following the last one found in the log are
+ * valid; the filesystem checks that against the expected tid.
+ */
+static int fc_do_one_pass(journal_t *journal,
+			  struct recovery_info *info, enum passtype pass)
+{
+	unsigned long next_fc_block = journal->j_fc_first;
+	struct buffer_head *bh;
+	int err = 0;
+
+	if (!jbd2_has_feature_fast_commit(journal) ||
+	    !journal->j_fc_replay_callback)
+		return 0;
+
+	jbd_debug(1, "JBD2: fast commit %s pass, expected tid %u\n",
+		  pass == PASS_SCAN ? "scan" : "replay", info->end_transaction);
+
+	while (next_fc_block < journal->j_fc_last) {
+		err = jread(&bh, journal, next_fc_block);
+		if (err) {
+			printk(KERN_ERR "JBD2: IO error %d recovering fast "
+			       "commit block %lu\n", err, next_fc_block);
+			break;
+		}
+
+		err = journal->j_fc_replay_callback(journal, bh, pass,
+					next_fc_block - journal->j_fc_first,
+					info->end_transaction);
+		brelse(bh);
+		if (err)
+			break;
+		next_fc_block++;
+	}
+
+	if (err > 0)
+		err = 0;
+	if (err)
+		printk(KERN_ERR "JBD2: fast commit replay failed: %d\n", err);
+	return err;
+}
+
 static inline unsigned long long read_tag_block(journal_t *journal,
 						journal_block_tag_t *tag)
 {
@@ -58,6 +58,21 @@ static int show_console_dev(struct seq_file *m, void *v)
 	return 0;
 }
 
+/*
+ * Backlog of each console, in log records: how many are currently waiting
+ * to be written to it, and the most that were ever waiting behind a write.
+ */
+static int show_console_lag(struct seq_file *m, void *v)
+{
+	struct console *con = v;
+
+	seq_setwidth(m, 21 - 1);
+	seq_printf(m, "%s%d", con->name, con->index);
+	seq_pad(m, ' ');
+	seq_printf(m, "%llu %llu\n", console_lag(con), con->max_lag);
+	return 0;
+}
+
 static void *c_start(struct seq_file *m, loff_t *pos)
 {
 	struct console *con;
@@ -90,9 +105,17 @@ static const struct seq_operations consoles_op = {
 	.show	= show_console_dev
 };
 
+static const struct seq_operations console_lag_op = {
+	.start	= c_start,
+	.next	= c_next,
+	.stop	= c_stop,
+	.show	= show_console_lag
+};
+
 static int __init proc_consoles_init(void)
 {
 	proc_create_seq("consoles", 0, NULL, &consoles_op);
+	proc_create_seq("console_lag", 0, NULL, &console_lag_op);
 	return 0;
 }
 fs_initcall(proc_consoles_init);
@@ -155,6 +155,8 @@ struct console {
 	int	cflag;
 	void	*data;
 	struct	 console *next;
+	u64	seq;		/* next log record to be written */
+	u64	max_lag;	/* most records seen pending behind a write */
 };
 
 /*
@@ -178,6 +180,7 @@ extern struct console *console_drivers;
 extern void console_lock(void);
 extern int console_trylock(void);
 extern void console_unlock(void);
+extern u64 console_lag(struct console *con);
 extern void console_conditional_schedule(void);
 extern void console_unblank(void);
 extern void console_flush_on_panic(enum con_flush_mode mode);
@@ -33,6 +33,30 @@
 
 #define SJA1105_HWTS_RX_EN			0
 
+/* IEEE 1588 Annex F: peer delay mechanism messages */
+#define SJA1105_PTP_PDELAY_DMAC			0x0180C200000Eull
+
+/* Link-local destinations for which a management route is kept pre-armed
+ * towards the port that last transmitted to them.
+ */
+#define SJA1105_NUM_STICKY_ROUTES		2
+
+enum sja1105_sticky_route_state {
+	SJA1105_STICKY_ROUTE_IDLE = 0,
+	/* Installed in hardware, can be consumed by the tagger */
+	SJA1105_STICKY_ROUTE_ARMED,
+	/* Consumed by the tagger, awaiting confirmation from the switch */
+	SJA1105_STICKY_ROUTE_INFLIGHT,
+};
+
+struct sja1105_sticky_route {
+	enum sja1105_sticky_route_state state;
+	/* TX timestamp request of the frame that consumed the route */
+	struct sk_buff *clone;
+	u64 dmac;
+	int port;
+};
+
 /* Global tagger data: each struct sja1105_port has a reference to
  * the structure defined in struct sja1105_private.
  */
@@ -43,6 +67,11 @@ struct sja1105_tagger_data {
 	 */
 	spinlock_t meta_lock;
 	unsigned long state;
+	struct sja1105_sticky_route sticky_routes[SJA1105_NUM_STICKY_ROUTES];
+	/* Protects the state, port and clone of the sticky routes against
+	 * concurrent consumption by the taggers of multiple ports.
+	 */
+	spinlock_t sticky_lock;
 };
 
 struct sja1105_skb_cb {
@@ -55,6 +84,7 @@ struct sja1105_skb_cb {
 struct sja1105_port {
 	struct kthread_worker *xmit_worker;
 	struct kthread_work xmit_work;
+	struct kthread_work rearm_work;
 	struct sk_buff_head xmit_queue;
 	struct sja1105_tagger_data *data;
 	struct dsa_port *dp;
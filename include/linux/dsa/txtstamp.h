@@ -0,0 +1,183 @@
+/* SPDX-License-Identifier: GPL-2.0
+ * Copyright (c) 2019, Vladimir Oltean <olteanv@gmail.com>
+ */
+
+/* Helpers for switches which tag TX timestamp requests with a small hardware
+ * ID (which is reported back together with the timestamp). Instead of walking
+ * a list of pending skbs for every timestamp, the pending requests of a port
+ * are kept in an array indexed by that ID, so matching is O(1).
+ *
+ * Since the ID space is small and wraps around, a request which is still
+ * pending when its ID is reused is considered lost (overrun). Requests for
+ * which no timestamp came in time are reaped (timeouts), and timestamps for
+ * which no request could be found are counted as well (orphans).
+ *
+ * These are inline so that they can be used by switch libraries shared
+ * between DSA and non-DSA drivers.
+ */
+
+#ifndef _NET_DSA_TXTSTAMP_H
+#define _NET_DSA_TXTSTAMP_H
+
+#include <linux/jiffies.h>
+#include <linux/log2.h>
+#include <linux/netdevice.h>
+#include <linux/skbuff.h>
+#include <linux/spinlock.h>
+
+#define DSA_TXTSTAMP_MAX_IDS		64
+
+struct dsa_txtstamp_stats {
+	u64 requests;
+	u64 matched;
+	u64 orphans;
+	u64 timeouts;
+	u64 overruns;
+};
+
+struct dsa_txtstamp_ring {
+	struct sk_buff *skb[DSA_TXTSTAMP_MAX_IDS];
+	unsigned long deadline[DSA_TXTSTAMP_MAX_IDS];
+	unsigned int id_mask;
+	unsigned int next_id;
+	unsigned int pending;
+	unsigned long timeout;
+	struct dsa_txtstamp_stats stats;
+	/* Requests are added from the xmit path and matched from the
+	 * timestamp interrupt.
+	 */
+	spinlock_t lock;
+};
+
+/* @num_ids must be a power of 2 no larger than DSA_TXTSTAMP_MAX_IDS,
+ * @timeout is in jiffies.
+ */
+static inline void dsa_txtstamp_ring_init(struct dsa_txtstamp_ring *ring,
+					  unsigned int num_ids,
+					  unsigned long timeout)
+{
+	WARN_ON(!is_power_of_2(num_ids) || num_ids > DSA_TXTSTAMP_MAX_IDS);
+
+	memset(ring, 0, sizeof(*ring));
+	spin_lock_init(&ring->lock);
+	ring->id_mask = num_ids - 1;
+	ring->timeout = timeout;
+}
+
+/* Takes ownership of @skb and returns the hardware ID to tag it with */
+static inline unsigned int dsa_txtstamp_add(struct dsa_txtstamp_ring *ring,
+					    struct sk_buff *skb)
+{
+	struct sk_buff *old;
+	unsigned long flags;
+	unsigned int id;
+
+	spin_lock_irqsave(&ring->lock, flags);
+
+	id = ring->next_id++ & ring->id_mask;
+	old = ring->skb[id];
+	ring->skb[id] = skb;
+	ring->deadline[id] = jiffies + ring->timeout;
+	ring->stats.requests++;
+	if (old)
+		ring->stats.overruns++;
+	else
+		ring->pending++;
+
+	spin_unlock_irqrestore(&ring->lock, flags);
+
+	if (old)
+		dev_kfree_skb_any(old);
+
+	return id;
+}
+
+/* Returns the skb that requested the timestamp with hardware ID @id, whose
+ * ownership passes to the caller, or NULL if there is none.
+ */
+static inline struct sk_buff *dsa_txtstamp_match(struct dsa_txtstamp_ring *ring,
+						 unsigned int id)
+{
+	struct sk_buff *skb;
+	unsigned long flags;
+
+	id &= ring->id_mask;
+
+	spin_lock_irqsave(&ring->lock, flags);
+
+	skb = ring->skb[id];
+	ring->skb[id] = NULL;
+	if (skb) {
+		ring->stats.matched++;
+		ring->pending--;
+	} else {
+		ring->stats.orphans++;
+	}
+
+	spin_unlock_irqrestore(&ring->lock, flags);
+
+	return skb;
+}
+
+/* Frees the requests whose deadline has passed */
+static inline void dsa_txtstamp_reap(struct dsa_txtstamp_ring *ring)
+{
+	struct sk_buff_head expired;
+	struct sk_buff *skb;
+	unsigned long flags;
+	unsigned int id;
+
+	if (!READ_ONCE(ring->pending))
+		return;
+
+	__skb_queue_head_init(&expired);
+
+	spin_lock_irqsave(&ring->lock, flags);
+
+	for (id = 0; id <= ring->id_mask; id++) {
+		skb = ring->skb[id];
+		if (!skb || time_before(jiffies, ring->deadline[id]))
+			continue;
+
+		ring->skb[id] = NULL;
+		ring->stats.timeouts++;
+		ring->pending--;
+		__skb_queue_tail(&expired, skb);
+	}
+
+	spin_unlock_irqrestore(&ring->lock, flags);
+
+	while ((skb = __skb_dequeue(&expired)) != NULL)
+		dev_kfree_skb_any(skb);
+}
+
+static inline void dsa_txtstamp_purge(struct dsa_txtstamp_ring *ring)
+{
+	unsigned long flags;
+	unsigned int id;
+
+	spin_lock_irqsave(&ring->lock, flags);
+
+	for (id = 0; id <= ring->id_mask; id++) {
+		if (!ring->skb[id])
+			continue;
+
+		dev_kfree_skb_any(ring->skb[id]);
+		ring->skb[id] = NULL;
+	}
+	ring->pending = 0;
+
+	spin_unlock_irqrestore(&ring->lock, flags);
+}
+
+static inline void dsa_txtstamp_get_stats(struct dsa_txtstamp_ring *ring,
+					  struct dsa_txtstamp_stats *stats)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&ring->lock, flags);
+	*stats = ring->stats;
+	spin_unlock_irqrestore(&ring->lock, flags);
+}
+
+#endif /* _NET_DSA_TXTSTAMP_H */
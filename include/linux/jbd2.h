@@ -262,7 +262,10 @@ typedef struct journal_superblock_s
 /* 0x0050 */
 	__u8	s_checksum_type;	/* checksum type */
 	__u8	s_padding2[3];
-	__u32	s_padding[42];
+/* 0x0054 */
+	__be32	s_num_fc_blks;		/* Number of fast commit blocks */
+/* 0x0058 */
+	__u32	s_padding[41];
 	__be32	s_checksum;		/* crc32c(superblock) */
 
 /* 0x0100 */
@@ -288,6 +291,7 @@ typedef struct journal_superblock_s
 #define JBD2_FEATURE_INCOMPAT_ASYNC_COMMIT	0x00000004
 #define JBD2_FEATURE_INCOMPAT_CSUM_V2		0x00000008
 #define JBD2_FEATURE_INCOMPAT_CSUM_V3		0x00000010
+#define JBD2_FEATURE_INCOMPAT_FAST_COMMIT	0x00000020
 
 /* See "journal feature predicate functions" below */
 
@@ -298,13 +302,20 @@ typedef struct journal_superblock_s
 					JBD2_FEATURE_INCOMPAT_64BIT | \
 					JBD2_FEATURE_INCOMPAT_ASYNC_COMMIT | \
 					JBD2_FEATURE_INCOMPAT_CSUM_V2 | \
-					JBD2_FEATURE_INCOMPAT_CSUM_V3)
+					JBD2_FEATURE_INCOMPAT_CSUM_V3 | \
+					JBD2_FEATURE_INCOMPAT_FAST_COMMIT)
+
+/* Fast commit area size used when the superblock doesn't specify one */
+#define JBD2_DEFAULT_FAST_COMMIT_BLOCKS	256
 
 #ifdef __KERNEL__
 
 #include <linux/fs.h>
 #include <linux/sched.h>
 
+/* Recovery passes; also handed to the fast commit replay callback */
+enum passtype {PASS_SCAN, PASS_REVOKE, PASS_REPLAY};
+
 enum jbd_state_bits {
 	BH_JBD			/* Has an attached ext3 journal_head */
 	  = BH_PrivateStart,
@@ -1065,6 +1076,62 @@ struct journal_s
 	 */
 	int			j_wbufsize;
 
+	/**
+	 * @j_fc_first:
+	 *
+	 * The block number of the first fast commit block in the journal
+	 * [j_state_lock].
+	 */
+	unsigned long		j_fc_first;
+
+	/**
+	 * @j_fc_last:
+	 *
+	 * The block number one beyond the last fast commit block in the
+	 * journal [j_state_lock].
+	 */
+	unsigned long		j_fc_last;
+
+	/**
+	 * @j_fc_off:
+	 *
+	 * Number of fast commit blocks written since the last full commit
+	 * [j_state_lock].
+	 */
+	unsigned long		j_fc_off;
+
+	/**
+	 * @j_fc_wbuf: Array of bhs for the fast commit being written.
+	 */
+	struct buffer_head	**j_fc_wbuf;
+
+	/**
+	 * @j_fc_nbufs:
+	 *
+	 * Number of entries of @j_fc_wbuf used by the fast commit being
+	 * written.
+	 */
+	int			j_fc_nbufs;
+
+	/**
+	 * @j_fc_wait: Wait queue for fast and full commits to finish.
+	 */
+	wait_queue_head_t	j_fc_wait;
+
+	/**
+	 * @j_fc_replay_callback:
+	 *
+	 * Called during recovery for each block of the fast commit area, in
+	 * order, once per scan and replay pass.  Returns 0 to be fed the next
+	 * block, a positive value once the end of the fast commit log has
+	 * been found, or a negative error.
+	 */
+	int			(*j_fc_replay_callback)(journal_t *journal,
+							struct buffer_head *bh,
+							enum passtype pass,
+							int off,
+							tid_t expected_tid);
+
 	/**
 	 * @j_last_sync_writer:
 	 *
@@ -1234,6 +1301,7 @@ JBD2_FEATURE_INCOMPAT_FUNCS(64bit,		64BIT)
 JBD2_FEATURE_INCOMPAT_FUNCS(async_commit,	ASYNC_COMMIT)
 JBD2_FEATURE_INCOMPAT_FUNCS(csum2,		CSUM_V2)
 JBD2_FEATURE_INCOMPAT_FUNCS(csum3,		CSUM_V3)
+JBD2_FEATURE_INCOMPAT_FUNCS(fast_commit,	FAST_COMMIT)
 
 /*
  * Journal flag definitions
@@ -1248,6 +1316,10 @@ JBD2_FEATURE_INCOMPAT_FUNCS(csum3,		CSUM_V3)
 						 * data write error in ordered
 						 * mode */
 #define JBD2_REC_ERR	0x080	/* The errno in the sb has been recorded */
+#define JBD2_FAST_COMMIT_ONGOING	0x100	/* A fast commit is being
+						 * written */
+#define JBD2_FULL_COMMIT_ONGOING	0x200	/* A full commit is in
+						 * progress */
 
 /*
  * Function declarations for the journaling transaction and buffer
@@ -1497,6 +1569,11 @@ int jbd2_complete_transaction(journal_t *journal, tid_t tid);
 int jbd2_log_do_checkpoint(journal_t *journal);
 int jbd2_trans_will_send_data_barrier(journal_t *journal, tid_t tid);
 
+/* Fast commit interface */
+int jbd2_fc_begin_commit(journal_t *journal, tid_t tid);
+int jbd2_fc_get_buf(journal_t *journal, struct buffer_head **bh_out);
+int jbd2_fc_end_commit(journal_t *journal, bool fallback);
+
 void __jbd2_log_wait_for_space(journal_t *journal);
 extern void __jbd2_journal_drop_transaction(journal_t *, transaction_t *);
 extern int jbd2_cleanup_journal_tail(journal_t *);
@@ -23,9 +23,11 @@
 #include <net/switchdev.h>
 
 struct tc_action;
+struct flow_cls_offload;
 struct phy_device;
 struct fixed_phy_status;
 struct phylink_link_state;
+struct dsa_switch_stats;
 
 #define DSA_TAG_PROTO_NONE_VALUE		0
 #define DSA_TAG_PROTO_BRCM_VALUE		1
@@ -80,6 +82,8 @@ struct dsa_device_ops {
 	 */
 	bool (*filter)(const struct sk_buff *skb, struct net_device *dev);
 	unsigned int overhead;
+	/* The tag is appended to the frame rather than inserted before it */
+	bool tail_tag;
 	const char *name;
 	enum dsa_tag_protocol proto;
 };
@@ -266,6 +270,11 @@ struct dsa_switch {
 	/* devlink used to represent this switch device */
 	struct devlink		*devlink;
 
+	/* Hardware port counters harvested by the DSA core, see
+	 * dsa_stats_register()
+	 */
+	struct dsa_switch_stats	*stats;
+
 	/* Number of switch port queues */
 	unsigned int		num_tx_queues;
 
@@ -545,6 +554,10 @@ struct dsa_switch_ops {
 				   struct dsa_mall_mirror_tc_entry *mirror);
 	int	(*port_setup_tc)(struct dsa_switch *ds, int port,
 				 enum tc_setup_type type, void *type_data);
+	int	(*cls_flower_add)(struct dsa_switch *ds, int port,
+				  struct flow_cls_offload *cls, bool ingress);
+	int	(*cls_flower_del)(struct dsa_switch *ds, int port,
+				  struct flow_cls_offload *cls, bool ingress);
 
 	/*
 	 * Cross-chip operations
@@ -607,6 +620,46 @@ struct dsa_devlink_priv {
 	struct dsa_switch *ds;
 };
 
+/* A hardware port counter, as presented to ethtool. @width is the number of
+ * bits after which the hardware counter wraps around. Counters with a @width
+ * of 0 are gauges or flags: they are not accumulated, but reported as last
+ * read.
+ */
+struct dsa_stat_desc {
+	char	name[ETH_GSTRING_LEN];
+	u8	width;
+};
+
+struct dsa_stats_ops {
+	const struct dsa_stat_desc *descs;
+	unsigned int	num_stats;
+	/* Poll period, DSA_STATS_POLL_INTERVAL_MS if 0 */
+	unsigned int	poll_interval_ms;
+
+	/* Read all @num_stats raw hardware counters of @port into @raw,
+	 * in the order of @descs. Called from process context.
+	 */
+	int	(*read)(struct dsa_switch *ds, int port, u64 *raw);
+	/* Optional: translate the accumulated @stats of @port into
+	 * ndo_get_stats64 format. Called with the snapshot being read under
+	 * a seqlock, so it must not sleep and may be called more than once.
+	 */
+	void	(*fill_stats64)(struct dsa_switch *ds, int port,
+				const u64 *stats,
+				struct rtnl_link_stats64 *s);
+};
+
+#define DSA_STATS_POLL_INTERVAL_MS	1000
+
+int dsa_stats_register(struct dsa_switch *ds, const struct dsa_stats_ops *ops);
+void dsa_stats_unregister(struct dsa_switch *ds);
+void dsa_stats_hw_reset_begin(struct dsa_switch *ds);
+void dsa_stats_hw_reset_end(struct dsa_switch *ds, bool cleared);
+void dsa_stats_get_strings(struct dsa_switch *ds, int port,
+			   u32 stringset, u8 *data);
+void dsa_stats_get_ethtool_stats(struct dsa_switch *ds, int port, u64 *data);
+int dsa_stats_get_sset_count(struct dsa_switch *ds, int port, int sset);
+
 struct dsa_switch_driver {
 	struct list_head	list;
 	const struct dsa_switch_ops *ops;
@@ -14,6 +14,10 @@ struct tcf_police_params {
 	bool			rate_present;
 	struct psched_ratecfg	peak;
 	bool			peak_present;
+	u32			tcfp_flags;
+	/* Scalable mode: per-CPU token caches, refilled by tcfp_chunk */
+	s64 __percpu		*tcfp_pcpu_toks;
+	s64			tcfp_chunk;
 	struct rcu_head rcu;
 };
 
@@ -25,6 +29,10 @@ struct tcf_police {
 	s64			tcfp_toks;
 	s64			tcfp_ptoks;
 	s64			tcfp_t_c;
+	/* Scalable mode: the shared bucket, as the theoretical arrival time
+	 * of the next packet. It is full once this is in the past.
+	 */
+	atomic64_t		tcfp_tat;
 };
 
 #define to_police(pc) ((struct tcf_police *)pc)
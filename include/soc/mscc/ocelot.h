@@ -9,6 +9,7 @@
 #include <linux/net_tstamp.h>
 #include <linux/if_vlan.h>
 #include <linux/regmap.h>
+#include <linux/dsa/txtstamp.h>
 #include <net/dsa.h>
 
 #define IFH_INJ_BYPASS			BIT(31)
@@ -418,8 +419,7 @@ struct ocelot_port {
 	u16				vid;
 
 	u8				ptp_cmd;
-	struct sk_buff_head		tx_skbs;
-	u8				ts_id;
+	struct dsa_txtstamp_ring	tx_tstamps;
 
 	phy_interface_t			phy_mode;
 };
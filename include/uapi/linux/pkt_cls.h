@@ -112,6 +112,7 @@ enum tca_id {
 	TCA_ID_CTINFO,
 	TCA_ID_MPLS,
 	TCA_ID_CT,
+	TCA_ID_GATE,
 	/* other actions go here */
 	__TCA_ID_MAX = 255
 };
@@ -167,12 +168,20 @@ enum {
 	TCA_POLICE_PAD,
 	TCA_POLICE_RATE64,
 	TCA_POLICE_PEAKRATE64,
+	TCA_POLICE_FLAGS,	/* u32, TCA_POLICE_FLAG_* */
 	__TCA_POLICE_MAX
 #define TCA_POLICE_RESULT TCA_POLICE_RESULT
 };
 
 #define TCA_POLICE_MAX (__TCA_POLICE_MAX - 1)
 
+/* Let each CPU consume tokens from a local cache, refilled in chunks from
+ * the shared bucket, instead of serializing all CPUs on the bucket. The
+ * burst may be exceeded by up to half of its size. Not valid with a peak
+ * rate.
+ */
+#define TCA_POLICE_FLAG_SCALABLE	(1 << 0)
+
 /* tca flags definitions */
 #define TCA_CLS_FLAGS_SKIP_HW	(1 << 0) /* don't offload filter to HW */
 #define TCA_CLS_FLAGS_SKIP_SW	(1 << 1) /* don't use filter in SW */
@@ -718,6 +718,7 @@ enum {
 	TCA_MQPRIO_SHAPER,
 	TCA_MQPRIO_MIN_RATE64,
 	TCA_MQPRIO_MAX_RATE64,
+	TCA_MQPRIO_TC_ESTIMATOR,	/* struct tc_estimator */
 	__TCA_MQPRIO_MAX,
 };
 
@@ -0,0 +1,49 @@
+/* SPDX-License-Identifier: GPL-2.0 WITH Linux-syscall-note */
+/* Copyright 2020 NXP */
+
+#ifndef __LINUX_TC_GATE_H
+#define __LINUX_TC_GATE_H
+
+#include <linux/pkt_cls.h>
+
+struct tc_gate {
+	tc_gen;
+};
+
+enum {
+	TCA_GATE_ENTRY_UNSPEC,
+	TCA_GATE_ENTRY_INDEX,		/* u32 */
+	TCA_GATE_ENTRY_GATE,		/* flag; the gate is open */
+	TCA_GATE_ENTRY_INTERVAL,	/* u32; in ns */
+	TCA_GATE_ENTRY_IPV,		/* s32; internal priority value, -1 for
+					 * none
+					 */
+	TCA_GATE_ENTRY_MAX_OCTETS,	/* s32; -1 for no limit */
+	__TCA_GATE_ENTRY_MAX,
+};
+#define TCA_GATE_ENTRY_MAX (__TCA_GATE_ENTRY_MAX - 1)
+
+enum {
+	TCA_GATE_ONE_ENTRY_UNSPEC,
+	TCA_GATE_ONE_ENTRY,		/* nested TCA_GATE_ENTRY_* */
+	__TCA_GATE_ONE_ENTRY_MAX,
+};
+#define TCA_GATE_ONE_ENTRY_MAX (__TCA_GATE_ONE_ENTRY_MAX - 1)
+
+enum {
+	TCA_GATE_UNSPEC,
+	TCA_GATE_TM,			/* struct tcf_t */
+	TCA_GATE_PARMS,			/* struct tc_gate */
+	TCA_GATE_PAD,
+	TCA_GATE_PRIORITY,		/* s32; for hardware offload */
+	TCA_GATE_ENTRY_LIST,		/* nested TCA_GATE_ONE_ENTRY */
+	TCA_GATE_BASE_TIME,		/* u64; in ns, on TCA_GATE_CLOCKID */
+	TCA_GATE_CYCLE_TIME,		/* u64; in ns */
+	TCA_GATE_CYCLE_TIME_EXT,	/* u64; in ns */
+	TCA_GATE_FLAGS,			/* u32 */
+	TCA_GATE_CLOCKID,		/* s32 */
+	__TCA_GATE_MAX,
+};
+#define TCA_GATE_MAX (__TCA_GATE_MAX - 1)
+
+#endif
@@ -43,6 +43,7 @@
 #include <linux/rculist.h>
 #include <linux/poll.h>
 #include <linux/irq_work.h>
+#include <linux/kthread.h>
 #include <linux/ctype.h>
 #include <linux/uio.h>
 #include <linux/sched/clock.h>
@@ -1766,7 +1767,7 @@ static int console_trylock_spinning(void)
  * The console_lock must be held.
  */
 static void call_console_drivers(const char *ext_text, size_t ext_len,
-				 const char *text, size_t len)
+				 const char *text, size_t len, u64 lag)
 {
 	struct console *con;
 
@@ -1789,6 +1790,26 @@ static void call_console_drivers(const char *ext_text, size_t ext_len,
 			con->write(con, ext_text, ext_len);
 		else
 			con->write(con, text, len);
+
+		if (lag > con->max_lag)
+			con->max_lag = lag;
+	}
+}
+
+/*
+ * Records are consumed for all consoles at once, whether they were written,
+ * suppressed by the console loglevel or skipped by a disabled console.
+ * While a new console replays older records on its own, the others already
+ * are past them, hence the seq only ever moves forward.
+ * The console_lock must be held.
+ */
+static void console_update_seq(void)
+{
+	struct console *con;
+
+	for_each_console(con) {
+		if (con->seq < console_seq)
+			con->seq = console_seq;
 	}
 }
 
@@ -1806,6 +1827,31 @@ static inline void printk_delay(void)
 	}
 }
 
+/*
+ * Once the printk kthread is running, the console output of printk() is
+ * pushed out by it instead of by the caller, so that whoever logs a message
+ * doesn't have to wait for slow consoles. Output is still printed
+ * synchronously when the kthread might never get to run: during oops and
+ * panic, while the system is going down, and when booted with
+ * printk.synchronous=1.
+ */
+static struct task_struct *printk_kthread __read_mostly;
+static bool printk_synchronous;
+module_param_named(synchronous, printk_synchronous, bool, S_IRUGO);
+MODULE_PARM_DESC(synchronous, "print to the consoles from the printk() caller");
+
+static bool printk_offload_possible(void)
+{
+	if (printk_synchronous || !READ_ONCE(printk_kthread))
+		return false;
+
+	if (oops_in_progress ||
+	    atomic_read(&panic_cpu) != PANIC_CPU_INVALID)
+		return false;
+
+	return system_state <= SYSTEM_RUNNING;
+}
+
 static inline u32 printk_caller_id(void)
 {
 	return in_task() ? task_pid_nr(current) :
@@ -1980,7 +2026,13 @@ asmlinkage int vprintk_emit(int facility, int level,
 	logbuf_unlock_irqrestore(flags);
 
 	/* If called from the scheduler, we can not call up(). */
-	if (!in_sched && pending_output) {
+	if (!in_sched && pending_output && printk_offload_possible()) {
+		/*
+		 * Leave the printing to the printk kthread. It is woken up
+		 * from irq_work, since the caller may hold scheduler locks.
+		 */
+		defer_console_output();
+	} else if (!in_sched && pending_output) {
 		/*
 		 * Disable preemption to avoid being preempted while holding
 		 * console_sem which would prevent anyone from printing to
@@ -2087,7 +2139,8 @@ static ssize_t msg_print_ext_body(char *buf, size_t size,
 static void console_lock_spinning_enable(void) { }
 static int console_lock_spinning_disable_and_check(void) { return 0; }
 static void call_console_drivers(const char *ext_text, size_t ext_len,
-				 const char *text, size_t len) {}
+				 const char *text, size_t len, u64 lag) {}
+static void console_update_seq(void) { }
 static size_t msg_print_text(const struct printk_log *msg, bool syslog,
 			     bool time, char *buf, size_t size) { return 0; }
 static bool suppress_message_printing(int level) { return false; }
@@ -2242,7 +2295,7 @@ void suspend_console(void)
 		return;
 	pr_info("Suspending console(s) (use no_console_suspend to debug)\n");
 	console_lock();
-	console_suspended = 1;
+	WRITE_ONCE(console_suspended, 1);
 	up_console_sem();
 }
 
@@ -2251,7 +2304,7 @@ void resume_console(void)
 	if (!console_suspend_enabled)
 		return;
 	down_console_sem();
-	console_suspended = 0;
+	WRITE_ONCE(console_suspended, 0);
 	console_unlock();
 }
 
@@ -2409,6 +2462,7 @@ void console_unlock(void)
 		struct printk_log *msg;
 		size_t ext_len = 0;
 		size_t len;
+		u64 lag;
 
 		printk_safe_enter_irqsave(flags);
 		raw_spin_lock(&logbuf_lock);
@@ -2436,6 +2490,7 @@ void console_unlock(void)
 			 */
 			console_idx = log_next(console_idx);
 			console_seq++;
+			console_update_seq();
 			goto skip;
 		}
 
@@ -2459,6 +2514,7 @@ void console_unlock(void)
 		}
 		console_idx = log_next(console_idx);
 		console_seq++;
+		lag = log_next_seq - console_seq;
 		raw_spin_unlock(&logbuf_lock);
 
 		/*
@@ -2470,9 +2526,11 @@ void console_unlock(void)
 		console_lock_spinning_enable();
 
 		stop_critical_timings();	/* don't trace print latency */
-		call_console_drivers(ext_text, ext_len, text, len);
+		call_console_drivers(ext_text, ext_len, text, len, lag);
 		start_critical_timings();
 
+		console_update_seq();
+
 		if (console_lock_spinning_disable_and_check()) {
 			printk_safe_exit_irqrestore(flags);
 			return;
@@ -2506,6 +2564,26 @@ void console_unlock(void)
 }
 EXPORT_SYMBOL(console_unlock);
 
+/**
+ * console_lag - number of log records not yet written to a console
+ * @con: the console
+ *
+ * This includes records which were dropped from the log buffer before
+ * they could be written. The worst value seen so far, at the time of a
+ * write, is kept in @con->max_lag.
+ */
+u64 console_lag(struct console *con)
+{
+	unsigned long flags;
+	u64 lag;
+
+	logbuf_lock_irqsave(flags);
+	lag = log_next_seq - con->seq;
+	logbuf_unlock_irqrestore(flags);
+
+	return lag;
+}
+
 /**
  * console_conditional_schedule - yield the CPU if required
  *
@@ -2785,6 +2863,7 @@ void register_console(struct console *newcon)
 		exclusive_console_stop_seq = console_seq;
 		logbuf_unlock_irqrestore(flags);
 	}
+	newcon->seq = console_seq;
 	console_unlock();
 	console_sysfs_notify();
 
@@ -2950,8 +3029,10 @@ static void wake_up_klogd_work_func(struct irq_work *irq_work)
 	int pending = __this_cpu_xchg(printk_pending, 0);
 
 	if (pending & PRINTK_PENDING_OUTPUT) {
+		if (printk_offload_possible())
+			wake_up_process(printk_kthread);
 		/* If trylock fails, someone else is doing the printing */
-		if (console_trylock())
+		else if (console_trylock())
 			console_unlock();
 	}
 
@@ -2974,6 +3055,53 @@ void wake_up_klogd(void)
 	preempt_enable();
 }
 
+static bool console_output_pending(void)
+{
+	unsigned long flags;
+	bool pending;
+
+	logbuf_lock_irqsave(flags);
+	pending = console_seq != log_next_seq;
+	logbuf_unlock_irqrestore(flags);
+
+	/* Written under console_sem, which the caller doesn't hold */
+	return pending && !READ_ONCE(console_suspended);
+}
+
+static int printk_kthread_func(void *data)
+{
+	while (!kthread_should_stop()) {
+		set_current_state(TASK_INTERRUPTIBLE);
+		if (!console_output_pending() && !kthread_should_stop())
+			schedule();
+		__set_current_state(TASK_RUNNING);
+
+		console_lock();
+		console_unlock();
+	}
+
+	return 0;
+}
+
+static int __init printk_kthread_init(void)
+{
+	struct task_struct *task;
+
+	if (printk_synchronous)
+		return 0;
+
+	task = kthread_run(printk_kthread_func, NULL, "printk");
+	if (IS_ERR(task)) {
+		pr_err("unable to create printing thread, printing synchronously\n");
+		return PTR_ERR(task);
+	}
+
+	WRITE_ONCE(printk_kthread, task);
+
+	return 0;
+}
+late_initcall(printk_kthread_init);
+
 void defer_console_output(void)
 {
 	preempt_disable();
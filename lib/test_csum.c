@@ -0,0 +1,131 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Test cases and benchmark for the architecture's csum_partial()
+ */
+#define pr_fmt(fmt) KBUILD_MODNAME ": " fmt
+
+#include <linux/bottom_half.h>
+#include <linux/ktime.h>
+#include <linux/module.h>
+#include <linux/random.h>
+#include <linux/sizes.h>
+#include <linux/slab.h>
+#include <net/checksum.h>
+
+#define BUF_SIZE	SZ_16K
+#define BENCH_ITERS	10000
+
+static const int bench_lens[] = { 64, 256, 1500, 4096, 9000 };
+
+/*
+ * Native endian 16-bit words paired from the start of the buffer, the odd
+ * byte at the end being padded with a zero, whatever the alignment.
+ */
+static u16 csum_ref(const u8 *buff, int len)
+{
+	u32 sum = 0;
+	int i;
+
+	for (i = 0; i < len; i += 2) {
+		u16 word = 0;
+
+		memcpy(&word, buff + i, min(len - i, 2));
+		sum += word;
+	}
+
+	while (sum >> 16)
+		sum = (sum & 0xffff) + (sum >> 16);
+
+	return ~sum;
+}
+
+static int __init test_csum_correctness(const u8 *buf)
+{
+	int offset, len, failed = 0;
+
+	for (offset = 0; offset < 8; offset++) {
+		for (len = 0; len < BUF_SIZE - 8; len += len < 256 ? 1 : 61) {
+			u16 expected = csum_ref(buf + offset, len);
+			u16 actual;
+
+			actual = (__force u16)csum_fold(csum_partial(buf + offset,
+								     len, 0));
+			if (actual == expected)
+				continue;
+
+			if (!failed++)
+				pr_err("offset %d len %d: got 0x%04x, expected 0x%04x\n",
+				       offset, len, actual, expected);
+		}
+	}
+
+	return failed;
+}
+
+/*
+ * With bh set, every call is made with softirqs disabled, like from the
+ * network receive path. Some architectures can't use their SIMD version
+ * there.
+ */
+static void __init test_csum_bench(const u8 *buf, bool bh)
+{
+	int i, j;
+
+	for (i = 0; i < ARRAY_SIZE(bench_lens); i++) {
+		__wsum sum = 0;
+		ktime_t start;
+		u64 ns;
+
+		start = ktime_get();
+		for (j = 0; j < BENCH_ITERS; j++) {
+			if (bh)
+				local_bh_disable();
+			sum = csum_partial(buf, bench_lens[i], sum);
+			if (bh)
+				local_bh_enable();
+		}
+		ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+		/* Keep the compiler from discarding the loop */
+		OPTIMIZER_HIDE_VAR(sum);
+
+		pr_info("%s len %5d: %llu ns per call, %llu MB/s\n",
+			bh ? "softirq" : "process", bench_lens[i],
+			div_u64(ns, BENCH_ITERS),
+			ns ? div64_u64((u64)bench_lens[i] * BENCH_ITERS * 1000,
+				       ns) : 0);
+	}
+}
+
+static int __init test_csum_init(void)
+{
+	int failed;
+	u8 *buf;
+
+	buf = kmalloc(BUF_SIZE, GFP_KERNEL);
+	if (!buf)
+		return -ENOMEM;
+
+	prandom_bytes(buf, BUF_SIZE);
+
+	failed = test_csum_correctness(buf);
+	if (failed) {
+		pr_err("%d test cases failed\n", failed);
+	} else {
+		test_csum_bench(buf, false);
+		test_csum_bench(buf, true);
+	}
+
+	kfree(buf);
+
+	return failed ? -EINVAL : 0;
+}
+
+static void __exit test_csum_exit(void)
+{
+}
+
+module_init(test_csum_init);
+module_exit(test_csum_exit);
+
+MODULE_LICENSE("GPL");
@@ -1120,6 +1120,87 @@ isolate_migratepages_range(struct compact_control *cc, unsigned long start_pfn,
 #endif /* CONFIG_COMPACTION || CONFIG_CMA */
 #ifdef CONFIG_COMPACTION
 
+/*
+ * Fragmentation score check interval for proactive compaction purposes.
+ */
+static const unsigned int FRAG_CHECK_INTERVAL_MSEC = 500;
+
+/*
+ * Page order with respect to which proactive compaction calculates external
+ * fragmentation, which is used as the "fragmentation score" of a zone. This
+ * is the smallest order for which the page allocator gives up instead of
+ * retrying reclaim, so it is where fragmentation turns into failures and
+ * direct compaction stalls.
+ */
+#define COMPACTION_PROACTIVE_ORDER	(PAGE_ALLOC_COSTLY_ORDER + 1)
+
+/*
+ * Tunable for proactive compaction, vm.compaction_proactiveness. It
+ * determines how aggressively kcompactd compacts memory in the background,
+ * before allocations have to stall in direct compaction. It takes values in
+ * the range [0, 100], and 0 disables proactive compaction.
+ *
+ * A zone scoring above the high watermark is compacted until its score
+ * drops to the low one, (100 - proactiveness) but not less than 5, and the
+ * high watermark is 10 points above that. Values close to 100 can cause a
+ * lot of background compaction, and with it latency spikes for the tasks
+ * whose pages are moved around.
+ *
+ * The scores are shown in /proc/zoneinfo, and each round of proactive
+ * compaction is counted as compact_daemon_proactive in /proc/vmstat.
+ */
+unsigned int __read_mostly sysctl_compaction_proactiveness = 20;
+
+/*
+ * A zone's fragmentation score is its external fragmentation with respect
+ * to COMPACTION_PROACTIVE_ORDER, in the range [0, 100]. Zones are judged
+ * on their own rather than weighted by size, so that small zones which
+ * serve GFP_DMA allocations are kept defragmented too.
+ */
+unsigned int fragmentation_score_zone(struct zone *zone)
+{
+	return extfrag_for_order(zone, COMPACTION_PROACTIVE_ORDER);
+}
+
+static unsigned int fragmentation_score_wmark(bool low)
+{
+	unsigned int wmark_low;
+
+	/*
+	 * Cap the low watermark to avoid excessive compaction activity in
+	 * case a user sets the proactiveness tunable close to 100 (maximum).
+	 */
+	wmark_low = max(100U - sysctl_compaction_proactiveness, 5U);
+	return low ? wmark_low : min(wmark_low + 10, 100U);
+}
+
+static inline bool kswapd_is_running(pg_data_t *pgdat)
+{
+	return pgdat->kswapd && (pgdat->kswapd->state == TASK_RUNNING);
+}
+
+static bool should_proactive_compact_zone(struct zone *zone)
+{
+	if (!populated_zone(zone))
+		return false;
+
+	return fragmentation_score_zone(zone) > fragmentation_score_wmark(false);
+}
+
+static bool should_proactive_compact_node(pg_data_t *pgdat)
+{
+	int zoneid;
+
+	if (!sysctl_compaction_proactiveness || kswapd_is_running(pgdat))
+		return false;
+
+	for (zoneid = 0; zoneid < MAX_NR_ZONES; zoneid++)
+		if (should_proactive_compact_zone(&pgdat->node_zones[zoneid]))
+			return true;
+
+	return false;
+}
+
 static bool suitable_migration_source(struct compact_control *cc,
 							struct page *page)
 {
@@ -1872,6 +1953,23 @@ static enum compact_result __compact_finished(struct compact_control *cc)
 			return COMPACT_PARTIAL_SKIPPED;
 	}
 
+	if (cc->proactive_compaction) {
+		unsigned int score, wmark_low;
+
+		if (kswapd_is_running(cc->zone->zone_pgdat))
+			return COMPACT_PARTIAL_SKIPPED;
+
+		score = fragmentation_score_zone(cc->zone);
+		wmark_low = fragmentation_score_wmark(true);
+
+		if (score > wmark_low)
+			ret = COMPACT_CONTINUE;
+		else
+			ret = COMPACT_SUCCESS;
+
+		goto out;
+	}
+
 	if (is_via_compact_memory(cc->order))
 		return COMPACT_CONTINUE;
 
@@ -1930,6 +2028,7 @@ static enum compact_result __compact_finished(struct compact_control *cc)
 		}
 	}
 
+out:
 	if (cc->contended || fatal_signal_pending(current))
 		ret = COMPACT_CONTENDED;
 
@@ -2405,6 +2504,59 @@ enum compact_result try_to_compact_pages(gfp_t gfp_mask, unsigned int order,
 }
 
 
+/*
+ * Compact the zones of a node whose fragmentation score is above the high
+ * watermark, until it drops to the low one. Returns true if the score of any
+ * of them went down.
+ */
+static bool proactive_compact_node(pg_data_t *pgdat)
+{
+	bool progress = false, compacted = false;
+	int zoneid;
+	struct zone *zone;
+	struct compact_control cc = {
+		.order = -1,
+		.mode = MIGRATE_SYNC_LIGHT,
+		.ignore_skip_hint = true,
+		.whole_zone = true,
+		.gfp_mask = GFP_KERNEL,
+		.proactive_compaction = true,
+	};
+
+	for (zoneid = 0; zoneid < MAX_NR_ZONES; zoneid++) {
+		unsigned int prev_score;
+
+		zone = &pgdat->node_zones[zoneid];
+		if (!should_proactive_compact_zone(zone))
+			continue;
+
+		if (kthread_should_stop())
+			break;
+
+		prev_score = fragmentation_score_zone(zone);
+
+		cc.zone = zone;
+		compact_zone(&cc, NULL);
+
+		if (fragmentation_score_zone(zone) < prev_score)
+			progress = true;
+		compacted = true;
+
+		count_compact_events(KCOMPACTD_MIGRATE_SCANNED,
+				     cc.total_migrate_scanned);
+		count_compact_events(KCOMPACTD_FREE_SCANNED,
+				     cc.total_free_scanned);
+
+		VM_BUG_ON(!list_empty(&cc.freepages));
+		VM_BUG_ON(!list_empty(&cc.migratepages));
+	}
+
+	if (compacted)
+		count_compact_event(KCOMPACTD_PROACTIVE);
+
+	return progress;
+}
+
 /* Compact all zones within a node */
 static void compact_node(int nid)
 {
@@ -2629,6 +2781,8 @@ static int kcompactd(void *p)
 {
 	pg_data_t *pgdat = (pg_data_t*)p;
 	struct task_struct *tsk = current;
+	unsigned int proactive_defer = 0;
+	long timeout = msecs_to_jiffies(FRAG_CHECK_INTERVAL_MSEC);
 
 	const struct cpumask *cpumask = cpumask_of_node(pgdat->node_id);
 
@@ -2644,12 +2798,29 @@ static int kcompactd(void *p)
 		unsigned long pflags;
 
 		trace_mm_compaction_kcompactd_sleep(pgdat->node_id);
-		wait_event_freezable(pgdat->kcompactd_wait,
-				kcompactd_work_requested(pgdat));
+		if (wait_event_freezable_timeout(pgdat->kcompactd_wait,
+				kcompactd_work_requested(pgdat), timeout)) {
+
+			psi_memstall_enter(&pflags);
+			kcompactd_do_work(pgdat);
+			psi_memstall_leave(&pflags);
+			continue;
+		}
+
+		/* kcompactd wait timeout */
+		if (should_proactive_compact_node(pgdat)) {
+			if (proactive_defer) {
+				proactive_defer--;
+				continue;
+			}
 
-		psi_memstall_enter(&pflags);
-		kcompactd_do_work(pgdat);
-		psi_memstall_leave(&pflags);
+			/*
+			 * Defer proactive compaction if the fragmentation
+			 * score did not go down i.e. no progress made.
+			 */
+			if (!proactive_compact_node(pgdat))
+				proactive_defer = 1 << COMPACT_MAX_DEFER_SHIFT;
+		}
 	}
 
 	return 0;
@@ -68,6 +68,9 @@ struct dsa_slave_priv {
 
 	struct pcpu_sw_netstats	*stats64;
 
+	/* Frames which the tagger had to reallocate */
+	atomic_long_t		tx_reallocs;
+
 	/* DSA port data, such as switch, port index, etc. */
 	struct dsa_port		*dp;
 
@@ -178,6 +181,10 @@ dsa_slave_to_master(const struct net_device *dev)
 	return dp->cpu_dp->master;
 }
 
+/* stats.c */
+bool dsa_stats_get_stats64(struct dsa_switch *ds, int port,
+			   struct rtnl_link_stats64 *s);
+
 /* switch.c */
 int dsa_switch_register_notifier(struct dsa_switch *ds);
 void dsa_switch_unregister_notifier(struct dsa_switch *ds);
@@ -122,7 +122,7 @@ static int dsa_master_get_sset_count(struct net_device *dev, int sset)
 	struct dsa_port *cpu_dp = dev->dsa_ptr;
 	const struct ethtool_ops *ops = cpu_dp->orig_ethtool_ops;
 	struct dsa_switch *ds = cpu_dp->ds;
-	int count = 0;
+	int count = 0, ds_count;
 
 	if (sset == ETH_SS_PHY_STATS && dev->phydev &&
 	    !ops->get_ethtool_phy_stats)
@@ -133,8 +133,11 @@ static int dsa_master_get_sset_count(struct net_device *dev, int sset)
 	if (count < 0)
 		count = 0;
 
-	if (ds->ops->get_sset_count)
-		count += ds->ops->get_sset_count(ds, cpu_dp->index, sset);
+	if (ds->ops->get_sset_count) {
+		ds_count = ds->ops->get_sset_count(ds, cpu_dp->index, sset);
+		if (ds_count > 0)
+			count += ds_count;
+	}
 
 	return count;
 }
@@ -178,6 +181,8 @@ static void dsa_master_get_strings(struct net_device *dev, uint32_t stringset,
 		 */
 		ds->ops->get_strings(ds, port, stringset, ndata);
 		count = ds->ops->get_sset_count(ds, port, stringset);
+		if (count < 0)
+			count = 0;
 		for (i = 0; i < count; i++) {
 			memmove(ndata + (i * len + sizeof(pfx)),
 				ndata + i * len, len - sizeof(pfx));
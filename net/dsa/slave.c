@@ -506,6 +506,7 @@ static netdev_tx_t dsa_slave_xmit(struct sk_buff *skb, struct net_device *dev)
 	struct dsa_slave_priv *p = netdev_priv(dev);
 	struct pcpu_sw_netstats *s;
 	struct sk_buff *nskb;
+	unsigned char *head;
 
 	s = this_cpu_ptr(p->stats64);
 	u64_stats_update_begin(&s->syncp);
@@ -523,12 +524,17 @@ static netdev_tx_t dsa_slave_xmit(struct sk_buff *skb, struct net_device *dev)
 	/* Transmit function may have to reallocate the original SKB,
 	 * in which case it must have freed it. Only free it here on error.
 	 */
+	head = skb->head;
 	nskb = p->xmit(skb, dev);
 	if (!nskb) {
 		kfree_skb(skb);
 		return NETDEV_TX_OK;
 	}
 
+	/* The tagger had to copy the frame to make room for the tag */
+	if (unlikely(nskb != skb || nskb->head != head))
+		atomic_long_inc(&p->tx_reallocs);
+
 	return dsa_enqueue_skb(nskb, dev);
 }
 
@@ -616,14 +622,19 @@ static void dsa_slave_get_strings(struct net_device *dev,
 
 	if (stringset == ETH_SS_STATS) {
 		int len = ETH_GSTRING_LEN;
+		int count = 0;
 
 		strncpy(data, "tx_packets", len);
 		strncpy(data + len, "tx_bytes", len);
 		strncpy(data + 2 * len, "rx_packets", len);
 		strncpy(data + 3 * len, "rx_bytes", len);
-		if (ds->ops->get_strings)
+		if (ds->ops->get_strings) {
+			count = ds->ops->get_sset_count(ds, dp->index,
+							stringset);
 			ds->ops->get_strings(ds, dp->index, stringset,
 					     data + 4 * len);
+		}
+		strncpy(data + (4 + count) * len, "tx_reallocs", len);
 	}
 }
 
@@ -636,6 +647,7 @@ static void dsa_slave_get_ethtool_stats(struct net_device *dev,
 	struct dsa_switch *ds = dp->ds;
 	struct pcpu_sw_netstats *s;
 	unsigned int start;
+	int count = 0;
 	int i;
 
 	for_each_possible_cpu(i) {
@@ -654,8 +666,11 @@ static void dsa_slave_get_ethtool_stats(struct net_device *dev,
 		data[2] += rx_packets;
 		data[3] += rx_bytes;
 	}
-	if (ds->ops->get_ethtool_stats)
+	if (ds->ops->get_ethtool_stats) {
+		count = ds->ops->get_sset_count(ds, dp->index, ETH_SS_STATS);
 		ds->ops->get_ethtool_stats(ds, dp->index, data + 4);
+	}
+	data[4 + count] = atomic_long_read(&p->tx_reallocs);
 }
 
 static int dsa_slave_get_sset_count(struct net_device *dev, int sset)
@@ -664,13 +679,15 @@ static int dsa_slave_get_sset_count(struct net_device *dev, int sset)
 	struct dsa_switch *ds = dp->ds;
 
 	if (sset == ETH_SS_STATS) {
-		int count;
+		int count = 0;
 
-		count = 4;
-		if (ds->ops->get_sset_count)
-			count += ds->ops->get_sset_count(ds, dp->index, sset);
+		if (ds->ops->get_sset_count) {
+			count = ds->ops->get_sset_count(ds, dp->index, sset);
+			if (count < 0)
+				return count;
+		}
 
-		return count;
+		return count + 5;
 	}
 
 	return -EOPNOTSUPP;
@@ -946,6 +963,46 @@ static int dsa_slave_setup_tc_cls_matchall(struct net_device *dev,
 	}
 }
 
+static int dsa_slave_add_cls_flower(struct net_device *dev,
+				    struct flow_cls_offload *cls,
+				    bool ingress)
+{
+	struct dsa_port *dp = dsa_slave_to_port(dev);
+	struct dsa_switch *ds = dp->ds;
+
+	if (!ds->ops->cls_flower_add)
+		return -EOPNOTSUPP;
+
+	return ds->ops->cls_flower_add(ds, dp->index, cls, ingress);
+}
+
+static int dsa_slave_del_cls_flower(struct net_device *dev,
+				    struct flow_cls_offload *cls,
+				    bool ingress)
+{
+	struct dsa_port *dp = dsa_slave_to_port(dev);
+	struct dsa_switch *ds = dp->ds;
+
+	if (!ds->ops->cls_flower_del)
+		return -EOPNOTSUPP;
+
+	return ds->ops->cls_flower_del(ds, dp->index, cls, ingress);
+}
+
+static int dsa_slave_setup_tc_cls_flower(struct net_device *dev,
+					 struct flow_cls_offload *cls,
+					 bool ingress)
+{
+	switch (cls->command) {
+	case FLOW_CLS_REPLACE:
+		return dsa_slave_add_cls_flower(dev, cls, ingress);
+	case FLOW_CLS_DESTROY:
+		return dsa_slave_del_cls_flower(dev, cls, ingress);
+	default:
+		return -EOPNOTSUPP;
+	}
+}
+
 static int dsa_slave_setup_tc_block_cb(enum tc_setup_type type, void *type_data,
 				       void *cb_priv, bool ingress)
 {
@@ -957,6 +1014,8 @@ static int dsa_slave_setup_tc_block_cb(enum tc_setup_type type, void *type_data,
 	switch (type) {
 	case TC_SETUP_CLSMATCHALL:
 		return dsa_slave_setup_tc_cls_matchall(dev, type_data, ingress);
+	case TC_SETUP_CLSFLOWER:
+		return dsa_slave_setup_tc_cls_flower(dev, type_data, ingress);
 	default:
 		return -EOPNOTSUPP;
 	}
@@ -1035,11 +1094,19 @@ static void dsa_slave_get_stats64(struct net_device *dev,
 				  struct rtnl_link_stats64 *stats)
 {
 	struct dsa_slave_priv *p = netdev_priv(dev);
+	struct dsa_port *dp = p->dp;
 	struct pcpu_sw_netstats *s;
 	unsigned int start;
 	int i;
 
 	netdev_stats_to_stats64(stats, &dev->stats);
+
+	/* Prefer the hardware view of the port, if the driver provides one,
+	 * over the count of frames that went through the CPU.
+	 */
+	if (dsa_stats_get_stats64(dp->ds, dp->index, stats))
+		return;
+
 	for_each_possible_cpu(i) {
 		u64 tx_packets, tx_bytes, rx_packets, rx_bytes;
 
@@ -1406,6 +1473,17 @@ int dsa_slave_create(struct dsa_port *port)
 	slave_dev->netdev_ops = &dsa_slave_netdev_ops;
 	slave_dev->min_mtu = 0;
 	slave_dev->max_mtu = ETH_MAX_MTU;
+	/* Have the stack (and the bridges and uppers of this port, which
+	 * inherit these) leave room for the tag and for whatever the master
+	 * itself puts around the frame, so that neither needs to reallocate
+	 * the skb on xmit.
+	 */
+	slave_dev->needed_headroom = master->needed_headroom;
+	slave_dev->needed_tailroom = master->needed_tailroom;
+	if (cpu_dp->tag_ops->tail_tag)
+		slave_dev->needed_tailroom += cpu_dp->tag_ops->overhead;
+	else
+		slave_dev->needed_headroom += cpu_dp->tag_ops->overhead;
 	SET_NETDEV_DEVTYPE(slave_dev, &dsa_type);
 
 	SET_NETDEV_DEV(slave_dev, port->ds->dev);
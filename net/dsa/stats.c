@@ -0,0 +1,297 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * net/dsa/stats.c - Periodic harvesting of hardware port counters
+ * Copyright (c) 2019, Vladimir Oltean <olteanv@gmail.com>
+ *
+ * Switch counters usually sit behind a slow bus (SPI, MDIO, I2C), so reading
+ * them on every ethtool or ndo_get_stats64 request blocks the caller on bus
+ * I/O and lets any monitoring agent generate bus traffic at will. Instead,
+ * drivers which register with dsa_stats_register() have the counters of all
+ * their ports read by a background worker at a fixed interval. The raw
+ * values are accumulated into 64-bit counters, taking into account that the
+ * hardware ones wrap around at their own width, and readers are served from
+ * a snapshot protected by a seqlock.
+ */
+
+#include <linux/bitops.h>
+#include <linux/mutex.h>
+#include <linux/seqlock.h>
+#include <linux/slab.h>
+#include <linux/workqueue.h>
+
+#include "dsa_priv.h"
+
+struct dsa_port_stats {
+	/* Protects @acc against the harvester */
+	seqlock_t lock;
+	/* Values accumulated since registration, served to readers */
+	u64 *acc;
+	/* Raw hardware values as of the last harvest */
+	u64 *last;
+};
+
+struct dsa_switch_stats {
+	struct dsa_switch *ds;
+	const struct dsa_stats_ops *ops;
+	struct delayed_work work;
+	unsigned long interval;
+	/* Serializes harvesting with hardware counter resets */
+	struct mutex lock;
+	/* Scratch buffer for the read() callback */
+	u64 *raw;
+	struct dsa_port_stats ports[];
+};
+
+static void dsa_stats_harvest_port(struct dsa_switch_stats *st, int port)
+{
+	const struct dsa_stats_ops *ops = st->ops;
+	struct dsa_port_stats *ps = &st->ports[port];
+	struct dsa_switch *ds = st->ds;
+	unsigned int i;
+	int err;
+
+	err = ops->read(ds, port, st->raw);
+	if (err) {
+		dev_err_ratelimited(ds->dev,
+				    "failed to read counters of port %d: %d\n",
+				    port, err);
+		return;
+	}
+
+	write_seqlock_bh(&ps->lock);
+
+	for (i = 0; i < ops->num_stats; i++) {
+		u8 width = ops->descs[i].width;
+		u64 raw = st->raw[i];
+
+		if (width)
+			ps->acc[i] += (raw - ps->last[i]) &
+				      GENMASK_ULL(width - 1, 0);
+		else
+			ps->acc[i] = raw;
+
+		ps->last[i] = raw;
+	}
+
+	write_sequnlock_bh(&ps->lock);
+}
+
+static void dsa_stats_harvest(struct dsa_switch_stats *st)
+{
+	struct dsa_switch *ds = st->ds;
+	int port;
+
+	lockdep_assert_held(&st->lock);
+
+	for (port = 0; port < ds->num_ports; port++) {
+		if (dsa_is_unused_port(ds, port))
+			continue;
+
+		dsa_stats_harvest_port(st, port);
+	}
+}
+
+static void dsa_stats_poll(struct work_struct *work)
+{
+	struct delayed_work *dwork = to_delayed_work(work);
+	struct dsa_switch_stats *st;
+
+	st = container_of(dwork, struct dsa_switch_stats, work);
+
+	mutex_lock(&st->lock);
+	dsa_stats_harvest(st);
+	mutex_unlock(&st->lock);
+
+	schedule_delayed_work(&st->work, st->interval);
+}
+
+/**
+ * dsa_stats_register - have the hardware port counters polled by the core
+ * @ds: switch whose ports the counters belong to
+ * @ops: description of the counters and how to read them
+ *
+ * The hardware counters are assumed to start from zero. Drivers which can
+ * register are expected to point their get_strings, get_ethtool_stats and
+ * get_sset_count switch ops to the dsa_stats_* helpers of the same name.
+ */
+int dsa_stats_register(struct dsa_switch *ds, const struct dsa_stats_ops *ops)
+{
+	unsigned int poll_interval_ms = ops->poll_interval_ms;
+	struct dsa_switch_stats *st;
+	u64 *acc, *last;
+	int port;
+
+	if (WARN_ON(ds->stats || !ops->read || !ops->num_stats))
+		return -EINVAL;
+
+	st = kzalloc(struct_size(st, ports, ds->num_ports), GFP_KERNEL);
+	if (!st)
+		return -ENOMEM;
+
+	/* One scratch array, then the accumulated and last raw values of
+	 * every port.
+	 */
+	st->raw = kcalloc((2 * ds->num_ports + 1) * ops->num_stats,
+			  sizeof(u64), GFP_KERNEL);
+	if (!st->raw) {
+		kfree(st);
+		return -ENOMEM;
+	}
+
+	acc = st->raw + ops->num_stats;
+	last = acc + ds->num_ports * ops->num_stats;
+
+	for (port = 0; port < ds->num_ports; port++) {
+		struct dsa_port_stats *ps = &st->ports[port];
+
+		seqlock_init(&ps->lock);
+		ps->acc = acc + port * ops->num_stats;
+		ps->last = last + port * ops->num_stats;
+	}
+
+	if (!poll_interval_ms)
+		poll_interval_ms = DSA_STATS_POLL_INTERVAL_MS;
+
+	st->ds = ds;
+	st->ops = ops;
+	st->interval = msecs_to_jiffies(poll_interval_ms);
+	mutex_init(&st->lock);
+	INIT_DELAYED_WORK(&st->work, dsa_stats_poll);
+
+	ds->stats = st;
+
+	schedule_delayed_work(&st->work, 0);
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(dsa_stats_register);
+
+void dsa_stats_unregister(struct dsa_switch *ds)
+{
+	struct dsa_switch_stats *st = ds->stats;
+
+	if (!st)
+		return;
+
+	cancel_delayed_work_sync(&st->work);
+	ds->stats = NULL;
+
+	mutex_destroy(&st->lock);
+	kfree(st->raw);
+	kfree(st);
+}
+EXPORT_SYMBOL_GPL(dsa_stats_unregister);
+
+/**
+ * dsa_stats_hw_reset_begin - prepare for the hardware counters to be cleared
+ * @ds: switch about to be reset
+ *
+ * Harvests the counters one last time, so that nothing counted since the
+ * previous poll is lost, and holds off the worker until the matching
+ * dsa_stats_hw_reset_end(). May sleep, and the read() callback must not
+ * depend on locks held by the caller.
+ */
+void dsa_stats_hw_reset_begin(struct dsa_switch *ds)
+{
+	struct dsa_switch_stats *st = ds->stats;
+
+	if (!st)
+		return;
+
+	mutex_lock(&st->lock);
+	dsa_stats_harvest(st);
+}
+EXPORT_SYMBOL_GPL(dsa_stats_hw_reset_begin);
+
+/**
+ * dsa_stats_hw_reset_end - the hardware counters may have been cleared
+ * @ds: switch which was reset
+ * @cleared: whether the reset actually took place
+ *
+ * If @cleared, the raw hardware values count again from zero from now on.
+ * Otherwise they are still relative to the last harvest. The accumulated
+ * values are kept in both cases.
+ */
+void dsa_stats_hw_reset_end(struct dsa_switch *ds, bool cleared)
+{
+	struct dsa_switch_stats *st = ds->stats;
+	int port;
+
+	if (!st)
+		return;
+
+	for (port = 0; cleared && port < ds->num_ports; port++) {
+		struct dsa_port_stats *ps = &st->ports[port];
+
+		write_seqlock_bh(&ps->lock);
+		memset(ps->last, 0, st->ops->num_stats * sizeof(u64));
+		write_sequnlock_bh(&ps->lock);
+	}
+
+	mutex_unlock(&st->lock);
+}
+EXPORT_SYMBOL_GPL(dsa_stats_hw_reset_end);
+
+void dsa_stats_get_strings(struct dsa_switch *ds, int port,
+			   u32 stringset, u8 *data)
+{
+	const struct dsa_switch_stats *st = ds->stats;
+	unsigned int i;
+
+	if (!st || stringset != ETH_SS_STATS)
+		return;
+
+	for (i = 0; i < st->ops->num_stats; i++)
+		strlcpy(data + i * ETH_GSTRING_LEN, st->ops->descs[i].name,
+			ETH_GSTRING_LEN);
+}
+EXPORT_SYMBOL_GPL(dsa_stats_get_strings);
+
+void dsa_stats_get_ethtool_stats(struct dsa_switch *ds, int port, u64 *data)
+{
+	struct dsa_switch_stats *st = ds->stats;
+	struct dsa_port_stats *ps;
+	unsigned int seq;
+
+	if (!st)
+		return;
+
+	ps = &st->ports[port];
+
+	do {
+		seq = read_seqbegin(&ps->lock);
+		memcpy(data, ps->acc, st->ops->num_stats * sizeof(u64));
+	} while (read_seqretry(&ps->lock, seq));
+}
+EXPORT_SYMBOL_GPL(dsa_stats_get_ethtool_stats);
+
+int dsa_stats_get_sset_count(struct dsa_switch *ds, int port, int sset)
+{
+	const struct dsa_switch_stats *st = ds->stats;
+
+	if (sset != ETH_SS_STATS)
+		return -EOPNOTSUPP;
+
+	return st ? st->ops->num_stats : 0;
+}
+EXPORT_SYMBOL_GPL(dsa_stats_get_sset_count);
+
+bool dsa_stats_get_stats64(struct dsa_switch *ds, int port,
+			   struct rtnl_link_stats64 *s)
+{
+	struct dsa_switch_stats *st = ds->stats;
+	struct dsa_port_stats *ps;
+	unsigned int seq;
+
+	if (!st || !st->ops->fill_stats64)
+		return false;
+
+	ps = &st->ports[port];
+
+	do {
+		seq = read_seqbegin(&ps->lock);
+		st->ops->fill_stats64(ds, port, ps->acc, s);
+	} while (read_seqretry(&ps->lock, seq));
+
+	return true;
+}
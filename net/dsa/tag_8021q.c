@@ -291,10 +291,26 @@ EXPORT_SYMBOL_GPL(dsa_port_setup_8021q_tagging);
 struct sk_buff *dsa_8021q_xmit(struct sk_buff *skb, struct net_device *netdev,
 			       u16 tpid, u16 tci)
 {
+	/* The skb is freed by the caller on error, so use the helpers
+	 * which leave it alone.
+	 *
+	 * The switch tag must be the outermost one, so a tag which is
+	 * still out of band goes into the packet first.
+	 */
+	if (skb_vlan_tag_present(skb)) {
+		if (__vlan_insert_tag(skb, skb->vlan_proto,
+				      skb_vlan_tag_get(skb)))
+			return NULL;
+		__vlan_hwaccel_clear_tag(skb);
+	}
+
 	/* skb->data points at skb_mac_header, which
-	 * is fine for vlan_insert_tag.
+	 * is fine for __vlan_insert_tag.
 	 */
-	return vlan_insert_tag(skb, htons(tpid), tci);
+	if (__vlan_insert_tag(skb, htons(tpid), tci))
+		return NULL;
+
+	return skb;
 }
 EXPORT_SYMBOL_GPL(dsa_8021q_xmit);
 
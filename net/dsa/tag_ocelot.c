@@ -164,10 +164,18 @@ static struct sk_buff *ocelot_xmit(struct sk_buff *skb,
 	packing(injection, &qos_class, 19,  17, OCELOT_TAG_LEN, PACK, 0);
 
 	if (ocelot->ptp && (skb_shinfo(skb)->tx_flags & SKBTX_HW_TSTAMP)) {
+		struct sk_buff *clone = DSA_SKB_CB(skb)->clone;
+
 		rew_op = ocelot_port->ptp_cmd;
 		if (ocelot_port->ptp_cmd == IFH_REW_OP_TWO_STEP_PTP) {
-			rew_op |= (ocelot_port->ts_id  % 4) << 3;
-			ocelot_port->ts_id++;
+			/* The timestamp ID was assigned to the clone by
+			 * felix_txtstamp. Don't let the switch generate a
+			 * timestamp that nobody is waiting for.
+			 */
+			if (clone)
+				rew_op |= clone->cb[0] << 3;
+			else
+				rew_op = 0;
 		}
 
 		packing(injection, &rew_op, 125, 117, OCELOT_TAG_LEN, PACK, 0);
@@ -96,6 +96,48 @@ static struct sk_buff *sja1105_defer_xmit(struct sja1105_port *sp,
 	return NULL;
 }
 
+/* If the driver left a management route armed for this DMAC and port, the
+ * frame can be sent right away and only the re-arming of the route (and the
+ * collection of the TX timestamp) is deferred. The egress timestamp register
+ * of the port must not be in use by another sticky route in flight.
+ */
+static bool sja1105_sticky_xmit(struct sja1105_port *sp, struct sk_buff *skb)
+{
+	struct sja1105_tagger_data *data = sp->data;
+	u64 dmac = ether_addr_to_u64(eth_hdr(skb)->h_dest);
+	struct sja1105_sticky_route *route = NULL;
+	int port = sp->dp->index;
+	bool consumed = false;
+	int i;
+
+	spin_lock(&data->sticky_lock);
+
+	for (i = 0; i < SJA1105_NUM_STICKY_ROUTES; i++) {
+		struct sja1105_sticky_route *r = &data->sticky_routes[i];
+
+		if (r->state == SJA1105_STICKY_ROUTE_INFLIGHT &&
+		    r->port == port)
+			goto out;
+		if (r->dmac == dmac)
+			route = r;
+	}
+
+	if (!route || route->state != SJA1105_STICKY_ROUTE_ARMED ||
+	    route->port != port)
+		goto out;
+
+	route->state = SJA1105_STICKY_ROUTE_INFLIGHT;
+	route->clone = DSA_SKB_CB(skb)->clone;
+	consumed = true;
+out:
+	spin_unlock(&data->sticky_lock);
+
+	if (consumed)
+		kthread_queue_work(sp->xmit_worker, &sp->rearm_work);
+
+	return consumed;
+}
+
 static struct sk_buff *sja1105_xmit(struct sk_buff *skb,
 				    struct net_device *netdev)
 {
@@ -106,10 +148,15 @@ static struct sk_buff *sja1105_xmit(struct sk_buff *skb,
 
 	/* Transmitting management traffic does not rely upon switch tagging,
 	 * but instead SPI-installed management routes. Part 2 of this
-	 * is the .port_deferred_xmit driver callback.
+	 * is the .port_deferred_xmit driver callback, which is only needed
+	 * when no pre-armed route can be consumed.
 	 */
-	if (unlikely(sja1105_is_link_local(skb)))
+	if (unlikely(sja1105_is_link_local(skb))) {
+		if (sja1105_sticky_xmit(dp->priv, skb))
+			return skb;
+
 		return sja1105_defer_xmit(dp->priv, skb);
+	}
 
 	/* If we are under a vlan_filtering bridge, IP termination on
 	 * switch ports based on 802.1Q tags is simply too brittle to
@@ -19,6 +19,7 @@
 #include <linux/debugfs.h>
 #include "hsr_main.h"
 #include "hsr_framereg.h"
+#include "hsr_slave.h"
 
 static struct dentry *hsr_debugfs_root_dir;
 
@@ -65,6 +66,37 @@ hsr_node_table_open(struct inode *inode, struct file *filp)
 	return single_open(filp, hsr_node_table_show, inode->i_private);
 }
 
+/* hsr_port_stats_show - Formats and prints the frame counters of the slaves,
+ * i.e. of each LAN for PRP
+ */
+static int
+hsr_port_stats_show(struct seq_file *sfp, void *data)
+{
+	struct hsr_priv *priv = (struct hsr_priv *)sfp->private;
+	struct hsr_port_stats stats;
+	struct hsr_port *port;
+
+	seq_puts(sfp, "Port, rx, rx-untagged, rx-wrong-lan, rx-duplicates, tx\n");
+	rcu_read_lock();
+	hsr_for_each_port(priv, port) {
+		if (port->type == HSR_PT_MASTER)
+			continue;
+		hsr_port_get_stats(port, &stats);
+		seq_printf(sfp, "%s, %llu, %llu, %llu, %llu, %llu\n",
+			   port->dev->name, stats.rx_frames, stats.rx_untagged,
+			   stats.rx_wrong_lan, stats.rx_duplicates,
+			   stats.tx_frames);
+	}
+	rcu_read_unlock();
+	return 0;
+}
+
+static int
+hsr_port_stats_open(struct inode *inode, struct file *filp)
+{
+	return single_open(filp, hsr_port_stats_show, inode->i_private);
+}
+
 void hsr_debugfs_rename(struct net_device *dev)
 {
 	struct hsr_priv *priv = netdev_priv(dev);
@@ -85,6 +117,13 @@ static const struct file_operations hsr_fops = {
 	.release = single_release,
 };
 
+static const struct file_operations hsr_port_stats_fops = {
+	.open	= hsr_port_stats_open,
+	.read	= seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
 /* hsr_debugfs_init - create hsr node_table file for dumping
  * the node table
  *
@@ -114,6 +153,15 @@ void hsr_debugfs_init(struct hsr_priv *priv, struct net_device *hsr_dev)
 		return;
 	}
 	priv->node_tbl_file = de;
+
+	de = debugfs_create_file("port_stats", S_IFREG | 0444,
+				 priv->node_tbl_root, priv,
+				 &hsr_port_stats_fops);
+	if (IS_ERR(de)) {
+		pr_err("Cannot create hsr port_stats file\n");
+		return;
+	}
+	priv->port_stats_file = de;
 }
 
 /* hsr_debugfs_term - Tear down debugfs intrastructure
@@ -125,6 +173,8 @@ void hsr_debugfs_init(struct hsr_priv *priv, struct net_device *hsr_dev)
 void
 hsr_debugfs_term(struct hsr_priv *priv)
 {
+	debugfs_remove(priv->port_stats_file);
+	priv->port_stats_file = NULL;
 	debugfs_remove(priv->node_tbl_file);
 	priv->node_tbl_file = NULL;
 	debugfs_remove(priv->node_tbl_root);
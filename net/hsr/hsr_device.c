@@ -210,6 +210,12 @@ static netdev_features_t hsr_features_recompute(struct hsr_priv *hsr,
 						     port->dev->features,
 						     mask);
 
+	/* Each PRP frame needs its own RCT, so have the stack segment. And
+	 * since the RCT trails the payload, have it checksum the payload too.
+	 */
+	if (hsr_is_prp(hsr))
+		features &= ~(NETIF_F_GSO_MASK | NETIF_F_CSUM_MASK);
+
 	return features;
 }
 
@@ -318,6 +324,64 @@ static void send_hsr_supervision_frame(struct hsr_port *master,
 	kfree_skb(skb);
 }
 
+/* PRP supervision frames go out untagged from the master like any other
+ * frame, and get their RCT on the way to each LAN.
+ */
+static void send_prp_supervision_frame(struct hsr_port *master, u8 type)
+{
+	struct hsr_priv *hsr = master->hsr;
+	struct hsr_sup_payload *hsr_sp;
+	struct hsr_sup_tag *hsr_stag;
+	unsigned long irqflags;
+	struct sk_buff *skb;
+	int hlen, tlen;
+
+	hlen = LL_RESERVED_SPACE(master->dev);
+	tlen = master->dev->needed_tailroom;
+	skb = dev_alloc_skb(ETH_ZLEN + hlen + tlen);
+	if (!skb)
+		return;
+
+	skb_reserve(skb, hlen);
+
+	skb->dev = master->dev;
+	skb->protocol = htons(ETH_P_PRP);
+	skb->priority = TC_PRIO_CONTROL;
+
+	if (dev_hard_header(skb, skb->dev, ETH_P_PRP,
+			    hsr->sup_multicast_addr,
+			    skb->dev->dev_addr, skb->len) <= 0)
+		goto out;
+	skb_reset_mac_header(skb);
+	skb_reset_network_header(skb);
+	skb_reset_transport_header(skb);
+
+	hsr_stag = skb_put(skb, sizeof(struct hsr_sup_tag));
+	set_hsr_stag_path(hsr_stag, 0x0);
+	set_hsr_stag_HSR_ver(hsr_stag, 1);
+
+	spin_lock_irqsave(&hsr->seqnr_lock, irqflags);
+	hsr_stag->sequence_nr = htons(hsr->sup_sequence_nr);
+	hsr->sup_sequence_nr++;
+	spin_unlock_irqrestore(&hsr->seqnr_lock, irqflags);
+
+	hsr_stag->HSR_TLV_type = type;
+	hsr_stag->HSR_TLV_length = sizeof(struct hsr_sup_payload);
+
+	/* Payload: MacAddressA. The padding which follows doubles as the
+	 * terminating TLV.
+	 */
+	hsr_sp = skb_put(skb, sizeof(struct hsr_sup_payload));
+	ether_addr_copy(hsr_sp->macaddress_A, master->dev->dev_addr);
+
+	hsr_forward_skb(skb, master);
+	return;
+
+out:
+	WARN_ONCE(1, "PRP: Could not send supervision frame\n");
+	kfree_skb(skb);
+}
+
 /* Announce (supervision frame) timer function
  */
 static void hsr_announce(struct timer_list *t)
@@ -331,7 +395,11 @@ static void hsr_announce(struct timer_list *t)
 	rcu_read_lock();
 	master = hsr_port_get_hsr(hsr, HSR_PT_MASTER);
 
-	if (hsr->announce_count < 3 && hsr->prot_version == 0) {
+	if (hsr_is_prp(hsr)) {
+		send_prp_supervision_frame(master, PRP_TLV_LIFE_CHECK_DD);
+
+		interval = msecs_to_jiffies(HSR_LIFE_CHECK_INTERVAL);
+	} else if (hsr->announce_count < 3 && hsr->prot_version == 0) {
 		send_hsr_supervision_frame(master, HSR_TLV_ANNOUNCE,
 					   hsr->prot_version);
 		hsr->announce_count++;
@@ -371,7 +439,7 @@ static void hsr_dev_destroy(struct net_device *hsr_dev)
 	del_timer_sync(&hsr->announce_timer);
 
 	hsr_del_self_node(hsr);
-	hsr_del_nodes(&hsr->node_db);
+	hsr_del_nodes(hsr);
 }
 
 static const struct net_device_ops hsr_device_ops = {
@@ -397,6 +465,8 @@ void hsr_dev_setup(struct net_device *dev)
 	dev->netdev_ops = &hsr_device_ops;
 	SET_NETDEV_DEVTYPE(dev, &hsr_type);
 	dev->priv_flags |= IFF_NO_QUEUE;
+	/* Room for the HSR tag, so that it can be inserted in place */
+	dev->needed_headroom = HSR_HLEN;
 
 	dev->needs_free_netdev = true;
 
@@ -441,6 +511,8 @@ int hsr_dev_finalize(struct net_device *hsr_dev, struct net_device *slave[2],
 	hsr = netdev_priv(hsr_dev);
 	INIT_LIST_HEAD(&hsr->ports);
 	INIT_LIST_HEAD(&hsr->node_db);
+	hash_init(hsr->node_hash_A);
+	hash_init(hsr->node_hash_B);
 	INIT_LIST_HEAD(&hsr->self_node_db);
 	spin_lock_init(&hsr->list_lock);
 
@@ -464,6 +536,11 @@ int hsr_dev_finalize(struct net_device *hsr_dev, struct net_device *slave[2],
 	hsr->sup_multicast_addr[ETH_ALEN - 1] = multicast_spec;
 
 	hsr->prot_version = protocol_version;
+	if (hsr_is_prp(hsr)) {
+		/* The RCT goes at the tail, and the header is left alone */
+		hsr_dev->needed_headroom = 0;
+		hsr_dev->needed_tailroom = HSR_HLEN;
+	}
 
 	/* FIXME: should I modify the value of these?
 	 *
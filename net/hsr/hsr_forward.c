@@ -18,6 +18,7 @@ struct hsr_node;
 struct hsr_frame_info {
 	struct sk_buff *skb_std;
 	struct sk_buff *skb_hsr;
+	struct sk_buff *skb_prp;
 	struct hsr_port *port_rcv;
 	struct hsr_node *node_src;
 	u16 sequence_nr;
@@ -74,7 +75,9 @@ static bool is_supervision_frame(struct hsr_priv *hsr, struct sk_buff *skb)
 	}
 
 	if (hsr_sup_tag->HSR_TLV_type != HSR_TLV_ANNOUNCE &&
-	    hsr_sup_tag->HSR_TLV_type != HSR_TLV_LIFE_CHECK)
+	    hsr_sup_tag->HSR_TLV_type != HSR_TLV_LIFE_CHECK &&
+	    hsr_sup_tag->HSR_TLV_type != PRP_TLV_LIFE_CHECK_DD &&
+	    hsr_sup_tag->HSR_TLV_type != PRP_TLV_LIFE_CHECK_DA)
 		return false;
 	if (hsr_sup_tag->HSR_TLV_length != 12 &&
 	    hsr_sup_tag->HSR_TLV_length != sizeof(struct hsr_sup_payload))
@@ -112,9 +115,55 @@ static struct sk_buff *create_stripped_skb(struct sk_buff *skb_in,
 	return skb;
 }
 
+/* Return the RCT of 'skb', a frame received on a PRP LAN and starting with
+ * its ethernet header, or NULL if it has none.
+ */
+static struct prp_rct *prp_get_skb_rct(struct sk_buff *skb,
+				       struct prp_rct *buf)
+{
+	unsigned int lsdu_size;
+	struct prp_rct *rct;
+
+	if (skb->len < ETH_HLEN + HSR_HLEN)
+		return NULL;
+
+	rct = skb_header_pointer(skb, skb->len - HSR_HLEN, HSR_HLEN, buf);
+	if (!rct || rct->PRP_suffix != htons(ETH_P_PRP))
+		return NULL;
+
+	lsdu_size = get_prp_LSDU_size(rct);
+	if (lsdu_size != skb->len - ETH_HLEN &&
+	    lsdu_size != skb->len - VLAN_ETH_HLEN)
+		return NULL;
+
+	return rct;
+}
+
+/* Strip the RCT off a clone of the received frame. Unless the frame is
+ * paged, this doesn't touch the data.
+ */
+static struct sk_buff *prp_create_stripped_skb(struct sk_buff *skb_in)
+{
+	struct sk_buff *skb;
+
+	skb = skb_clone(skb_in, GFP_ATOMIC);
+	if (!skb)
+		return NULL;
+
+	if (pskb_trim_rcsum(skb, skb->len - HSR_HLEN)) {
+		kfree_skb(skb);
+		return NULL;
+	}
+
+	return skb;
+}
+
 static struct sk_buff *frame_get_stripped_skb(struct hsr_frame_info *frame,
 					      struct hsr_port *port)
 {
+	if (frame->skb_prp)
+		return prp_create_stripped_skb(frame->skb_prp);
+
 	if (!frame->skb_std)
 		frame->skb_std = create_stripped_skb(frame->skb_hsr, frame);
 	return skb_clone(frame->skb_std, GFP_ATOMIC);
@@ -177,6 +226,99 @@ static struct sk_buff *create_tagged_skb(struct sk_buff *skb_o,
 	return skb;
 }
 
+/* Insert the HSR tag for 'port' into 'skb' itself. Only the MAC header is
+ * moved, so the offsets of the other headers and csum_start still hold, and
+ * the head is reallocated only if there is no room for the tag or it is
+ * shared with clones.
+ */
+static int hsr_insert_tag(struct sk_buff *skb, struct hsr_frame_info *frame,
+			  struct hsr_port *port)
+{
+	unsigned char *dst, *src;
+	int movelen;
+
+	if (skb_cow_head(skb, HSR_HLEN))
+		return -ENOMEM;
+
+	movelen = ETH_HLEN;
+	if (frame->is_vlan)
+		movelen += VLAN_HLEN;
+
+	src = skb_mac_header(skb);
+	dst = skb_push(skb, HSR_HLEN);
+	memmove(dst, src, movelen);
+	skb_reset_mac_header(skb);
+
+	hsr_fill_tag(skb, frame, port, port->hsr->prot_version);
+
+	return 0;
+}
+
+/* Append the RCT for LAN 'port' to 'skb' itself, padding the frame first if
+ * it's too short, so that the RCT ends up right before the FCS. The frame is
+ * linearized, and reallocated if there is no room for the RCT or its data is
+ * shared with clones. A pending L4 checksum would be computed up to the end
+ * of the frame, RCT included, so it is resolved first.
+ */
+static int prp_insert_rct(struct sk_buff *skb, struct hsr_frame_info *frame,
+			  struct hsr_port *port)
+{
+	unsigned int min_len = ETH_ZLEN - HSR_HLEN;
+	unsigned int pad, lsdu_size;
+	struct prp_rct *rct;
+	u16 lan_id;
+
+	if (skb->ip_summed == CHECKSUM_PARTIAL && skb_checksum_help(skb))
+		return -ENOMEM;
+
+	if (skb_linearize(skb))
+		return -ENOMEM;
+
+	pad = skb->len < min_len ? min_len - skb->len : 0;
+	if (skb_cloned(skb) || skb_tailroom(skb) < pad + HSR_HLEN) {
+		int ntail = pad + HSR_HLEN - skb_tailroom(skb);
+
+		if (pskb_expand_head(skb, 0, max(ntail, 0), GFP_ATOMIC))
+			return -ENOMEM;
+	}
+
+	if (pad)
+		skb_put_zero(skb, pad);
+
+	lsdu_size = skb->len + HSR_HLEN - ETH_HLEN;
+	if (frame->is_vlan)
+		lsdu_size -= VLAN_HLEN;
+
+	lan_id = port->type == HSR_PT_SLAVE_A ? PRP_LAN_ID_A : PRP_LAN_ID_B;
+
+	rct = skb_put(skb, HSR_HLEN);
+	rct->sequence_nr = htons(frame->sequence_nr);
+	set_prp_lan_id_and_LSDU_size(rct, lan_id, lsdu_size);
+	rct->PRP_suffix = htons(ETH_P_PRP);
+
+	return 0;
+}
+
+static struct sk_buff *prp_create_tagged_skb(struct sk_buff *skb_o,
+					     struct hsr_frame_info *frame,
+					     struct hsr_port *port)
+{
+	struct sk_buff *skb;
+
+	/* A linear copy, with room for padding and the RCT */
+	skb = skb_copy_expand(skb_o, skb_headroom(skb_o), ETH_ZLEN,
+			      GFP_ATOMIC);
+	if (!skb)
+		return NULL;
+
+	if (prp_insert_rct(skb, frame, port)) {
+		kfree_skb(skb);
+		return NULL;
+	}
+
+	return skb;
+}
+
 /* If the original frame was an HSR tagged frame, just clone it to be sent
  * unchanged. Otherwise, create a private frame especially tagged for 'port'.
  */
@@ -191,9 +333,41 @@ static struct sk_buff *frame_get_tagged_skb(struct hsr_frame_info *frame,
 		return NULL;
 	}
 
+	if (hsr_is_prp(port->hsr))
+		return prp_create_tagged_skb(frame->skb_std, frame, port);
+
 	return create_tagged_skb(frame->skb_std, frame, port);
 }
 
+/* Like frame_get_tagged_skb() for an untagged frame, but tag the frame itself
+ * rather than a copy of it. Consumes frame->skb_std, so this must be the last
+ * user of it.
+ */
+static struct sk_buff *frame_take_tagged_skb(struct hsr_frame_info *frame,
+					     struct hsr_port *port)
+{
+	struct sk_buff *skb = frame->skb_std;
+	int err;
+
+	if (port->type != HSR_PT_SLAVE_A && port->type != HSR_PT_SLAVE_B) {
+		WARN_ONCE(1, "HSR: Bug: trying to create a tagged frame for a non-ring port");
+		return NULL;
+	}
+
+	frame->skb_std = NULL;
+
+	if (hsr_is_prp(port->hsr))
+		err = prp_insert_rct(skb, frame, port);
+	else
+		err = hsr_insert_tag(skb, frame, port);
+	if (err) {
+		kfree_skb(skb);
+		return NULL;
+	}
+
+	return skb;
+}
+
 static void hsr_deliver_master(struct sk_buff *skb, struct net_device *dev,
 			       struct hsr_node *node_src)
 {
@@ -217,7 +391,10 @@ static void hsr_deliver_master(struct sk_buff *skb, struct net_device *dev,
 static int hsr_xmit(struct sk_buff *skb, struct hsr_port *port,
 		    struct hsr_frame_info *frame)
 {
-	if (frame->port_rcv->type == HSR_PT_MASTER) {
+	hsr_port_stats_inc(port, tx_frames);
+
+	/* PRP nodes use the same address on both LANs */
+	if (frame->port_rcv->type == HSR_PT_MASTER && !hsr_is_prp(port->hsr)) {
 		hsr_addr_subst_dest(frame->node_src, skb, port);
 
 		/* Address substitution (IEC62439-3 pp 26, 50): replace mac
@@ -228,6 +405,42 @@ static int hsr_xmit(struct sk_buff *skb, struct hsr_port *port,
 	return dev_queue_xmit(skb);
 }
 
+static void hsr_forward_port(struct hsr_frame_info *frame,
+			     struct hsr_port *port, struct sk_buff *skb)
+{
+	if (!skb) {
+		/* FIXME: Record the dropped frame? */
+		return;
+	}
+
+	skb->dev = port->dev;
+	if (port->type == HSR_PT_MASTER)
+		hsr_deliver_master(skb, port->dev, frame->node_src);
+	else
+		hsr_xmit(skb, port, frame);
+}
+
+/* PRP LANs are separate networks, so frames are never passed between them,
+ * and only frames from the LANs need duplicate discard.
+ */
+static bool prp_drop_frame(struct hsr_frame_info *frame, struct hsr_port *port)
+{
+	if (port->type != HSR_PT_MASTER)
+		return frame->port_rcv->type != HSR_PT_MASTER;
+
+	/* Frames from SANs have no RCT, and no duplicates */
+	if (!frame->skb_prp)
+		return false;
+
+	if (prp_register_frame_out(frame->port_rcv, frame->node_src,
+				   frame->sequence_nr)) {
+		hsr_port_stats_inc(frame->port_rcv, rx_duplicates);
+		return true;
+	}
+
+	return false;
+}
+
 /* Forward the frame through all devices except:
  * - Back through the receiving device
  * - If it's a HSR frame: through a device where it has passed before
@@ -238,10 +451,20 @@ static int hsr_xmit(struct sk_buff *skb, struct hsr_port *port,
  * frame unchanged if it's already tagged. Interlink devices should strip HSR
  * tags if they're of the non-HSR type (but only after duplicate discard). The
  * master device always strips HSR tags.
+ *
+ * With PRP, frames from the master go to both LANs with an RCT appended, and
+ * frames from the LANs go to the master only, RCT stripped, after duplicate
+ * discard.
+ *
+ * An untagged frame needs a differently tagged header for each of the ring
+ * ports. All of them but the last one get a copy, and the last one gets the
+ * frame itself, tagged in place. Since we can't tell the last port before
+ * the walk is done, sending to a ring port is deferred until the next one
+ * is found.
  */
 static void hsr_forward_do(struct hsr_frame_info *frame)
 {
-	struct hsr_port *port;
+	struct hsr_port *port, *prev = NULL;
 	struct sk_buff *skb;
 
 	hsr_for_each_port(frame->port_rcv->hsr, port) {
@@ -258,31 +481,43 @@ static void hsr_forward_do(struct hsr_frame_info *frame)
 			continue;
 
 		/* Don't send frame over port where it has been sent before */
-		if (hsr_register_frame_out(port, frame->node_src,
-					   frame->sequence_nr))
+		if (hsr_is_prp(port->hsr)) {
+			if (prp_drop_frame(frame, port))
+				continue;
+		} else if (hsr_register_frame_out(port, frame->node_src,
+						  frame->sequence_nr)) {
+			if (port->type == HSR_PT_MASTER)
+				hsr_port_stats_inc(frame->port_rcv,
+						   rx_duplicates);
 			continue;
+		}
 
 		if (frame->is_supervision && port->type == HSR_PT_MASTER) {
-			hsr_handle_sup_frame(frame->skb_hsr,
+			hsr_handle_sup_frame(frame->skb_hsr ? : frame->skb_prp,
 					     frame->node_src,
 					     frame->port_rcv);
 			continue;
 		}
 
-		if (port->type != HSR_PT_MASTER)
-			skb = frame_get_tagged_skb(frame, port);
-		else
+		if (port->type == HSR_PT_MASTER) {
 			skb = frame_get_stripped_skb(frame, port);
-		if (!skb) {
-			/* FIXME: Record the dropped frame? */
+		} else if (frame->skb_hsr) {
+			skb = frame_get_tagged_skb(frame, port);
+		} else {
+			if (prev) {
+				skb = frame_get_tagged_skb(frame, prev);
+				hsr_forward_port(frame, prev, skb);
+			}
+			prev = port;
 			continue;
 		}
 
-		skb->dev = port->dev;
-		if (port->type == HSR_PT_MASTER)
-			hsr_deliver_master(skb, port->dev, frame->node_src);
-		else
-			hsr_xmit(skb, port, frame);
+		hsr_forward_port(frame, port, skb);
+	}
+
+	if (prev) {
+		skb = frame_take_tagged_skb(frame, prev);
+		hsr_forward_port(frame, prev, skb);
 	}
 }
 
@@ -308,11 +543,20 @@ static void check_local_dest(struct hsr_priv *hsr, struct sk_buff *skb,
 static int hsr_fill_frame_info(struct hsr_frame_info *frame,
 			       struct sk_buff *skb, struct hsr_port *port)
 {
+	struct hsr_priv *hsr = port->hsr;
+	struct prp_rct *rct = NULL;
+	struct prp_rct rct_buf;
 	struct ethhdr *ethhdr;
 	unsigned long irqflags;
 
+	if (port->type != HSR_PT_MASTER) {
+		hsr_port_stats_inc(port, rx_frames);
+		if (hsr_is_prp(hsr))
+			rct = prp_get_skb_rct(skb, &rct_buf);
+	}
+
 	frame->is_supervision = is_supervision_frame(port->hsr, skb);
-	frame->node_src = hsr_get_node(port, skb, frame->is_supervision);
+	frame->node_src = hsr_get_node(port, skb, frame->is_supervision, rct);
 	if (!frame->node_src)
 		return -1; /* Unknown node and !is_supervision, or no mem */
 
@@ -323,8 +567,28 @@ static int hsr_fill_frame_info(struct hsr_frame_info *frame,
 		/* FIXME: */
 		WARN_ONCE(1, "HSR: VLAN not yet supported");
 	}
-	if (ethhdr->h_proto == htons(ETH_P_PRP) ||
-	    ethhdr->h_proto == htons(ETH_P_HSR)) {
+	frame->skb_prp = NULL;
+	if (rct) {
+		frame->skb_std = NULL;
+		frame->skb_hsr = NULL;
+		frame->skb_prp = skb;
+		frame->sequence_nr = ntohs(rct->sequence_nr);
+		if (unlikely(frame->node_src->san))
+			frame->node_src->san = false;
+		if (get_prp_lan_id(rct) != (port->type == HSR_PT_SLAVE_A ?
+					    PRP_LAN_ID_A : PRP_LAN_ID_B))
+			hsr_port_stats_inc(port, rx_wrong_lan);
+	} else if (hsr_is_prp(hsr) && port->type != HSR_PT_MASTER) {
+		/* From a SAN, without sequence number. This one just has
+		 * hsr_register_frame_in() refresh the node.
+		 */
+		frame->skb_std = skb;
+		frame->skb_hsr = NULL;
+		frame->sequence_nr = frame->node_src->seq_out[port->type];
+		hsr_port_stats_inc(port, rx_untagged);
+	} else if (!hsr_is_prp(hsr) &&
+		   (ethhdr->h_proto == htons(ETH_P_PRP) ||
+		    ethhdr->h_proto == htons(ETH_P_HSR))) {
 		frame->skb_std = NULL;
 		frame->skb_hsr = skb;
 		frame->sequence_nr = hsr_get_skb_sequence_nr(skb);
@@ -348,6 +612,7 @@ static int hsr_fill_frame_info(struct hsr_frame_info *frame,
 void hsr_forward_skb(struct sk_buff *skb, struct hsr_port *port)
 {
 	struct hsr_frame_info frame;
+	unsigned int len = skb->len;
 
 	if (skb_mac_header(skb) != skb->data) {
 		WARN_ONCE(1, "%s:%d: Malformed frame (port_src %s)\n",
@@ -360,15 +625,18 @@ void hsr_forward_skb(struct sk_buff *skb, struct hsr_port *port)
 	hsr_register_frame_in(frame.node_src, port, frame.sequence_nr);
 	hsr_forward_do(&frame);
 	/* Gets called for ingress frames as well as egress from master port.
-	 * So check and increment stats for master port only here.
+	 * So check and increment stats for master port only here. Note that
+	 * skb may have been consumed by hsr_forward_do() by now.
 	 */
 	if (port->type == HSR_PT_MASTER) {
 		port->dev->stats.tx_packets++;
-		port->dev->stats.tx_bytes += skb->len;
+		port->dev->stats.tx_bytes += len;
 	}
 
 	if (frame.skb_hsr)
 		kfree_skb(frame.skb_hsr);
+	if (frame.skb_prp)
+		kfree_skb(frame.skb_prp);
 	if (frame.skb_std)
 		kfree_skb(frame.skb_std);
 	return;
@@ -14,12 +14,11 @@
 #include <linux/etherdevice.h>
 #include <linux/slab.h>
 #include <linux/rculist.h>
+#include <linux/jhash.h>
 #include "hsr_main.h"
 #include "hsr_framereg.h"
 #include "hsr_netlink.h"
 
-/*	TODO: use hash lists for mac addresses (linux/jhash.h)?    */
-
 /* seq_nr_after(a, b) - return true if a is after (higher in sequence than) b,
  * false otherwise.
  */
@@ -57,14 +56,20 @@ bool hsr_addr_is_self(struct hsr_priv *hsr, unsigned char *addr)
 	return false;
 }
 
+static u32 hsr_mac_hash(const unsigned char addr[ETH_ALEN])
+{
+	return jhash(addr, ETH_ALEN, 0);
+}
+
 /* Search for mac entry. Caller must hold rcu read lock.
  */
-static struct hsr_node *find_node_by_addr_A(struct list_head *node_db,
+static struct hsr_node *find_node_by_addr_A(struct hsr_priv *hsr,
 					    const unsigned char addr[ETH_ALEN])
 {
 	struct hsr_node *node;
 
-	list_for_each_entry_rcu(node, node_db, mac_list) {
+	hash_for_each_possible_rcu(hsr->node_hash_A, node, hash_A,
+				   hsr_mac_hash(addr)) {
 		if (ether_addr_equal(node->macaddress_A, addr))
 			return node;
 	}
@@ -72,6 +77,35 @@ static struct hsr_node *find_node_by_addr_A(struct list_head *node_db,
 	return NULL;
 }
 
+static struct hsr_node *find_node_by_addr_B(struct hsr_priv *hsr,
+					    const unsigned char addr[ETH_ALEN])
+{
+	struct hsr_node *node;
+
+	hash_for_each_possible_rcu(hsr->node_hash_B, node, hash_B,
+				   hsr_mac_hash(addr)) {
+		if (ether_addr_equal(node->macaddress_B, addr))
+			return node;
+	}
+
+	return NULL;
+}
+
+/* Search for the node owning mac address 'addr', be it as its address A or
+ * B. Caller must hold rcu read lock or hsr->list_lock.
+ */
+static struct hsr_node *find_node(struct hsr_priv *hsr,
+				  const unsigned char addr[ETH_ALEN])
+{
+	struct hsr_node *node;
+
+	node = find_node_by_addr_A(hsr, addr);
+	if (node)
+		return node;
+
+	return find_node_by_addr_B(hsr, addr);
+}
+
 /* Helper for device init; the self_node_db is used in hsr_rcv() to recognize
  * frames from self that's been looped over the HSR ring.
  */
@@ -118,12 +152,12 @@ void hsr_del_self_node(struct hsr_priv *hsr)
 	spin_unlock_bh(&hsr->list_lock);
 }
 
-void hsr_del_nodes(struct list_head *node_db)
+void hsr_del_nodes(struct hsr_priv *hsr)
 {
 	struct hsr_node *node;
 	struct hsr_node *tmp;
 
-	list_for_each_entry_safe(node, tmp, node_db, mac_list)
+	list_for_each_entry_safe(node, tmp, &hsr->node_db, mac_list)
 		kfree(node);
 }
 
@@ -132,7 +166,6 @@ void hsr_del_nodes(struct list_head *node_db)
  * originating from the newly added node.
  */
 static struct hsr_node *hsr_add_node(struct hsr_priv *hsr,
-				     struct list_head *node_db,
 				     unsigned char addr[],
 				     u16 seq_out)
 {
@@ -145,6 +178,7 @@ static struct hsr_node *hsr_add_node(struct hsr_priv *hsr,
 		return NULL;
 
 	ether_addr_copy(new_node->macaddress_A, addr);
+	spin_lock_init(&new_node->prp_lock);
 
 	/* We are only interested in time diffs here, so use current jiffies
 	 * as initialization. (0 could trigger an spurious ring error warning).
@@ -156,13 +190,11 @@ static struct hsr_node *hsr_add_node(struct hsr_priv *hsr,
 		new_node->seq_out[i] = seq_out;
 
 	spin_lock_bh(&hsr->list_lock);
-	list_for_each_entry_rcu(node, node_db, mac_list) {
-		if (ether_addr_equal(node->macaddress_A, addr))
-			goto out;
-		if (ether_addr_equal(node->macaddress_B, addr))
-			goto out;
-	}
-	list_add_tail_rcu(&new_node->mac_list, node_db);
+	node = find_node(hsr, addr);
+	if (node)
+		goto out;
+	hash_add_rcu(hsr->node_hash_A, &new_node->hash_A, hsr_mac_hash(addr));
+	list_add_tail_rcu(&new_node->mac_list, &hsr->node_db);
 	spin_unlock_bh(&hsr->list_lock);
 	return new_node;
 out:
@@ -174,9 +206,8 @@ static struct hsr_node *hsr_add_node(struct hsr_priv *hsr,
 /* Get the hsr_node from which 'skb' was sent.
  */
 struct hsr_node *hsr_get_node(struct hsr_port *port, struct sk_buff *skb,
-			      bool is_sup)
+			      bool is_sup, struct prp_rct *rct)
 {
-	struct list_head *node_db = &port->hsr->node_db;
 	struct hsr_priv *hsr = port->hsr;
 	struct hsr_node *node;
 	struct ethhdr *ethhdr;
@@ -187,31 +218,36 @@ struct hsr_node *hsr_get_node(struct hsr_port *port, struct sk_buff *skb,
 
 	ethhdr = (struct ethhdr *)skb_mac_header(skb);
 
-	list_for_each_entry_rcu(node, node_db, mac_list) {
-		if (ether_addr_equal(node->macaddress_A, ethhdr->h_source))
-			return node;
-		if (ether_addr_equal(node->macaddress_B, ethhdr->h_source))
-			return node;
-	}
+	node = find_node(hsr, ethhdr->h_source);
+	if (node)
+		return node;
 
 	/* Everyone may create a node entry, connected node to a HSR device. */
 
-	if (ethhdr->h_proto == htons(ETH_P_PRP) ||
-	    ethhdr->h_proto == htons(ETH_P_HSR)) {
+	if (rct) {
+		seq_out = ntohs(rct->sequence_nr) - 1;
+	} else if (!hsr_is_prp(hsr) &&
+		   (ethhdr->h_proto == htons(ETH_P_PRP) ||
+		    ethhdr->h_proto == htons(ETH_P_HSR))) {
 		/* Use the existing sequence_nr from the tag as starting point
 		 * for filtering duplicate frames.
 		 */
 		seq_out = hsr_get_skb_sequence_nr(skb) - 1;
 	} else {
 		/* this is called also for frames from master port and
-		 * so warn only for non master ports
+		 * so warn only for non master ports. SANs are legitimate
+		 * members of PRP networks.
 		 */
-		if (port->type != HSR_PT_MASTER)
+		if (port->type != HSR_PT_MASTER && !hsr_is_prp(hsr))
 			WARN_ONCE(1, "%s: Non-HSR frame\n", __func__);
 		seq_out = HSR_SEQNR_START;
 	}
 
-	return hsr_add_node(hsr, node_db, ethhdr->h_source, seq_out);
+	node = hsr_add_node(hsr, ethhdr->h_source, seq_out);
+	if (node && !rct && port->type != HSR_PT_MASTER)
+		node->san = true;
+
+	return node;
 }
 
 /* Use the Supervision frame's info about an eventual macaddress_B for merging
@@ -224,7 +260,6 @@ void hsr_handle_sup_frame(struct sk_buff *skb, struct hsr_node *node_curr,
 	struct hsr_priv *hsr = port_rcv->hsr;
 	struct hsr_sup_payload *hsr_sp;
 	struct hsr_node *node_real;
-	struct list_head *node_db;
 	struct ethhdr *ethhdr;
 	int i;
 
@@ -243,11 +278,10 @@ void hsr_handle_sup_frame(struct sk_buff *skb, struct hsr_node *node_curr,
 	hsr_sp = (struct hsr_sup_payload *)skb->data;
 
 	/* Merge node_curr (registered on macaddress_B) into node_real */
-	node_db = &port_rcv->hsr->node_db;
-	node_real = find_node_by_addr_A(node_db, hsr_sp->macaddress_A);
+	node_real = find_node_by_addr_A(hsr, hsr_sp->macaddress_A);
 	if (!node_real)
 		/* No frame received from AddrA of this node yet */
-		node_real = hsr_add_node(hsr, node_db, hsr_sp->macaddress_A,
+		node_real = hsr_add_node(hsr, hsr_sp->macaddress_A,
 					 HSR_SEQNR_START - 1);
 	if (!node_real)
 		goto done; /* No mem */
@@ -255,7 +289,6 @@ void hsr_handle_sup_frame(struct sk_buff *skb, struct hsr_node *node_curr,
 		/* Node has already been merged */
 		goto done;
 
-	ether_addr_copy(node_real->macaddress_B, ethhdr->h_source);
 	for (i = 0; i < HSR_PT_PORTS; i++) {
 		if (!node_curr->time_in_stale[i] &&
 		    time_after(node_curr->time_in[i], node_real->time_in[i])) {
@@ -268,8 +301,29 @@ void hsr_handle_sup_frame(struct sk_buff *skb, struct hsr_node *node_curr,
 	}
 	node_real->addr_B_port = port_rcv->type;
 
+	/* Take over the lookups of AddrB from node_curr. node_real is kept,
+	 * as the frame handlers update its sequence numbers and timestamps
+	 * without list_lock. Rehashing it while a lookup walks its chain can
+	 * make that lookup miss; hsr_add_node() then finds node_real under
+	 * the lock.
+	 */
 	spin_lock_bh(&hsr->list_lock);
+	/* Both may have been pruned or merged by another port meanwhile */
+	if (find_node(hsr, ethhdr->h_source) != node_curr ||
+	    find_node_by_addr_A(hsr, hsr_sp->macaddress_A) != node_real) {
+		spin_unlock_bh(&hsr->list_lock);
+		goto done;
+	}
+	hash_del_rcu(&node_curr->hash_A);
+	hash_del_rcu(&node_curr->hash_B);
 	list_del_rcu(&node_curr->mac_list);
+	if (!hash_hashed(&node_real->hash_B) ||
+	    !ether_addr_equal(node_real->macaddress_B, ethhdr->h_source)) {
+		hash_del_rcu(&node_real->hash_B);
+		ether_addr_copy(node_real->macaddress_B, ethhdr->h_source);
+		hash_add_rcu(hsr->node_hash_B, &node_real->hash_B,
+			     hsr_mac_hash(node_real->macaddress_B));
+	}
 	spin_unlock_bh(&hsr->list_lock);
 	kfree_rcu(node_curr, rcu_head);
 
@@ -315,8 +369,7 @@ void hsr_addr_subst_dest(struct hsr_node *node_src, struct sk_buff *skb,
 	if (!is_unicast_ether_addr(eth_hdr(skb)->h_dest))
 		return;
 
-	node_dst = find_node_by_addr_A(&port->hsr->node_db,
-				       eth_hdr(skb)->h_dest);
+	node_dst = find_node_by_addr_A(port->hsr, eth_hdr(skb)->h_dest);
 	if (!node_dst) {
 		WARN_ONCE(1, "%s: Unknown node\n", __func__);
 		return;
@@ -359,6 +412,66 @@ int hsr_register_frame_out(struct hsr_port *port, struct hsr_node *node,
 	return 0;
 }
 
+static bool prp_seq_nr_in_window(u16 sequence_nr, u16 start, u16 end)
+{
+	return (u16)(sequence_nr - start) < (u16)(end - start);
+}
+
+/* PRP duplicate discard. 'port_rcv' is the LAN on which a frame carrying an
+ * RCT with 'sequence_nr' was received from 'node', to be delivered locally.
+ *
+ * Both LANs carry the frames of a node in the same order, but either may
+ * lose some or lag behind the other. For each LAN, a window holds the
+ * sequence numbers accepted from it that haven't shown up on the other LAN
+ * yet. A frame whose sequence number is in the window of the other LAN is a
+ * duplicate, and the frames before it in that window will not come anymore.
+ * A frame outside of it is new: it extends the window of its own LAN (or
+ * restarts it, if not contiguous), and empties the one of the other LAN,
+ * which only had older frames.
+ *
+ * Return:
+ *	 1 if the frame is a duplicate and must be discarded,
+ *	 0 otherwise
+ */
+int prp_register_frame_out(struct hsr_port *port_rcv, struct hsr_node *node,
+			   u16 sequence_nr)
+{
+	int lan = port_rcv->type == HSR_PT_SLAVE_A ? 0 : 1;
+	int other = !lan;
+	int res = 0;
+
+	spin_lock(&node->prp_lock);
+
+	/* The node may have restarted since we last heard from it */
+	if (time_is_before_jiffies(node->prp_time +
+				   msecs_to_jiffies(PRP_ENTRY_FORGET_TIME))) {
+		node->prp_seq_start[0] = node->prp_seq_expected[0];
+		node->prp_seq_start[1] = node->prp_seq_expected[1];
+	}
+
+	if (prp_seq_nr_in_window(sequence_nr, node->prp_seq_start[other],
+				 node->prp_seq_expected[other])) {
+		node->prp_seq_start[other] = sequence_nr + 1;
+		res = 1;
+		goto out;
+	}
+
+	if (sequence_nr != node->prp_seq_expected[lan])
+		node->prp_seq_start[lan] = sequence_nr;
+	node->prp_seq_expected[lan] = sequence_nr + 1;
+	if ((u16)(node->prp_seq_expected[lan] - node->prp_seq_start[lan]) >
+	    PRP_DROP_WINDOW_LEN)
+		node->prp_seq_start[lan] = node->prp_seq_expected[lan] -
+					   PRP_DROP_WINDOW_LEN;
+
+	node->prp_seq_start[other] = node->prp_seq_expected[other];
+	node->prp_time = jiffies;
+out:
+	spin_unlock(&node->prp_lock);
+
+	return res;
+}
+
 static struct hsr_port *get_late_port(struct hsr_priv *hsr,
 				      struct hsr_node *node)
 {
@@ -421,8 +534,11 @@ void hsr_prune_nodes(struct timer_list *t)
 		    time_after(time_b, time_a)))
 			timestamp = time_b;
 
-		/* Warn of ring error only as long as we get frames at all */
-		if (time_is_after_jiffies(timestamp +
+		/* Warn of ring error only as long as we get frames at all.
+		 * PRP SANs are attached to one LAN only, by definition.
+		 */
+		if (!node->san &&
+		    time_is_after_jiffies(timestamp +
 				msecs_to_jiffies(1.5 * MAX_SLAVE_DIFF))) {
 			rcu_read_lock();
 			port = get_late_port(hsr, node);
@@ -435,6 +551,8 @@ void hsr_prune_nodes(struct timer_list *t)
 		if (time_is_before_jiffies(timestamp +
 				msecs_to_jiffies(HSR_NODE_FORGET_TIME))) {
 			hsr_nl_nodedown(hsr, node->macaddress_A);
+			hash_del_rcu(&node->hash_A);
+			hash_del_rcu(&node->hash_B);
 			list_del_rcu(&node->mac_list);
 			/* Note that we need to free this entry later: */
 			kfree_rcu(node, rcu_head);
@@ -483,7 +601,7 @@ int hsr_get_node_data(struct hsr_priv *hsr,
 	unsigned long tdiff;
 
 	rcu_read_lock();
-	node = find_node_by_addr_A(&hsr->node_db, addr);
+	node = find_node_by_addr_A(hsr, addr);
 	if (!node) {
 		rcu_read_unlock();
 		return -ENOENT;	/* No such entry */
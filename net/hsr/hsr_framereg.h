@@ -13,9 +13,9 @@
 struct hsr_node;
 
 void hsr_del_self_node(struct hsr_priv *hsr);
-void hsr_del_nodes(struct list_head *node_db);
+void hsr_del_nodes(struct hsr_priv *hsr);
 struct hsr_node *hsr_get_node(struct hsr_port *port, struct sk_buff *skb,
-			      bool is_sup);
+			      bool is_sup, struct prp_rct *rct);
 void hsr_handle_sup_frame(struct sk_buff *skb, struct hsr_node *node_curr,
 			  struct hsr_port *port);
 bool hsr_addr_is_self(struct hsr_priv *hsr, unsigned char *addr);
@@ -28,6 +28,8 @@ void hsr_register_frame_in(struct hsr_node *node, struct hsr_port *port,
 			   u16 sequence_nr);
 int hsr_register_frame_out(struct hsr_port *port, struct hsr_node *node,
 			   u16 sequence_nr);
+int prp_register_frame_out(struct hsr_port *port_rcv, struct hsr_node *node,
+			   u16 sequence_nr);
 
 void hsr_prune_nodes(struct timer_list *t);
 
@@ -48,14 +50,28 @@ int hsr_get_node_data(struct hsr_priv *hsr,
 		      u16 *if2_seq);
 
 struct hsr_node {
-	struct list_head	mac_list;
-	unsigned char		macaddress_A[ETH_ALEN];
-	unsigned char		macaddress_B[ETH_ALEN];
+	/* Per port state, looked at and updated for every frame from the
+	 * node, so keep it together on one cache line.
+	 */
+	unsigned long		time_in[HSR_PT_PORTS] ____cacheline_aligned;
+	u16			seq_out[HSR_PT_PORTS];
+	bool			time_in_stale[HSR_PT_PORTS];
+	/* PRP duplicate discard: for each LAN, the window of sequence numbers
+	 * accepted from it and not seen on the other LAN since.
+	 */
+	u16			prp_seq_start[2];
+	u16			prp_seq_expected[2];
+	unsigned long		prp_time;
+	spinlock_t		prp_lock;
+	/* Only ever heard from without HSR tag or RCT (PRP only) */
+	bool			san;
 	/* Local slave through which AddrB frames are received from this node */
 	enum hsr_port_type	addr_B_port;
-	unsigned long		time_in[HSR_PT_PORTS];
-	bool			time_in_stale[HSR_PT_PORTS];
-	u16			seq_out[HSR_PT_PORTS];
+	unsigned char		macaddress_A[ETH_ALEN];
+	unsigned char		macaddress_B[ETH_ALEN];
+	struct hlist_node	hash_A;
+	struct hlist_node	hash_B;
+	struct list_head	mac_list;
 	struct rcu_head		rcu_head;
 };
 
@@ -10,6 +10,8 @@
 
 #include <linux/netdevice.h>
 #include <linux/list.h>
+#include <linux/hashtable.h>
+#include <linux/u64_stats_sync.h>
 
 /* Time constants as specified in the HSR specification (IEC-62439-3 2010)
  * Table 8.
@@ -31,8 +33,23 @@
  */
 #define PRUNE_PERIOD			 3000 /* ms */
 
+/* Buckets of the node_db hash tables. Rings are typically a few hundred nodes
+ * at most, so this keeps the chains short without resizing.
+ */
+#define HSR_NODE_HASH_BITS		    8
+
 #define HSR_TLV_ANNOUNCE		   22
 #define HSR_TLV_LIFE_CHECK		   23
+/* PRP supervision frames of a DANP, resp. of a RedBox for a VDAN */
+#define PRP_TLV_LIFE_CHECK_DD		   20
+#define PRP_TLV_LIFE_CHECK_DA		   21
+
+/* Time after which a PRP node's duplicate discard state is forgotten, as in
+ * IEC-62439-3 2012 Table 6 (EntryForgetTime).
+ */
+#define PRP_ENTRY_FORGET_TIME		  400 /* ms */
+/* Largest span of sequence numbers in a duplicate discard window */
+#define PRP_DROP_WINDOW_LEN		32768
 
 /* HSR Tag.
  * As defined in IEC-62439-3:2010, the HSR tag is really { ethertype = 0x88FB,
@@ -134,6 +151,37 @@ struct hsrv1_ethhdr_sp {
 	struct hsr_sup_tag	hsr_sup;
 } __packed;
 
+/* PRP Redundancy Control Trailer (RCT).
+ * As defined in IEC-62439-3:2012, appended to the frames of a DANP, after the
+ * payload and any padding. Its size is that of the HSR tag. The LSDU size
+ * counts the payload (the frame past the ethernet header), padding and RCT.
+ */
+struct prp_rct {
+	__be16		sequence_nr;
+	__be16		lan_id_and_LSDU_size;
+	__be16		PRP_suffix;
+} __packed;
+
+#define PRP_LAN_ID_A	0xa
+#define PRP_LAN_ID_B	0xb
+
+static inline u16 get_prp_lan_id(struct prp_rct *rct)
+{
+	return ntohs(rct->lan_id_and_LSDU_size) >> 12;
+}
+
+static inline u16 get_prp_LSDU_size(struct prp_rct *rct)
+{
+	return ntohs(rct->lan_id_and_LSDU_size) & 0x0FFF;
+}
+
+static inline void set_prp_lan_id_and_LSDU_size(struct prp_rct *rct,
+						u16 lan_id, u16 LSDU_size)
+{
+	rct->lan_id_and_LSDU_size = htons((lan_id << 12) |
+					  (LSDU_size & 0x0FFF));
+}
+
 enum hsr_port_type {
 	HSR_PT_NONE = 0,	/* Must be 0, used by framereg */
 	HSR_PT_SLAVE_A,
@@ -143,30 +191,62 @@ enum hsr_port_type {
 	HSR_PT_PORTS,	/* This must be the last item in the enum */
 };
 
+/* Per port (per LAN, for PRP) frame counters */
+struct hsr_port_stats {
+	u64			rx_frames;
+	/* Received without HSR tag or RCT, i.e. from a SAN (PRP only) */
+	u64			rx_untagged;
+	/* RCT with the LAN ID of the other LAN (PRP only) */
+	u64			rx_wrong_lan;
+	/* Not delivered locally, as already received on the other port */
+	u64			rx_duplicates;
+	u64			tx_frames;
+	struct u64_stats_sync	syncp;
+};
+
 struct hsr_port {
 	struct list_head	port_list;
 	struct net_device	*dev;
 	struct hsr_priv		*hsr;
 	enum hsr_port_type	type;
+	struct hsr_port_stats __percpu *stats;
 };
 
+#define hsr_port_stats_inc(port, field)				\
+	do {								\
+		struct hsr_port_stats *__s = this_cpu_ptr((port)->stats); \
+									\
+		u64_stats_update_begin(&__s->syncp);			\
+		__s->field++;						\
+		u64_stats_update_end(&__s->syncp);			\
+	} while (0)
+
+/* Values of hsr_priv::prot_version. PRP has a single version so far. */
+#define HSR_V0		0
+#define HSR_V1		1
+#define PRP_V1		2
+
 struct hsr_priv {
 	struct rcu_head		rcu_head;
 	struct list_head	ports;
 	struct list_head	node_db;	/* Known HSR nodes */
+	/* node_db entries by their macaddress_A, resp. macaddress_B */
+	DECLARE_HASHTABLE(node_hash_A, HSR_NODE_HASH_BITS);
+	DECLARE_HASHTABLE(node_hash_B, HSR_NODE_HASH_BITS);
 	struct list_head	self_node_db;	/* MACs of slaves */
 	struct timer_list	announce_timer;	/* Supervision frame dispatch */
 	struct timer_list	prune_timer;
 	int announce_count;
 	u16 sequence_nr;
 	u16 sup_sequence_nr;	/* For HSRv1 separate seq_nr for supervision */
-	u8 prot_version;	/* Indicate if HSRv0 or HSRv1. */
+	u8 prot_version;	/* Indicate if HSRv0, HSRv1 or PRP */
 	spinlock_t seqnr_lock;	/* locking for sequence_nr */
-	spinlock_t list_lock;	/* locking for node list */
+	spinlock_t list_lock;	/* locking for node list and hash tables */
 	unsigned char		sup_multicast_addr[ETH_ALEN];
 #ifdef	CONFIG_DEBUG_FS
 	struct dentry *node_tbl_root;
 	struct dentry *node_tbl_file;
+	struct dentry *port_stats_file;
 #endif
 };
 
@@ -184,6 +264,11 @@ static inline u16 hsr_get_skb_sequence_nr(struct sk_buff *skb)
 	return ntohs(hsr_ethhdr->hsr_tag.sequence_nr);
 }
 
+static inline bool hsr_is_prp(struct hsr_priv *hsr)
+{
+	return hsr->prot_version == PRP_V1;
+}
+
 #if IS_ENABLED(CONFIG_DEBUG_FS)
 void hsr_debugfs_rename(struct net_device *dev);
 void hsr_debugfs_init(struct hsr_priv *priv, struct net_device *hsr_dev);
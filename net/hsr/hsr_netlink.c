@@ -22,6 +22,7 @@ static const struct nla_policy hsr_policy[IFLA_HSR_MAX + 1] = {
 	[IFLA_HSR_VERSION]	= { .type = NLA_U8 },
 	[IFLA_HSR_SUPERVISION_ADDR]	= { .len = ETH_ALEN },
 	[IFLA_HSR_SEQ_NR]		= { .type = NLA_U16 },
+	[IFLA_HSR_PROTOCOL]		= { .type = NLA_U8 },
 };
 
 /* Here, it seems a netdevice has already been allocated for us, and the
@@ -33,6 +34,7 @@ static int hsr_newlink(struct net *src_net, struct net_device *dev,
 {
 	struct net_device *link[2];
 	unsigned char multicast_spec, hsr_version;
+	u8 proto = HSR_PROTOCOL_HSR;
 
 	if (!data) {
 		netdev_info(dev, "HSR: No slave devices specified\n");
@@ -61,10 +63,29 @@ static int hsr_newlink(struct net *src_net, struct net_device *dev,
 	else
 		multicast_spec = nla_get_u8(data[IFLA_HSR_MULTICAST_SPEC]);
 
-	if (!data[IFLA_HSR_VERSION])
-		hsr_version = 0;
-	else
+	if (data[IFLA_HSR_PROTOCOL])
+		proto = nla_get_u8(data[IFLA_HSR_PROTOCOL]);
+	if (proto >= HSR_PROTOCOL_MAX) {
+		netdev_info(dev, "HSR: Unsupported protocol\n");
+		return -EINVAL;
+	}
+
+	if (!data[IFLA_HSR_VERSION]) {
+		hsr_version = HSR_V0;
+	} else {
 		hsr_version = nla_get_u8(data[IFLA_HSR_VERSION]);
+		if (proto == HSR_PROTOCOL_PRP) {
+			netdev_info(dev, "HSR: Version only applies to HSR\n");
+			return -EINVAL;
+		}
+		if (hsr_version > HSR_V1) {
+			netdev_info(dev, "HSR: Only versions 0 and 1 are supported\n");
+			return -EINVAL;
+		}
+	}
+
+	if (proto == HSR_PROTOCOL_PRP)
+		hsr_version = PRP_V1;
 
 	return hsr_dev_finalize(dev, link, multicast_spec, hsr_version);
 }
@@ -97,7 +118,9 @@ static int hsr_fill_info(struct sk_buff *skb, const struct net_device *dev)
 
 	if (nla_put(skb, IFLA_HSR_SUPERVISION_ADDR, ETH_ALEN,
 		    hsr->sup_multicast_addr) ||
-	    nla_put_u16(skb, IFLA_HSR_SEQ_NR, hsr->sequence_nr))
+	    nla_put_u16(skb, IFLA_HSR_SEQ_NR, hsr->sequence_nr) ||
+	    nla_put_u8(skb, IFLA_HSR_PROTOCOL, hsr_is_prp(hsr) ?
+		       HSR_PROTOCOL_PRP : HSR_PROTOCOL_HSR))
 		goto nla_put_failure;
 
 	return 0;
@@ -34,8 +34,10 @@ static rx_handler_result_t hsr_handle_frame(struct sk_buff **pskb)
 		goto finish_consume;
 	}
 
+	/* PRP frames are tagged at the tail, and SANs send untagged ones */
 	protocol = eth_hdr(skb)->h_proto;
-	if (protocol != htons(ETH_P_PRP) && protocol != htons(ETH_P_HSR))
+	if (!hsr_is_prp(port->hsr) &&
+	    protocol != htons(ETH_P_PRP) && protocol != htons(ETH_P_HSR))
 		goto finish_pass;
 
 	skb_push(skb, ETH_HLEN);
@@ -143,6 +145,12 @@ int hsr_add_port(struct hsr_priv *hsr, struct net_device *dev,
 	if (!port)
 		return -ENOMEM;
 
+	port->stats = netdev_alloc_pcpu_stats(struct hsr_port_stats);
+	if (!port->stats) {
+		res = -ENOMEM;
+		goto fail_stats;
+	}
+
 	if (type != HSR_PT_MASTER) {
 		res = hsr_portdev_setup(dev, port);
 		if (res)
@@ -163,6 +171,8 @@ int hsr_add_port(struct hsr_priv *hsr, struct net_device *dev,
 	return 0;
 
 fail_dev_setup:
+	free_percpu(port->stats);
+fail_stats:
 	kfree(port);
 	return res;
 }
@@ -193,5 +203,34 @@ void hsr_del_port(struct hsr_port *port)
 
 	if (port != master)
 		dev_put(port->dev);
+	free_percpu(port->stats);
 	kfree(port);
 }
+
+void hsr_port_get_stats(struct hsr_port *port, struct hsr_port_stats *stats)
+{
+	int cpu;
+
+	memset(stats, 0, sizeof(*stats));
+
+	for_each_possible_cpu(cpu) {
+		const struct hsr_port_stats *s = per_cpu_ptr(port->stats, cpu);
+		u64 rx, rx_untagged, rx_wrong_lan, rx_duplicates, tx;
+		unsigned int start;
+
+		do {
+			start = u64_stats_fetch_begin_irq(&s->syncp);
+			rx = s->rx_frames;
+			rx_untagged = s->rx_untagged;
+			rx_wrong_lan = s->rx_wrong_lan;
+			rx_duplicates = s->rx_duplicates;
+			tx = s->tx_frames;
+		} while (u64_stats_fetch_retry_irq(&s->syncp, start));
+
+		stats->rx_frames += rx;
+		stats->rx_untagged += rx_untagged;
+		stats->rx_wrong_lan += rx_wrong_lan;
+		stats->rx_duplicates += rx_duplicates;
+		stats->tx_frames += tx;
+	}
+}
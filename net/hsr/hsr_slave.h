@@ -16,6 +16,7 @@ int hsr_add_port(struct hsr_priv *hsr, struct net_device *dev,
 		 enum hsr_port_type pt);
 void hsr_del_port(struct hsr_port *port);
 bool hsr_port_exists(const struct net_device *dev);
+void hsr_port_get_stats(struct hsr_port *port, struct hsr_port_stats *stats);
 
 static inline struct hsr_port *hsr_port_get_rtnl(const struct net_device *dev)
 {
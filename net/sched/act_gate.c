@@ -0,0 +1,648 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/* Copyright 2020 NXP
+ *
+ * IEEE 802.1Qci stream gate. Frames of the stream(s) classified into this
+ * action pass or are dropped according to a gate control list, which opens
+ * and closes the gate on a cycle that follows the same base-time and
+ * cycle-time rules as taprio, on a configurable clock (usually CLOCK_TAI,
+ * synchronized with PTP). Each entry may also limit the octets passed while
+ * it is in effect, and set the internal priority value (skb->priority) of
+ * the frames it lets through.
+ */
+
+#include <linux/module.h>
+#include <linux/types.h>
+#include <linux/kernel.h>
+#include <linux/string.h>
+#include <linux/errno.h>
+#include <linux/skbuff.h>
+#include <linux/rtnetlink.h>
+#include <linux/init.h>
+#include <linux/slab.h>
+#include <net/act_api.h>
+#include <net/netlink.h>
+#include <net/pkt_cls.h>
+#include <net/tc_act/tc_gate.h>
+
+static unsigned int gate_net_id;
+static struct tc_action_ops act_gate_ops;
+
+static ktime_t gate_get_time(struct tcf_gate *gact)
+{
+	ktime_t mono = ktime_get();
+
+	switch (gact->tk_offset) {
+	case TK_OFFS_MAX:
+		return mono;
+	default:
+		return ktime_mono_to_any(mono, gact->tk_offset);
+	}
+
+	return KTIME_MAX;
+}
+
+/* The first cycle start which is not in the past */
+static ktime_t gate_get_start_time(struct tcf_gate *gact)
+{
+	struct tcf_gate_params *p = &gact->param;
+	ktime_t now, base;
+	u64 n;
+
+	base = ns_to_ktime(p->tcfg_basetime);
+	now = gate_get_time(gact);
+
+	if (ktime_after(base, now))
+		return base;
+
+	n = div64_u64(ktime_sub_ns(now, base), p->tcfg_cycletime);
+
+	return ktime_add_ns(base, (n + 1) * p->tcfg_cycletime);
+}
+
+/* Fires when gact->next_entry comes into effect */
+static enum hrtimer_restart gate_timer_func(struct hrtimer *timer)
+{
+	struct tcf_gate *gact = container_of(timer, struct tcf_gate, hitimer);
+	struct tcf_gate_params *p = &gact->param;
+	struct tcfg_gate_entry *entry, *first;
+	ktime_t start, close_time;
+
+	spin_lock(&gact->tcf_lock);
+
+	first = list_first_entry(&p->entries, struct tcfg_gate_entry, list);
+	entry = gact->next_entry;
+	start = hrtimer_get_expires(timer);
+
+	gact->current_gate_status = entry->gate_state ? GATE_ACT_GATE_OPEN : 0;
+	gact->current_entry_octets = 0;
+	gact->current_max_octets = entry->maxoctets;
+	gact->current_ipv = entry->ipv;
+
+	/* As in taprio, an entry is cut short by the end of the cycle */
+	if (entry == first)
+		gact->current_close_time = ktime_add_ns(start,
+							p->tcfg_cycletime);
+	close_time = ktime_add_ns(start, entry->interval);
+	if (ktime_after(close_time, gact->current_close_time))
+		close_time = gact->current_close_time;
+
+	if (list_is_last(&entry->list, &p->entries) ||
+	    close_time == gact->current_close_time)
+		entry = first;
+	else
+		entry = list_next_entry(entry, list);
+
+	/* Fell behind (e.g. the clock was stepped): keep the current state
+	 * until the next cycle starts.
+	 */
+	if (ktime_after(gate_get_time(gact), close_time)) {
+		close_time = gate_get_start_time(gact);
+		entry = first;
+	}
+
+	gact->next_entry = entry;
+	hrtimer_set_expires(timer, close_time);
+
+	spin_unlock(&gact->tcf_lock);
+
+	return HRTIMER_RESTART;
+}
+
+static int tcf_gate_act(struct sk_buff *skb, const struct tc_action *a,
+			struct tcf_result *res)
+{
+	struct tcf_gate *gact = to_gate(a);
+	int action;
+
+	spin_lock(&gact->tcf_lock);
+
+	tcf_lastuse_update(&gact->tcf_tm);
+	bstats_update(&gact->tcf_bstats, skb);
+	action = gact->tcf_action;
+
+	/* The schedule has not started yet */
+	if (unlikely(gact->current_gate_status & GATE_ACT_PENDING))
+		goto out;
+
+	if (!(gact->current_gate_status & GATE_ACT_GATE_OPEN))
+		goto drop;
+
+	if (gact->current_max_octets >= 0) {
+		gact->current_entry_octets += qdisc_pkt_len(skb);
+		if (gact->current_entry_octets > gact->current_max_octets) {
+			gact->tcf_qstats.overlimits++;
+			goto drop;
+		}
+	}
+
+	if (gact->current_ipv >= 0)
+		skb->priority = gact->current_ipv;
+out:
+	spin_unlock(&gact->tcf_lock);
+
+	return action;
+
+drop:
+	gact->tcf_qstats.drops++;
+	spin_unlock(&gact->tcf_lock);
+
+	return TC_ACT_SHOT;
+}
+
+static const struct nla_policy entry_policy[TCA_GATE_ENTRY_MAX + 1] = {
+	[TCA_GATE_ENTRY_INDEX]		= { .type = NLA_U32 },
+	[TCA_GATE_ENTRY_GATE]		= { .type = NLA_FLAG },
+	[TCA_GATE_ENTRY_INTERVAL]	= { .type = NLA_U32 },
+	[TCA_GATE_ENTRY_IPV]		= { .type = NLA_S32 },
+	[TCA_GATE_ENTRY_MAX_OCTETS]	= { .type = NLA_S32 },
+};
+
+static const struct nla_policy gate_policy[TCA_GATE_MAX + 1] = {
+	[TCA_GATE_PARMS]		=
+		NLA_POLICY_EXACT_LEN(sizeof(struct tc_gate)),
+	[TCA_GATE_PRIORITY]		= { .type = NLA_S32 },
+	[TCA_GATE_ENTRY_LIST]		= { .type = NLA_NESTED },
+	[TCA_GATE_BASE_TIME]		= { .type = NLA_U64 },
+	[TCA_GATE_CYCLE_TIME]		= { .type = NLA_U64 },
+	[TCA_GATE_CYCLE_TIME_EXT]	= { .type = NLA_U64 },
+	[TCA_GATE_FLAGS]		= { .type = NLA_U32 },
+	[TCA_GATE_CLOCKID]		= { .type = NLA_S32 },
+};
+
+static int fill_gate_entry(struct nlattr **tb, struct tcfg_gate_entry *entry,
+			   struct netlink_ext_ack *extack)
+{
+	u32 interval = 0;
+
+	entry->gate_state = nla_get_flag(tb[TCA_GATE_ENTRY_GATE]);
+
+	if (tb[TCA_GATE_ENTRY_INTERVAL])
+		interval = nla_get_u32(tb[TCA_GATE_ENTRY_INTERVAL]);
+
+	if (interval == 0) {
+		NL_SET_ERR_MSG(extack, "Invalid interval for gate entry");
+		return -EINVAL;
+	}
+
+	entry->interval = interval;
+
+	entry->ipv = tb[TCA_GATE_ENTRY_IPV] ?
+		     nla_get_s32(tb[TCA_GATE_ENTRY_IPV]) : -1;
+	entry->maxoctets = tb[TCA_GATE_ENTRY_MAX_OCTETS] ?
+			   nla_get_s32(tb[TCA_GATE_ENTRY_MAX_OCTETS]) : -1;
+
+	return 0;
+}
+
+static int parse_gate_entry(struct nlattr *n, struct tcfg_gate_entry *entry,
+			    int index, struct netlink_ext_ack *extack)
+{
+	struct nlattr *tb[TCA_GATE_ENTRY_MAX + 1] = { };
+	int err;
+
+	err = nla_parse_nested(tb, TCA_GATE_ENTRY_MAX, n, entry_policy,
+			       extack);
+	if (err < 0) {
+		NL_SET_ERR_MSG(extack, "Could not parse nested entry");
+		return -EINVAL;
+	}
+
+	entry->index = index;
+
+	return fill_gate_entry(tb, entry, extack);
+}
+
+static void release_entry_list(struct list_head *entries)
+{
+	struct tcfg_gate_entry *entry, *e;
+
+	list_for_each_entry_safe(entry, e, entries, list) {
+		list_del(&entry->list);
+		kfree(entry);
+	}
+}
+
+static int parse_gate_list(struct nlattr *list_attr,
+			   struct tcf_gate_params *p,
+			   struct netlink_ext_ack *extack)
+{
+	struct tcfg_gate_entry *entry;
+	struct nlattr *n;
+	int err, rem;
+	int i = 0;
+
+	nla_for_each_nested(n, list_attr, rem) {
+		if (nla_type(n) != TCA_GATE_ONE_ENTRY) {
+			NL_SET_ERR_MSG(extack, "Attribute isn't type 'entry'");
+			continue;
+		}
+
+		entry = kzalloc(sizeof(*entry), GFP_KERNEL);
+		if (!entry) {
+			NL_SET_ERR_MSG(extack, "Not enough memory for entry");
+			err = -ENOMEM;
+			goto release_list;
+		}
+
+		err = parse_gate_entry(n, entry, i, extack);
+		if (err < 0) {
+			kfree(entry);
+			goto release_list;
+		}
+
+		list_add_tail(&entry->list, &p->entries);
+		i++;
+	}
+
+	p->num_entries = i;
+
+	return i;
+
+release_list:
+	release_entry_list(&p->entries);
+
+	return err;
+}
+
+static int gate_clockid_to_tk_offset(s32 clockid, enum tk_offsets *tk_offset,
+				     struct netlink_ext_ack *extack)
+{
+	switch (clockid) {
+	case CLOCK_REALTIME:
+		*tk_offset = TK_OFFS_REAL;
+		break;
+	case CLOCK_MONOTONIC:
+		*tk_offset = TK_OFFS_MAX;
+		break;
+	case CLOCK_BOOTTIME:
+		*tk_offset = TK_OFFS_BOOT;
+		break;
+	case CLOCK_TAI:
+		*tk_offset = TK_OFFS_TAI;
+		break;
+	default:
+		NL_SET_ERR_MSG(extack, "Invalid 'clockid'");
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static int tcf_gate_init(struct net *net, struct nlattr *nla,
+			 struct nlattr *est, struct tc_action **a,
+			 int ovr, int bind, bool rtnl_held,
+			 struct tcf_proto *tp, u32 flags,
+			 struct netlink_ext_ack *extack)
+{
+	struct tc_action_net *tn = net_generic(net, gate_net_id);
+	struct nlattr *tb[TCA_GATE_MAX + 1];
+	struct tcf_chain *goto_ch = NULL;
+	struct tcfg_gate_entry *entry;
+	enum tk_offsets tk_offset;
+	struct tcf_gate_params p;
+	s32 clockid = CLOCK_TAI;
+	struct tcf_gate *gact;
+	struct tc_gate *parm;
+	bool exists = false;
+	u64 cycle = 0;
+	int ret = 0, err;
+	u32 index;
+
+	if (!nla)
+		return -EINVAL;
+
+	err = nla_parse_nested(tb, TCA_GATE_MAX, nla, gate_policy, extack);
+	if (err < 0)
+		return err;
+
+	if (!tb[TCA_GATE_PARMS]) {
+		NL_SET_ERR_MSG(extack, "Missing gate parameters");
+		return -EINVAL;
+	}
+
+	if (tb[TCA_GATE_CLOCKID])
+		clockid = nla_get_s32(tb[TCA_GATE_CLOCKID]);
+
+	err = gate_clockid_to_tk_offset(clockid, &tk_offset, extack);
+	if (err)
+		return err;
+
+	parm = nla_data(tb[TCA_GATE_PARMS]);
+	index = parm->index;
+
+	err = tcf_idr_check_alloc(tn, &index, a, bind);
+	if (err < 0)
+		return err;
+	exists = err;
+	if (exists && bind)
+		return 0;
+
+	if (!tb[TCA_GATE_ENTRY_LIST]) {
+		NL_SET_ERR_MSG(extack, "A gate control list is required");
+		err = -EINVAL;
+		goto cleanup_idr;
+	}
+
+	memset(&p, 0, sizeof(p));
+	INIT_LIST_HEAD(&p.entries);
+
+	err = parse_gate_list(tb[TCA_GATE_ENTRY_LIST], &p, extack);
+	if (err < 0)
+		goto cleanup_idr;
+	if (!err) {
+		NL_SET_ERR_MSG(extack, "The gate control list is empty");
+		err = -EINVAL;
+		goto cleanup_idr;
+	}
+
+	if (tb[TCA_GATE_CYCLE_TIME])
+		cycle = nla_get_u64(tb[TCA_GATE_CYCLE_TIME]);
+
+	/* As in taprio, the cycle defaults to the sum of the intervals */
+	if (!cycle) {
+		list_for_each_entry(entry, &p.entries, list)
+			cycle += entry->interval;
+	}
+
+	p.tcfg_cycletime = cycle;
+	p.tcfg_clockid = clockid;
+
+	if (tb[TCA_GATE_PRIORITY])
+		p.tcfg_priority = nla_get_s32(tb[TCA_GATE_PRIORITY]);
+
+	if (tb[TCA_GATE_BASE_TIME])
+		p.tcfg_basetime = nla_get_u64(tb[TCA_GATE_BASE_TIME]);
+
+	if (tb[TCA_GATE_CYCLE_TIME_EXT])
+		p.tcfg_cycletime_ext = nla_get_u64(tb[TCA_GATE_CYCLE_TIME_EXT]);
+
+	if (tb[TCA_GATE_FLAGS])
+		p.tcfg_flags = nla_get_u32(tb[TCA_GATE_FLAGS]);
+
+	if (!exists) {
+		ret = tcf_idr_create(tn, index, est, a,
+				     &act_gate_ops, bind, false, 0);
+		if (ret) {
+			release_entry_list(&p.entries);
+			tcf_idr_cleanup(tn, index);
+			return ret;
+		}
+
+		gact = to_gate(*a);
+		INIT_LIST_HEAD(&gact->param.entries);
+		hrtimer_init(&gact->hitimer, clockid, HRTIMER_MODE_ABS_SOFT);
+		gact->hitimer.function = gate_timer_func;
+
+		ret = ACT_P_CREATED;
+	} else if (!ovr) {
+		release_entry_list(&p.entries);
+		tcf_idr_release(*a, bind);
+		return -EEXIST;
+	}
+
+	err = tcf_action_check_ctrlact(parm->action, tp, &goto_ch, extack);
+	if (err < 0)
+		goto release_idr;
+
+	gact = to_gate(*a);
+
+	/* The timer walks the old list, so it must be stopped before the
+	 * list is swapped. It is restarted on the new schedule below, and
+	 * possibly on another clock.
+	 */
+	if (ret != ACT_P_CREATED) {
+		hrtimer_cancel(&gact->hitimer);
+		hrtimer_init(&gact->hitimer, clockid, HRTIMER_MODE_ABS_SOFT);
+		gact->hitimer.function = gate_timer_func;
+	}
+
+	spin_lock_bh(&gact->tcf_lock);
+
+	goto_ch = tcf_action_set_ctrlact(*a, parm->action, goto_ch);
+
+	release_entry_list(&gact->param.entries);
+	gact->param = p;
+	INIT_LIST_HEAD(&gact->param.entries);
+	list_splice_tail(&p.entries, &gact->param.entries);
+	gact->tk_offset = tk_offset;
+
+	/* Frames pass until the schedule starts */
+	gact->current_gate_status = GATE_ACT_GATE_OPEN | GATE_ACT_PENDING;
+	gact->current_entry_octets = 0;
+	gact->current_max_octets = -1;
+	gact->current_ipv = -1;
+	gact->current_close_time = 0;
+	gact->next_entry = list_first_entry(&gact->param.entries,
+					    struct tcfg_gate_entry, list);
+
+	hrtimer_start(&gact->hitimer, gate_get_start_time(gact),
+		      HRTIMER_MODE_ABS_SOFT);
+
+	spin_unlock_bh(&gact->tcf_lock);
+
+	if (goto_ch)
+		tcf_chain_put_by_act(goto_ch);
+
+	if (ret == ACT_P_CREATED)
+		tcf_idr_insert(tn, *a);
+	return ret;
+
+release_idr:
+	release_entry_list(&p.entries);
+	tcf_idr_release(*a, bind);
+	return err;
+cleanup_idr:
+	if (exists)
+		tcf_idr_release(*a, bind);
+	else
+		tcf_idr_cleanup(tn, index);
+	return err;
+}
+
+static void tcf_gate_cleanup(struct tc_action *a)
+{
+	struct tcf_gate *gact = to_gate(a);
+
+	hrtimer_cancel(&gact->hitimer);
+	release_entry_list(&gact->param.entries);
+}
+
+static int dumping_entry(struct sk_buff *skb,
+			 struct tcfg_gate_entry *entry)
+{
+	struct nlattr *item;
+
+	item = nla_nest_start_noflag(skb, TCA_GATE_ONE_ENTRY);
+	if (!item)
+		return -ENOSPC;
+
+	if (nla_put_u32(skb, TCA_GATE_ENTRY_INDEX, entry->index))
+		goto nla_put_failure;
+
+	if (entry->gate_state && nla_put_flag(skb, TCA_GATE_ENTRY_GATE))
+		goto nla_put_failure;
+
+	if (nla_put_u32(skb, TCA_GATE_ENTRY_INTERVAL, entry->interval))
+		goto nla_put_failure;
+
+	if (nla_put_s32(skb, TCA_GATE_ENTRY_MAX_OCTETS, entry->maxoctets))
+		goto nla_put_failure;
+
+	if (nla_put_s32(skb, TCA_GATE_ENTRY_IPV, entry->ipv))
+		goto nla_put_failure;
+
+	return nla_nest_end(skb, item);
+
+nla_put_failure:
+	nla_nest_cancel(skb, item);
+	return -1;
+}
+
+static int tcf_gate_dump(struct sk_buff *skb, struct tc_action *a,
+			 int bind, int ref)
+{
+	unsigned char *b = skb_tail_pointer(skb);
+	struct tcf_gate *gact = to_gate(a);
+	struct tc_gate opt = {
+		.index    = gact->tcf_index,
+		.refcnt   = refcount_read(&gact->tcf_refcnt) - ref,
+		.bindcnt  = atomic_read(&gact->tcf_bindcnt) - bind,
+	};
+	struct tcfg_gate_entry *entry;
+	struct tcf_gate_params *p;
+	struct nlattr *entry_list;
+	struct tcf_t t;
+
+	spin_lock_bh(&gact->tcf_lock);
+	opt.action = gact->tcf_action;
+
+	p = &gact->param;
+
+	if (nla_put(skb, TCA_GATE_PARMS, sizeof(opt), &opt))
+		goto nla_put_failure;
+
+	if (nla_put_u64_64bit(skb, TCA_GATE_BASE_TIME,
+			      p->tcfg_basetime, TCA_GATE_PAD))
+		goto nla_put_failure;
+
+	if (nla_put_u64_64bit(skb, TCA_GATE_CYCLE_TIME,
+			      p->tcfg_cycletime, TCA_GATE_PAD))
+		goto nla_put_failure;
+
+	if (nla_put_u64_64bit(skb, TCA_GATE_CYCLE_TIME_EXT,
+			      p->tcfg_cycletime_ext, TCA_GATE_PAD))
+		goto nla_put_failure;
+
+	if (nla_put_s32(skb, TCA_GATE_CLOCKID, p->tcfg_clockid))
+		goto nla_put_failure;
+
+	if (nla_put_u32(skb, TCA_GATE_FLAGS, p->tcfg_flags))
+		goto nla_put_failure;
+
+	if (nla_put_s32(skb, TCA_GATE_PRIORITY, p->tcfg_priority))
+		goto nla_put_failure;
+
+	entry_list = nla_nest_start_noflag(skb, TCA_GATE_ENTRY_LIST);
+	if (!entry_list)
+		goto nla_put_failure;
+
+	list_for_each_entry(entry, &p->entries, list) {
+		if (dumping_entry(skb, entry) < 0)
+			goto nla_put_failure;
+	}
+
+	nla_nest_end(skb, entry_list);
+
+	tcf_tm_dump(&t, &gact->tcf_tm);
+	if (nla_put_64bit(skb, TCA_GATE_TM, sizeof(t), &t, TCA_GATE_PAD))
+		goto nla_put_failure;
+	spin_unlock_bh(&gact->tcf_lock);
+
+	return skb->len;
+
+nla_put_failure:
+	spin_unlock_bh(&gact->tcf_lock);
+	nlmsg_trim(skb, b);
+	return -1;
+}
+
+static int tcf_gate_walker(struct net *net, struct sk_buff *skb,
+			   struct netlink_callback *cb, int type,
+			   const struct tc_action_ops *ops,
+			   struct netlink_ext_ack *extack)
+{
+	struct tc_action_net *tn = net_generic(net, gate_net_id);
+
+	return tcf_generic_walker(tn, skb, cb, type, ops, extack);
+}
+
+static void tcf_gate_stats_update(struct tc_action *a, u64 bytes, u32 packets,
+				  u64 lastuse, bool hw)
+{
+	struct tcf_gate *gact = to_gate(a);
+	struct tcf_t *tm = &gact->tcf_tm;
+
+	tcf_action_update_stats(a, bytes, packets, false, hw);
+	tm->lastuse = max_t(u64, tm->lastuse, lastuse);
+}
+
+static int tcf_gate_search(struct net *net, struct tc_action **a, u32 index)
+{
+	struct tc_action_net *tn = net_generic(net, gate_net_id);
+
+	return tcf_idr_search(tn, a, index);
+}
+
+static size_t tcf_gate_get_fill_size(const struct tc_action *act)
+{
+	return nla_total_size(sizeof(struct tc_gate));
+}
+
+static struct tc_action_ops act_gate_ops = {
+	.kind		=	"gate",
+	.id		=	TCA_ID_GATE,
+	.owner		=	THIS_MODULE,
+	.act		=	tcf_gate_act,
+	.dump		=	tcf_gate_dump,
+	.init		=	tcf_gate_init,
+	.cleanup	=	tcf_gate_cleanup,
+	.walk		=	tcf_gate_walker,
+	.stats_update	=	tcf_gate_stats_update,
+	.get_fill_size	=	tcf_gate_get_fill_size,
+	.lookup		=	tcf_gate_search,
+	.size		=	sizeof(struct tcf_gate),
+};
+
+static __net_init int gate_init_net(struct net *net)
+{
+	struct tc_action_net *tn = net_generic(net, gate_net_id);
+
+	return tc_action_net_init(net, tn, &act_gate_ops);
+}
+
+static void __net_exit gate_exit_net(struct list_head *net_list)
+{
+	tc_action_net_exit(net_list, gate_net_id);
+}
+
+static struct pernet_operations gate_net_ops = {
+	.init = gate_init_net,
+	.exit_batch = gate_exit_net,
+	.id   = &gate_net_id,
+	.size = sizeof(struct tc_action_net),
+};
+
+static int __init gate_init_module(void)
+{
+	return tcf_register_action(&act_gate_ops, &gate_net_ops);
+}
+
+static void __exit gate_cleanup_module(void)
+{
+	tcf_unregister_action(&act_gate_ops, &gate_net_ops);
+}
+
+module_init(gate_init_module);
+module_exit(gate_cleanup_module);
+MODULE_DESCRIPTION("IEEE 802.1Qci stream gate action");
+MODULE_LICENSE("GPL v2");
@@ -20,7 +20,9 @@
 #include <net/pkt_cls.h>
 #include <net/tc_act/tc_police.h>
 
-/* Each policer is serialized by its individual spinlock */
+/* Each policer is serialized by its individual spinlock, unless it is in
+ * scalable mode, in which case its bucket is updated with cmpxchg.
+ */
 
 static unsigned int police_net_id;
 static struct tc_action_ops act_police_ops;
@@ -42,8 +44,19 @@ static const struct nla_policy police_policy[TCA_POLICE_MAX + 1] = {
 	[TCA_POLICE_RESULT]	= { .type = NLA_U32 },
 	[TCA_POLICE_RATE64]     = { .type = NLA_U64 },
 	[TCA_POLICE_PEAKRATE64] = { .type = NLA_U64 },
+	[TCA_POLICE_FLAGS]	= { .type = NLA_U32 },
 };
 
+static void tcf_police_params_free(struct rcu_head *head)
+{
+	struct tcf_police_params *p = container_of(head,
+						   struct tcf_police_params,
+						   rcu);
+
+	free_percpu(p->tcfp_pcpu_toks);
+	kfree(p);
+}
+
 static int tcf_police_init(struct net *net, struct nlattr *nla,
 			       struct nlattr *est, struct tc_action **a,
 			       int ovr, int bind, bool rtnl_held,
@@ -59,7 +72,7 @@ static int tcf_police_init(struct net *net, struct nlattr *nla,
 	struct tc_action_net *tn = net_generic(net, police_net_id);
 	struct tcf_police_params *new;
 	bool exists = false;
-	u32 index;
+	u32 index, flags = 0;
 	u64 rate64, prate64;
 
 	if (nla == NULL)
@@ -132,6 +145,21 @@ static int tcf_police_init(struct net *net, struct nlattr *nla,
 		goto failure;
 	}
 
+	if (tb[TCA_POLICE_FLAGS]) {
+		flags = nla_get_u32(tb[TCA_POLICE_FLAGS]);
+		if (flags & ~TCA_POLICE_FLAG_SCALABLE) {
+			NL_SET_ERR_MSG(extack, "Unknown police flags");
+			err = -EINVAL;
+			goto failure;
+		}
+		if ((flags & TCA_POLICE_FLAG_SCALABLE) && P_tab) {
+			NL_SET_ERR_MSG(extack,
+				       "Peak rate is not supported in scalable mode");
+			err = -EOPNOTSUPP;
+			goto failure;
+		}
+	}
+
 	if (tb[TCA_POLICE_RESULT]) {
 		tcfp_result = nla_get_u32(tb[TCA_POLICE_RESULT]);
 		if (TC_ACT_EXT_CMP(tcfp_result, TC_ACT_GOTO_CHAIN)) {
@@ -148,8 +176,18 @@ static int tcf_police_init(struct net *net, struct nlattr *nla,
 		goto failure;
 	}
 
+	if (flags & TCA_POLICE_FLAG_SCALABLE) {
+		new->tcfp_pcpu_toks = alloc_percpu(s64);
+		if (!new->tcfp_pcpu_toks) {
+			kfree(new);
+			err = -ENOMEM;
+			goto failure;
+		}
+	}
+
 	/* No failure allowed after this point */
 	new->tcfp_result = tcfp_result;
+	new->tcfp_flags = flags;
 	new->tcfp_mtu = parm->mtu;
 	if (!new->tcfp_mtu) {
 		new->tcfp_mtu = ~0;
@@ -176,6 +214,8 @@ static int tcf_police_init(struct net *net, struct nlattr *nla,
 	}
 
 	new->tcfp_burst = PSCHED_TICKS2NS(parm->burst);
+	/* Tokens sitting in the caches of all CPUs add at most half a burst */
+	new->tcfp_chunk = div_s64(new->tcfp_burst, 2 * num_possible_cpus());
 	if (new->peak_present)
 		new->tcfp_mtu_ptoks = (s64)psched_l2t_ns(&new->peak,
 							 new->tcfp_mtu);
@@ -189,6 +229,7 @@ static int tcf_police_init(struct net *net, struct nlattr *nla,
 	police->tcfp_toks = new->tcfp_burst;
 	if (new->peak_present)
 		police->tcfp_ptoks = new->tcfp_mtu_ptoks;
+	atomic64_set(&police->tcfp_tat, police->tcfp_t_c);
 	spin_unlock_bh(&police->tcfp_lock);
 	goto_ch = tcf_action_set_ctrlact(*a, parm->action, goto_ch);
 	new = rcu_replace_pointer(police->params,
@@ -199,7 +240,7 @@ static int tcf_police_init(struct net *net, struct nlattr *nla,
 	if (goto_ch)
 		tcf_chain_put_by_act(goto_ch);
 	if (new)
-		kfree_rcu(new, rcu);
+		call_rcu(&new->rcu, tcf_police_params_free);
 
 	if (ret == ACT_P_CREATED)
 		tcf_idr_insert(tn, *a);
@@ -215,6 +256,54 @@ static int tcf_police_init(struct net *net, struct nlattr *nla,
 	return err;
 }
 
+/* Takes @n ns worth of tokens from the shared bucket, if it has them */
+static bool tcf_police_take_shared(struct tcf_police *police, s64 burst,
+				   s64 now, s64 n)
+{
+	s64 tat, new;
+
+	tat = atomic64_read(&police->tcfp_tat);
+	do {
+		new = max(tat, now) + n;
+		if (new - now > burst)
+			return false;
+	} while (!atomic64_try_cmpxchg(&police->tcfp_tat, &tat, new));
+
+	return true;
+}
+
+static bool tcf_police_conform_scalable(struct tcf_police *police,
+					struct tcf_police_params *p,
+					unsigned int len)
+{
+	/* Actions run with BH disabled, so only this CPU touches its cache */
+	s64 *toks = this_cpu_ptr(p->tcfp_pcpu_toks);
+	s64 cost = (s64)psched_l2t_ns(&p->rate, len);
+	s64 now, need;
+
+	if (*toks < cost) {
+		need = cost - *toks;
+		now = ktime_get_ns();
+
+		/* Refill by a whole chunk if the bucket has one, otherwise
+		 * take just what this packet needs.
+		 */
+		if (need < p->tcfp_chunk &&
+		    tcf_police_take_shared(police, p->tcfp_burst, now,
+					   p->tcfp_chunk))
+			*toks += p->tcfp_chunk;
+		else if (tcf_police_take_shared(police, p->tcfp_burst, now,
+						need))
+			*toks += need;
+		else
+			return false;
+	}
+
+	*toks -= cost;
+
+	return true;
+}
+
 static int tcf_police_act(struct sk_buff *skb, const struct tc_action *a,
 			  struct tcf_result *res)
 {
@@ -243,6 +332,14 @@ static int tcf_police_act(struct sk_buff *skb, const struct tc_action *a,
 			goto end;
 		}
 
+		if (p->tcfp_flags & TCA_POLICE_FLAG_SCALABLE) {
+			if (!tcf_police_conform_scalable(police, p,
+							 qdisc_pkt_len(skb)))
+				goto inc_overlimits;
+			ret = p->tcfp_result;
+			goto inc_drops;
+		}
+
 		now = ktime_get_ns();
 		spin_lock_bh(&police->tcfp_lock);
 		toks = min_t(s64, now - police->tcfp_t_c, p->tcfp_burst);
@@ -284,7 +381,7 @@ static void tcf_police_cleanup(struct tc_action *a)
 
 	p = rcu_dereference_protected(police->params, 1);
 	if (p)
-		kfree_rcu(p, rcu);
+		call_rcu(&p->rcu, tcf_police_params_free);
 }
 
 static void tcf_police_stats_update(struct tc_action *a,
@@ -341,6 +438,9 @@ static int tcf_police_dump(struct sk_buff *skb, struct tc_action *a,
 	if (p->tcfp_ewma_rate &&
 	    nla_put_u32(skb, TCA_POLICE_AVRATE, p->tcfp_ewma_rate))
 		goto nla_put_failure;
+	if (p->tcfp_flags &&
+	    nla_put_u32(skb, TCA_POLICE_FLAGS, p->tcfp_flags))
+		goto nla_put_failure;
 
 	tcf_tm_dump(&t, &police->tcf_tm);
 	if (nla_put_64bit(skb, TCA_POLICE_TM, sizeof(t), &t, TCA_POLICE_PAD))
@@ -407,6 +507,8 @@ static int __init police_init_module(void)
 static void __exit police_cleanup_module(void)
 {
 	tcf_unregister_action(&act_police_ops, &police_net_ops);
+	/* Wait for tcf_police_params_free() */
+	rcu_barrier();
 }
 
 module_init(police_init_module);
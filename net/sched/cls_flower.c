@@ -9,6 +9,8 @@
 #include <linux/init.h>
 #include <linux/module.h>
 #include <linux/rhashtable.h>
+#include <linux/bsearch.h>
+#include <linux/sort.h>
 #include <linux/workqueue.h>
 #include <linux/refcount.h>
 
@@ -71,10 +73,33 @@ struct fl_flow_mask_range {
 	unsigned short int end;
 };
 
+/* Port range index of a mask with TCA_FLOWER_MASK_FLAGS_RANGE. The port space
+ * of the indexed side (destination if the mask has a destination range,
+ * source otherwise) is cut into segments at every filter's range boundaries,
+ * so that each segment is either fully inside or fully outside the range of
+ * any filter. Segment i covers ports [segs[i].start, segs[i + 1].start) and
+ * its candidate filters are filters[segs[i].first .. segs[i + 1].first), in
+ * the order of the mask's filters list.
+ */
+struct fl_range_seg {
+	u32 start;
+	u32 first;
+};
+
+struct fl_range_index {
+	struct rcu_head rcu;
+	bool dst;
+	unsigned int num_segs;
+	struct cls_fl_filter **filters;
+	struct fl_range_seg segs[]; /* num_segs + 1 */
+};
+
 struct fl_flow_mask {
 	struct fl_flow_key key;
 	struct fl_flow_mask_range range;
 	u32 flags;
+	struct fl_range_index __rcu *range_index;
+	struct mutex range_lock; /* serializes range index rebuilds */
 	struct rhash_head ht_node;
 	struct rhashtable ht;
 	struct rhashtable_params filter_ht_params;
@@ -85,6 +110,16 @@ struct fl_flow_mask {
 	refcount_t refcnt;
 };
 
+/* Union of the dissector keys and key ranges of all masks, so that
+ * fl_classify() dissects each packet only once. Replaced as a whole whenever
+ * a mask is added or removed.
+ */
+struct fl_masks_union {
+	struct flow_dissector dissector;
+	struct fl_flow_mask_range range;
+	struct rcu_head rcu;
+};
+
 struct fl_flow_tmplt {
 	struct fl_flow_key dummy_key;
 	struct fl_flow_key mask;
@@ -96,6 +131,7 @@ struct cls_fl_head {
 	struct rhashtable ht;
 	spinlock_t masks_lock; /* Protect masks list */
 	struct list_head masks;
+	struct fl_masks_union __rcu *masks_union;
 	struct list_head hw_filters;
 	struct rcu_work rwork;
 	struct idr handle_idr;
@@ -193,10 +229,10 @@ static bool fl_mask_fits_tmplt(struct fl_flow_tmplt *tmplt,
 	return true;
 }
 
-static void fl_clear_masked_range(struct fl_flow_key *key,
-				  struct fl_flow_mask *mask)
+static void fl_clear_range(struct fl_flow_key *key,
+			   const struct fl_flow_mask_range *range)
 {
-	memset(fl_key_get_start(key, mask), 0, fl_mask_range(mask));
+	memset((u8 *) key + range->start, 0, range->end - range->start);
 }
 
 static bool fl_range_port_dst_cmp(struct cls_fl_filter *filter,
@@ -252,20 +288,57 @@ static struct cls_fl_filter *__fl_lookup(struct fl_flow_mask *mask,
 				      mask->filter_ht_params);
 }
 
+static struct cls_fl_filter *fl_lookup_range_filter(struct fl_flow_mask *mask,
+						    struct cls_fl_filter *filter,
+						    struct fl_flow_key *mkey,
+						    struct fl_flow_key *key)
+{
+	if (!fl_range_port_dst_cmp(filter, key, mkey))
+		return NULL;
+
+	if (!fl_range_port_src_cmp(filter, key, mkey))
+		return NULL;
+
+	return __fl_lookup(mask, mkey);
+}
+
 static struct cls_fl_filter *fl_lookup_range(struct fl_flow_mask *mask,
 					     struct fl_flow_key *mkey,
 					     struct fl_flow_key *key)
 {
+	struct fl_range_index *index = rcu_dereference_bh(mask->range_index);
 	struct cls_fl_filter *filter, *f;
+	unsigned int lo, hi, mid, i;
+	u32 port;
+
+	/* No filters, or the index could not be allocated */
+	if (!index) {
+		list_for_each_entry_rcu(filter, &mask->filters, list) {
+			f = fl_lookup_range_filter(mask, filter, mkey, key);
+			if (f)
+				return f;
+		}
+		return NULL;
+	}
 
-	list_for_each_entry_rcu(filter, &mask->filters, list) {
-		if (!fl_range_port_dst_cmp(filter, key, mkey))
-			continue;
+	port = index->dst ? ntohs(key->tp_range.tp.dst) :
+			    ntohs(key->tp_range.tp.src);
 
-		if (!fl_range_port_src_cmp(filter, key, mkey))
-			continue;
+	lo = 0;
+	hi = index->num_segs;
+	if (port < index->segs[lo].start || port >= index->segs[hi].start)
+		return NULL;
+
+	while (hi - lo > 1) {
+		mid = lo + (hi - lo) / 2;
+		if (index->segs[mid].start <= port)
+			lo = mid;
+		else
+			hi = mid;
+	}
 
-		f = __fl_lookup(mask, mkey);
+	for (i = index->segs[lo].first; i < index->segs[lo + 1].first; i++) {
+		f = fl_lookup_range_filter(mask, index->filters[i], mkey, key);
 		if (f)
 			return f;
 	}
@@ -295,6 +368,15 @@ static u16 fl_ct_info_to_flower_map[] = {
 					TCA_FLOWER_KEY_CT_FLAGS_NEW,
 };
 
+/* Whether the packet key dissected with @mu holds everything @mask needs */
+static bool fl_masks_union_covers(const struct fl_masks_union *mu,
+				  const struct fl_flow_mask *mask)
+{
+	return !(mask->dissector.used_keys & ~mu->dissector.used_keys) &&
+	       mask->range.start >= mu->range.start &&
+	       mask->range.end <= mu->range.end;
+}
+
 static int fl_classify(struct sk_buff *skb, const struct tcf_proto *tp,
 		       struct tcf_result *res)
 {
@@ -302,21 +384,37 @@ static int fl_classify(struct sk_buff *skb, const struct tcf_proto *tp,
 	struct fl_flow_key skb_mkey;
 	struct fl_flow_key skb_key;
 	struct fl_flow_mask *mask;
+	struct fl_masks_union *mu;
 	struct cls_fl_filter *f;
 
-	list_for_each_entry_rcu(mask, &head->masks, list) {
-		fl_clear_masked_range(&skb_key, mask);
+	mu = rcu_dereference_bh(head->masks_union);
+	if (!mu)
+		return -1;
 
-		skb_flow_dissect_meta(skb, &mask->dissector, &skb_key);
-		/* skb_flow_dissect() does not set n_proto in case an unknown
-		 * protocol, so do it rather here.
-		 */
-		skb_key.basic.n_proto = skb->protocol;
-		skb_flow_dissect_tunnel_info(skb, &mask->dissector, &skb_key);
-		skb_flow_dissect_ct(skb, &mask->dissector, &skb_key,
-				    fl_ct_info_to_flower_map,
-				    ARRAY_SIZE(fl_ct_info_to_flower_map));
-		skb_flow_dissect(skb, &mask->dissector, &skb_key, 0);
+	fl_clear_range(&skb_key, &mu->range);
+
+	skb_flow_dissect_meta(skb, &mu->dissector, &skb_key);
+	/* skb_flow_dissect() does not set n_proto in case an unknown
+	 * protocol, so do it rather here.
+	 */
+	skb_key.basic.n_proto = skb->protocol;
+	skb_flow_dissect_tunnel_info(skb, &mu->dissector, &skb_key);
+	skb_flow_dissect_ct(skb, &mu->dissector, &skb_key,
+			    fl_ct_info_to_flower_map,
+			    ARRAY_SIZE(fl_ct_info_to_flower_map));
+	skb_flow_dissect(skb, &mu->dissector, &skb_key, 0);
+
+	/* The flow dissector fills only one of the port keys, preferring
+	 * the exact match one, so range masks need their copy made here.
+	 */
+	if (dissector_uses_key(&mu->dissector, FLOW_DISSECTOR_KEY_PORTS) &&
+	    dissector_uses_key(&mu->dissector, FLOW_DISSECTOR_KEY_PORTS_RANGE))
+		skb_key.tp_range.tp = skb_key.tp;
+
+	list_for_each_entry_rcu(mask, &head->masks, list) {
+		/* Published after @mu was fetched, treat it as not there yet */
+		if (unlikely(!fl_masks_union_covers(mu, mask)))
+			continue;
 
 		fl_set_masked_key(&skb_mkey, &skb_key, mask);
 
@@ -352,6 +450,7 @@ static void fl_mask_free(struct fl_flow_mask *mask, bool mask_init_done)
 	if (mask_init_done) {
 		WARN_ON(!list_empty(&mask->filters));
 		rhashtable_destroy(&mask->ht);
+		kvfree(rcu_dereference_raw(mask->range_index));
 	}
 	kfree(mask);
 }
@@ -372,15 +471,248 @@ static void fl_uninit_mask_free_work(struct work_struct *work)
 	fl_mask_free(mask, false);
 }
 
+static void fl_masks_union_add(struct fl_masks_union *mu,
+			       const struct fl_flow_mask *mask)
+{
+	const struct flow_dissector *dissector = &mask->dissector;
+	int id;
+
+	/* All masks dissect into struct fl_flow_key, so their offsets agree */
+	for (id = 0; id < FLOW_DISSECTOR_KEY_MAX; id++)
+		if (dissector_uses_key(dissector, id))
+			mu->dissector.offset[id] = dissector->offset[id];
+
+	mu->dissector.used_keys |= dissector->used_keys;
+	mu->range.start = min(mu->range.start, mask->range.start);
+	mu->range.end = max(mu->range.end, mask->range.end);
+}
+
+/* Recomputes into @mu, and publishes, the union of the masks list plus
+ * @newmask when it is about to be added to it. If @mu could not be allocated
+ * when removing a mask, the old union stays, as it covers the remaining masks
+ * too. Must be called with masks_lock held.
+ */
+static void fl_masks_update_union(struct cls_fl_head *head,
+				  const struct fl_flow_mask *newmask,
+				  struct fl_masks_union *mu)
+{
+	const struct fl_flow_mask *mask;
+	struct fl_masks_union *old;
+
+	if (list_empty(&head->masks) && !newmask) {
+		kfree(mu);
+		mu = NULL;
+	} else if (mu) {
+		memset(mu, 0, sizeof(*mu));
+		mu->range.start = sizeof(struct fl_flow_key);
+
+		list_for_each_entry(mask, &head->masks, list)
+			fl_masks_union_add(mu, mask);
+		if (newmask)
+			fl_masks_union_add(mu, newmask);
+	} else {
+		return;
+	}
+
+	old = rcu_dereference_protected(head->masks_union,
+					lockdep_is_held(&head->masks_lock));
+	rcu_assign_pointer(head->masks_union, mu);
+	if (old)
+		kfree_rcu(old, rcu);
+}
+
+static void fl_range_index_get(const struct cls_fl_filter *f, bool dst,
+			       u32 *min, u32 *max)
+{
+	const struct fl_flow_key *key = &f->key;
+
+	if (dst) {
+		*min = ntohs(key->tp_range.tp_min.dst);
+		*max = ntohs(key->tp_range.tp_max.dst);
+	} else {
+		*min = ntohs(key->tp_range.tp_min.src);
+		*max = ntohs(key->tp_range.tp_max.src);
+	}
+}
+
+static int fl_range_bound_cmp(const void *a, const void *b)
+{
+	u32 x = *(const u32 *)a, y = *(const u32 *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static unsigned int fl_range_bound_find(const u32 *bounds, unsigned int num,
+					u32 val)
+{
+	const u32 *pos = bsearch(&val, bounds, num, sizeof(*bounds),
+				 fl_range_bound_cmp);
+
+	return pos - bounds;
+}
+
+/* Copy the mask's filters list, in order, into an array allocated outside
+ * of tp->lock. Sets *num to 0 if the list is empty or allocation fails.
+ */
+static struct cls_fl_filter **fl_range_index_snapshot(struct tcf_proto *tp,
+						      struct fl_flow_mask *mask,
+						      unsigned int *num)
+{
+	struct cls_fl_filter **filters = NULL;
+	unsigned int n, size = 0;
+	struct cls_fl_filter *f;
+
+	for (;;) {
+		n = 0;
+		spin_lock(&tp->lock);
+		list_for_each_entry(f, &mask->filters, list) {
+			if (n < size)
+				filters[n] = f;
+			n++;
+		}
+		spin_unlock(&tp->lock);
+		if (n <= size)
+			break;
+
+		/* Size the array, with some slack for concurrent inserts */
+		kvfree(filters);
+		size = n + n / 8 + 1;
+		filters = kvmalloc_array(size, sizeof(*filters), GFP_KERNEL);
+		if (!filters) {
+			n = 0;
+			break;
+		}
+	}
+
+	*num = n;
+	return filters;
+}
+
+/* Returns NULL if there are no filters or if there isn't enough memory, in
+ * which case fl_lookup_range() walks the filters list.
+ */
+static struct fl_range_index *
+fl_range_index_build(struct fl_flow_mask *mask, struct cls_fl_filter **filters,
+		     unsigned int num)
+{
+	bool dst = mask->key.tp_range.tp_min.dst &&
+		   mask->key.tp_range.tp_max.dst;
+	struct fl_range_index *index = NULL;
+	unsigned int num_bounds, total, i, j;
+	u32 min, max, *bounds, *segs;
+
+	if (!num)
+		return NULL;
+
+	/* The boundaries of all ranges, then the first and last + 1 segment
+	 * of every filter.
+	 */
+	bounds = kvmalloc_array(4 * num, sizeof(*bounds), GFP_KERNEL);
+	if (!bounds)
+		return NULL;
+	segs = bounds + 2 * num;
+
+	num_bounds = 0;
+	for (i = 0; i < num; i++) {
+		fl_range_index_get(filters[i], dst, &min, &max);
+		bounds[num_bounds++] = min;
+		bounds[num_bounds++] = max + 1;
+	}
+
+	sort(bounds, num_bounds, sizeof(*bounds), fl_range_bound_cmp, NULL);
+	for (i = 1, j = 0; i < num_bounds; i++)
+		if (bounds[i] != bounds[j])
+			bounds[++j] = bounds[i];
+	num_bounds = j + 1;
+
+	total = 0;
+	for (i = 0; i < num; i++) {
+		fl_range_index_get(filters[i], dst, &min, &max);
+		segs[2 * i] = fl_range_bound_find(bounds, num_bounds, min);
+		segs[2 * i + 1] = fl_range_bound_find(bounds, num_bounds,
+						      max + 1);
+		total += segs[2 * i + 1] - segs[2 * i];
+	}
+
+	index = kvzalloc(struct_size(index, segs, num_bounds) +
+			 total * sizeof(*index->filters), GFP_KERNEL);
+	if (!index)
+		goto out;
+
+	index->dst = dst;
+	index->num_segs = num_bounds - 1;
+	index->filters = (struct cls_fl_filter **)&index->segs[num_bounds];
+
+	for (i = 0; i < num_bounds; i++)
+		index->segs[i].start = bounds[i];
+
+	for (i = 0; i < 2 * num; i += 2)
+		for (j = segs[i]; j < segs[i + 1]; j++)
+			index->segs[j + 1].first++;
+
+	/* Turn the counts into offsets, and keep a cursor for every segment */
+	for (i = 0; i < index->num_segs; i++) {
+		index->segs[i + 1].first += index->segs[i].first;
+		bounds[i] = index->segs[i].first;
+	}
+
+	/* Walking the filters in list order keeps the candidates in order */
+	for (i = 0; i < num; i++)
+		for (j = segs[2 * i]; j < segs[2 * i + 1]; j++)
+			index->filters[bounds[j]++] = filters[i];
+out:
+	kvfree(bounds);
+	return index;
+}
+
+static void fl_range_index_free_rcu(struct rcu_head *head)
+{
+	kvfree(container_of(head, struct fl_range_index, rcu));
+}
+
+/* Called without tp->lock, after the filters list of a mask changed and
+ * before any filter removed from it is put: a filter stays alive as long
+ * as a rebuild that may have seen it holds range_lock, and the index
+ * published last always matches the list.
+ */
+static void fl_mask_update_range_index(struct tcf_proto *tp,
+				       struct fl_flow_mask *mask)
+{
+	struct fl_range_index *index, *old;
+	struct cls_fl_filter **filters;
+	unsigned int num;
+
+	if (!(mask->flags & TCA_FLOWER_MASK_FLAGS_RANGE))
+		return;
+
+	mutex_lock(&mask->range_lock);
+	filters = fl_range_index_snapshot(tp, mask, &num);
+	index = fl_range_index_build(mask, filters, num);
+	kvfree(filters);
+
+	old = rcu_dereference_protected(mask->range_index,
+					lockdep_is_held(&mask->range_lock));
+	rcu_assign_pointer(mask->range_index, index);
+	mutex_unlock(&mask->range_lock);
+	if (old)
+		call_rcu(&old->rcu, fl_range_index_free_rcu);
+}
+
 static bool fl_mask_put(struct cls_fl_head *head, struct fl_flow_mask *mask)
 {
+	struct fl_masks_union *mu;
+
 	if (!refcount_dec_and_test(&mask->refcnt))
 		return false;
 
 	rhashtable_remove_fast(&head->ht, &mask->ht_node, mask_ht_params);
 
+	/* Called under tp->lock */
+	mu = kmalloc(sizeof(*mu), GFP_ATOMIC | __GFP_NOWARN);
+
 	spin_lock(&head->masks_lock);
 	list_del_rcu(&mask->list);
+	fl_masks_update_union(head, NULL, mu);
 	spin_unlock(&head->masks_lock);
 
 	tcf_queue_work(&mask->rwork, fl_mask_free_work);
@@ -540,6 +872,7 @@ static int __fl_delete(struct tcf_proto *tp, struct cls_fl_filter *f,
 	list_del_rcu(&f->list);
 	spin_unlock(&tp->lock);
 
+	fl_mask_update_range_index(tp, f->mask);
 	*last = fl_mask_put(head, f->mask);
 	if (!tc_skip_hw(f->flags))
 		fl_hw_destroy_filter(tp, f, rtnl_held, extack);
@@ -556,6 +889,7 @@ static void fl_destroy_sleepable(struct work_struct *work)
 						rwork);
 
 	rhashtable_destroy(&head->ht);
+	kfree(rcu_dereference_raw(head->masks_union));
 	kfree(head);
 	module_put(THIS_MODULE);
 }
@@ -1560,6 +1894,7 @@ static struct fl_flow_mask *fl_create_new_mask(struct cls_fl_head *head,
 					       struct fl_flow_mask *mask)
 {
 	struct fl_flow_mask *newmask;
+	struct fl_masks_union *mu;
 	int err;
 
 	newmask = kzalloc(sizeof(*newmask), GFP_KERNEL);
@@ -1581,19 +1916,30 @@ static struct fl_flow_mask *fl_create_new_mask(struct cls_fl_head *head,
 	fl_init_dissector(&newmask->dissector, &newmask->key);
 
 	INIT_LIST_HEAD_RCU(&newmask->filters);
+	mutex_init(&newmask->range_lock);
+
+	mu = kmalloc(sizeof(*mu), GFP_KERNEL);
+	if (!mu) {
+		err = -ENOMEM;
+		goto errout_destroy;
+	}
 
 	refcount_set(&newmask->refcnt, 1);
 	err = rhashtable_replace_fast(&head->ht, &mask->ht_node,
 				      &newmask->ht_node, mask_ht_params);
 	if (err)
-		goto errout_destroy;
+		goto errout_union;
 
+	/* Readers skip the new mask until they see a union covering it */
 	spin_lock(&head->masks_lock);
+	fl_masks_update_union(head, newmask, mu);
 	list_add_tail_rcu(&newmask->list, &head->masks);
 	spin_unlock(&head->masks_lock);
 
 	return newmask;
 
+errout_union:
+	kfree(mu);
 errout_destroy:
 	rhashtable_destroy(&newmask->ht);
 errout_free:
@@ -1837,6 +2183,7 @@ static int fl_change(struct net *net, struct sk_buff *in_skb,
 
 		spin_unlock(&tp->lock);
 
+		fl_mask_update_range_index(tp, fnew->mask);
 		fl_mask_put(head, fold->mask);
 		if (!tc_skip_hw(fold->flags))
 			fl_hw_destroy_filter(tp, fold, rtnl_held, NULL);
@@ -1872,6 +2219,8 @@ static int fl_change(struct net *net, struct sk_buff *in_skb,
 		fnew->handle = handle;
 		list_add_tail_rcu(&fnew->list, &fnew->mask->filters);
 		spin_unlock(&tp->lock);
+
+		fl_mask_update_range_index(tp, fnew->mask);
 	}
 
 	*arg = fnew;
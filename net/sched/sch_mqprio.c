@@ -12,10 +12,18 @@
 #include <linux/errno.h>
 #include <linux/skbuff.h>
 #include <linux/module.h>
+#include <linux/math64.h>
+#include <linux/timer.h>
 #include <net/netlink.h>
 #include <net/pkt_sched.h>
 #include <net/sch_generic.h>
 #include <net/pkt_cls.h>
+#include <net/gen_stats.h>
+
+/* How often the per-TC counters are refreshed for the rate estimators. This
+ * is the shortest estimator interval.
+ */
+#define MQPRIO_STATS_INTERVAL	(HZ / 4)
 
 struct mqprio_sched {
 	struct Qdisc		**qdiscs;
@@ -25,13 +33,123 @@ struct mqprio_sched {
 	u32 flags;
 	u64 min_rate[TC_QOPT_MAX_QUEUE];
 	u64 max_rate[TC_QOPT_MAX_QUEUE];
+
+	/* Per-TC counters, summed from the child qdiscs by stats_timer, on
+	 * which the per-TC rate estimators run.
+	 */
+	struct net_device *dev;
+	struct timer_list stats_timer;
+	spinlock_t tc_stats_lock;
+	struct gnet_stats_basic_packed tc_bstats[TC_QOPT_MAX_QUEUE];
+	struct net_rate_estimator __rcu *tc_rate_est[TC_QOPT_MAX_QUEUE];
+	struct tc_estimator tc_est;
 };
 
+/* Adds the counters of one child qdisc to those of its traffic class */
+static void mqprio_stats_add(struct Qdisc *qdisc,
+			     struct gnet_stats_basic_packed *bstats,
+			     struct gnet_stats_queue *qstats, __u32 *qlen)
+{
+	if (qdisc_is_percpu_stats(qdisc)) {
+		__u32 len = qdisc_qlen_sum(qdisc);
+
+		__gnet_stats_copy_basic(NULL, bstats, qdisc->cpu_bstats,
+					&qdisc->bstats);
+		__gnet_stats_copy_queue(qstats, qdisc->cpu_qstats,
+					&qdisc->qstats, len);
+		*qlen += len;
+	} else {
+		*qlen			+= qdisc->q.qlen;
+		bstats->bytes		+= qdisc->bstats.bytes;
+		bstats->packets		+= qdisc->bstats.packets;
+		qstats->backlog		+= qdisc->qstats.backlog;
+		qstats->drops		+= qdisc->qstats.drops;
+		qstats->requeues	+= qdisc->qstats.requeues;
+		qstats->overlimits	+= qdisc->qstats.overlimits;
+	}
+}
+
+static void mqprio_stats_timer(struct timer_list *t)
+{
+	struct mqprio_sched *priv = from_timer(priv, t, stats_timer);
+	struct net_device *dev = priv->dev;
+	int tc, i;
+
+	rcu_read_lock();
+
+	for (tc = 0; tc < netdev_get_num_tc(dev); tc++) {
+		struct netdev_tc_txq txq = dev->tc_to_txq[tc];
+		struct gnet_stats_basic_packed bstats = {0};
+		struct gnet_stats_queue qstats = {0};
+		__u32 qlen = 0;
+
+		for (i = txq.offset; i < txq.offset + txq.count; i++) {
+			struct Qdisc *qdisc;
+
+			qdisc = READ_ONCE(netdev_get_tx_queue(dev, i)->qdisc_sleeping);
+
+			spin_lock(qdisc_lock(qdisc));
+			mqprio_stats_add(qdisc, &bstats, &qstats, &qlen);
+			spin_unlock(qdisc_lock(qdisc));
+		}
+
+		spin_lock(&priv->tc_stats_lock);
+		priv->tc_bstats[tc] = bstats;
+		spin_unlock(&priv->tc_stats_lock);
+	}
+
+	rcu_read_unlock();
+
+	mod_timer(&priv->stats_timer, jiffies + MQPRIO_STATS_INTERVAL);
+}
+
+/* Without offload, the maximum rate of a TC is split evenly among its TX
+ * queues and enforced by their rate limiters, the same ones as behind
+ * /sys/class/net/<dev>/queues/tx-<n>/tx_maxrate. A minimum rate would need
+ * a scheduler across the queues, which only the hardware has.
+ */
+static int mqprio_set_tx_maxrate(struct net_device *dev,
+				 struct mqprio_sched *priv, bool enable)
+{
+	const struct net_device_ops *ops = dev->netdev_ops;
+	int tc, i, err;
+
+	for (tc = 0; tc < netdev_get_num_tc(dev); tc++) {
+		struct netdev_tc_txq txq = dev->tc_to_txq[tc];
+		u64 rate = 0;
+
+		if (!priv->max_rate[tc])
+			continue;
+
+		/* Bytes per second for the TC, to Mbps per queue */
+		if (enable) {
+			rate = div64_u64(priv->max_rate[tc] * 8,
+					 (u64)txq.count * 1000000);
+			rate = clamp_t(u64, rate, 1, U32_MAX);
+		}
+
+		for (i = txq.offset; i < txq.offset + txq.count; i++) {
+			err = ops->ndo_set_tx_maxrate(dev, i, rate);
+			if (err)
+				return err;
+
+			netdev_get_tx_queue(dev, i)->tx_maxrate = rate;
+		}
+	}
+
+	return 0;
+}
+
 static void mqprio_destroy(struct Qdisc *sch)
 {
 	struct net_device *dev = qdisc_dev(sch);
 	struct mqprio_sched *priv = qdisc_priv(sch);
 	unsigned int ntx;
+	int tc;
+
+	del_timer_sync(&priv->stats_timer);
+	for (tc = 0; tc < TC_QOPT_MAX_QUEUE; tc++)
+		gen_kill_estimator(&priv->tc_rate_est[tc]);
 
 	if (priv->qdiscs) {
 		for (ntx = 0;
@@ -55,6 +173,8 @@ static void mqprio_destroy(struct Qdisc *sch)
 			return;
 		}
 	} else {
+		if (priv->flags & TC_MQPRIO_F_MAX_RATE)
+			mqprio_set_tx_maxrate(dev, priv, false);
 		netdev_set_num_tc(dev, 0);
 	}
 }
@@ -114,6 +234,7 @@ static const struct nla_policy mqprio_policy[TCA_MQPRIO_MAX + 1] = {
 	[TCA_MQPRIO_SHAPER]	= { .len = sizeof(u16) },
 	[TCA_MQPRIO_MIN_RATE64]	= { .type = NLA_NESTED },
 	[TCA_MQPRIO_MAX_RATE64]	= { .type = NLA_NESTED },
+	[TCA_MQPRIO_TC_ESTIMATOR] = { .len = sizeof(struct tc_estimator) },
 };
 
 static int parse_attr(struct nlattr *tb[], int maxtype, struct nlattr *nla,
@@ -140,6 +261,7 @@ static int mqprio_init(struct Qdisc *sch, struct nlattr *opt,
 	int i, err = -EOPNOTSUPP;
 	struct tc_mqprio_qopt *qopt = NULL;
 	struct nlattr *tb[TCA_MQPRIO_MAX + 1];
+	struct nlattr *est = NULL;
 	struct nlattr *attr;
 	int rem;
 	int len;
@@ -147,6 +269,11 @@ static int mqprio_init(struct Qdisc *sch, struct nlattr *opt,
 	BUILD_BUG_ON(TC_MAX_QUEUE != TC_QOPT_MAX_QUEUE);
 	BUILD_BUG_ON(TC_BITMASK != TC_QOPT_BITMASK);
 
+	/* mqprio_destroy() runs on failure too */
+	priv->dev = dev;
+	spin_lock_init(&priv->tc_stats_lock);
+	timer_setup(&priv->stats_timer, mqprio_stats_timer, 0);
+
 	if (sch->parent != TC_H_ROOT)
 		return -EOPNOTSUPP;
 
@@ -171,8 +298,7 @@ static int mqprio_init(struct Qdisc *sch, struct nlattr *opt,
 		if (err < 0)
 			return err;
 
-		if (!qopt->hw)
-			return -EINVAL;
+		est = tb[TCA_MQPRIO_TC_ESTIMATOR];
 
 		if (tb[TCA_MQPRIO_MODE]) {
 			priv->flags |= TC_MQPRIO_F_MODE;
@@ -215,6 +341,35 @@ static int mqprio_init(struct Qdisc *sch, struct nlattr *opt,
 			}
 			priv->flags |= TC_MQPRIO_F_MAX_RATE;
 		}
+
+		if ((priv->flags & TC_MQPRIO_F_MIN_RATE) &&
+		    (priv->flags & TC_MQPRIO_F_MAX_RATE)) {
+			for (i = 0; i < qopt->num_tc; i++) {
+				if (priv->max_rate[i] &&
+				    priv->min_rate[i] > priv->max_rate[i]) {
+					NL_SET_ERR_MSG(extack,
+						       "Minimum rate of a TC exceeds its maximum rate");
+					return -EINVAL;
+				}
+			}
+		}
+
+		/* Without offload, only maximum rates can be honoured */
+		if (!qopt->hw &&
+		    (priv->flags & (TC_MQPRIO_F_MODE | TC_MQPRIO_F_SHAPER |
+				    TC_MQPRIO_F_MIN_RATE |
+				    TC_MQPRIO_F_MAX_RATE)) &&
+		    (priv->mode != TC_MQPRIO_MODE_CHANNEL ||
+		     priv->shaper != TC_MQPRIO_SHAPER_BW_RATE ||
+		     (priv->flags & TC_MQPRIO_F_MIN_RATE)))
+			return -EINVAL;
+
+		if (!qopt->hw && (priv->flags & TC_MQPRIO_F_MAX_RATE) &&
+		    !dev->netdev_ops->ndo_set_tx_maxrate) {
+			NL_SET_ERR_MSG(extack,
+				       "Device can't rate limit its TX queues");
+			return -EOPNOTSUPP;
+		}
 	}
 
 	/* pre-allocate qdisc, attachment can't fail */
@@ -276,6 +431,28 @@ static int mqprio_init(struct Qdisc *sch, struct nlattr *opt,
 		for (i = 0; i < qopt->num_tc; i++)
 			netdev_set_tc_queue(dev, i,
 					    qopt->count[i], qopt->offset[i]);
+
+		if (priv->flags & TC_MQPRIO_F_MAX_RATE) {
+			err = mqprio_set_tx_maxrate(dev, priv, true);
+			if (err) {
+				NL_SET_ERR_MSG(extack,
+					       "Failed to set the TX queue rate limits");
+				return err;
+			}
+		}
+	}
+
+	if (est) {
+		for (i = 0; i < netdev_get_num_tc(dev); i++) {
+			err = gen_new_estimator(&priv->tc_bstats[i], NULL,
+						&priv->tc_rate_est[i],
+						&priv->tc_stats_lock, NULL,
+						est);
+			if (err)
+				return err;
+		}
+		memcpy(&priv->tc_est, nla_data(est), sizeof(priv->tc_est));
+		mod_timer(&priv->stats_timer, jiffies);
 	}
 
 	/* Always use supplied priority mappings */
@@ -401,27 +578,8 @@ static int mqprio_dump(struct Qdisc *sch, struct sk_buff *skb)
 	for (ntx = 0; ntx < dev->num_tx_queues; ntx++) {
 		qdisc = netdev_get_tx_queue(dev, ntx)->qdisc_sleeping;
 		spin_lock_bh(qdisc_lock(qdisc));
-
-		if (qdisc_is_percpu_stats(qdisc)) {
-			__u32 qlen = qdisc_qlen_sum(qdisc);
-
-			__gnet_stats_copy_basic(NULL, &sch->bstats,
-						qdisc->cpu_bstats,
-						&qdisc->bstats);
-			__gnet_stats_copy_queue(&sch->qstats,
-						qdisc->cpu_qstats,
-						&qdisc->qstats, qlen);
-			sch->q.qlen		+= qlen;
-		} else {
-			sch->q.qlen		+= qdisc->q.qlen;
-			sch->bstats.bytes	+= qdisc->bstats.bytes;
-			sch->bstats.packets	+= qdisc->bstats.packets;
-			sch->qstats.backlog	+= qdisc->qstats.backlog;
-			sch->qstats.drops	+= qdisc->qstats.drops;
-			sch->qstats.requeues	+= qdisc->qstats.requeues;
-			sch->qstats.overlimits	+= qdisc->qstats.overlimits;
-		}
-
+		mqprio_stats_add(qdisc, &sch->bstats, &sch->qstats,
+				 &sch->q.qlen);
 		spin_unlock_bh(qdisc_lock(qdisc));
 	}
 
@@ -450,6 +608,11 @@ static int mqprio_dump(struct Qdisc *sch, struct sk_buff *skb)
 	    (dump_rates(priv, &opt, skb) != 0))
 		goto nla_put_failure;
 
+	if (gen_estimator_active(&priv->tc_rate_est[0]) &&
+	    nla_put(skb, TCA_MQPRIO_TC_ESTIMATOR, sizeof(priv->tc_est),
+		    &priv->tc_est))
+		goto nla_put_failure;
+
 	return nla_nest_end(skb, nla);
 nla_put_failure:
 	nlmsg_trim(skb, nla);
@@ -515,6 +678,7 @@ static int mqprio_dump_class_stats(struct Qdisc *sch, unsigned long cl,
 		__u32 qlen = 0;
 		struct gnet_stats_queue qstats = {0};
 		struct gnet_stats_basic_packed bstats = {0};
+		struct mqprio_sched *priv = qdisc_priv(sch);
 		struct net_device *dev = qdisc_dev(sch);
 		struct netdev_tc_txq tc = dev->tc_to_txq[cl & TC_BITMASK];
 
@@ -529,22 +693,9 @@ static int mqprio_dump_class_stats(struct Qdisc *sch, unsigned long cl,
 		for (i = tc.offset; i < tc.offset + tc.count; i++) {
 			struct netdev_queue *q = netdev_get_tx_queue(dev, i);
 			struct Qdisc *qdisc = rtnl_dereference(q->qdisc);
-			struct gnet_stats_basic_cpu __percpu *cpu_bstats = NULL;
-			struct gnet_stats_queue __percpu *cpu_qstats = NULL;
 
 			spin_lock_bh(qdisc_lock(qdisc));
-			if (qdisc_is_percpu_stats(qdisc)) {
-				cpu_bstats = qdisc->cpu_bstats;
-				cpu_qstats = qdisc->cpu_qstats;
-			}
-
-			qlen = qdisc_qlen_sum(qdisc);
-			__gnet_stats_copy_basic(NULL, &sch->bstats,
-						cpu_bstats, &qdisc->bstats);
-			__gnet_stats_copy_queue(&sch->qstats,
-						cpu_qstats,
-						&qdisc->qstats,
-						qlen);
+			mqprio_stats_add(qdisc, &bstats, &qstats, &qlen);
 			spin_unlock_bh(qdisc_lock(qdisc));
 		}
 
@@ -552,6 +703,8 @@ static int mqprio_dump_class_stats(struct Qdisc *sch, unsigned long cl,
 		if (d->lock)
 			spin_lock_bh(d->lock);
 		if (gnet_stats_copy_basic(NULL, d, NULL, &bstats) < 0 ||
+		    gnet_stats_copy_rate_est(d,
+					     &priv->tc_rate_est[cl & TC_BITMASK]) < 0 ||
 		    gnet_stats_copy_queue(d, NULL, &qstats, qlen) < 0)
 			return -1;
 	} else {
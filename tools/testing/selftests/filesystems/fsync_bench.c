@@ -0,0 +1,189 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * fsync latency benchmark.
+ *
+ * Each of JOBS processes appends SIZE bytes to its own file in DIR and
+ * fsync()s it, ITERATIONS times, and the latency of every fsync() is
+ * recorded. With -m, one more process keeps creating and removing files
+ * in DIR meanwhile, so that the journal always has metadata of other
+ * inodes to commit.
+ *
+ * To see what ext4 fast commits gain, run it on filesystems made with
+ * and without "mke2fs -O fast_commit".
+ *
+ * Usage: fsync_bench [-n ITERATIONS] [-s SIZE] [-j JOBS] [-m] DIR
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include "../kselftest.h"
+
+static int iterations = 1000;
+static size_t size = 4096;
+static int jobs = 1;
+static int metadata;
+static const char *dir;
+
+static unsigned long long now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int cmp_ull(const void *a, const void *b)
+{
+	unsigned long long x = *(const unsigned long long *)a;
+	unsigned long long y = *(const unsigned long long *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static void run_job(int job, unsigned long long *lat)
+{
+	char path[4096], *buf;
+	int fd, i;
+
+	snprintf(path, sizeof(path), "%s/fsync_bench.%d", dir, job);
+	fd = open(path, O_CREAT | O_TRUNC | O_WRONLY, 0644);
+	if (fd < 0)
+		ksft_exit_fail_msg("open %s: %s\n", path, strerror(errno));
+
+	buf = malloc(size);
+	if (!buf)
+		ksft_exit_fail_msg("malloc: %s\n", strerror(errno));
+	memset(buf, job, size);
+
+	/* Get the inode itself created and committed first */
+	if (fsync(fd))
+		ksft_exit_fail_msg("fsync: %s\n", strerror(errno));
+
+	for (i = 0; i < iterations; i++) {
+		unsigned long long start;
+
+		if (write(fd, buf, size) != (ssize_t)size)
+			ksft_exit_fail_msg("write: %s\n", strerror(errno));
+		start = now_ns();
+		if (fsync(fd))
+			ksft_exit_fail_msg("fsync: %s\n", strerror(errno));
+		lat[i] = now_ns() - start;
+	}
+
+	close(fd);
+	unlink(path);
+	free(buf);
+	exit(0);
+}
+
+static void run_metadata(void)
+{
+	char path[4096];
+	unsigned long n;
+	int fd;
+
+	for (n = 0; ; n++) {
+		snprintf(path, sizeof(path), "%s/fsync_bench.meta.%lu",
+			 dir, n % 64);
+		fd = open(path, O_CREAT | O_WRONLY, 0644);
+		if (fd >= 0)
+			close(fd);
+		unlink(path);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long long *lat, total = 0, elapsed;
+	pid_t meta = 0;
+	size_t n, i;
+	int opt, j;
+
+	while ((opt = getopt(argc, argv, "n:s:j:m")) != -1) {
+		switch (opt) {
+		case 'n':
+			iterations = atoi(optarg);
+			break;
+		case 's':
+			size = strtoul(optarg, NULL, 0);
+			break;
+		case 'j':
+			jobs = atoi(optarg);
+			break;
+		case 'm':
+			metadata = 1;
+			break;
+		default:
+			goto usage;
+		}
+	}
+	if (optind != argc - 1 || iterations <= 0 || jobs <= 0 || !size)
+		goto usage;
+	dir = argv[optind];
+
+	n = (size_t)iterations * jobs;
+	lat = mmap(NULL, n * sizeof(*lat), PROT_READ | PROT_WRITE,
+		   MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (lat == MAP_FAILED)
+		ksft_exit_fail_msg("mmap: %s\n", strerror(errno));
+
+	if (metadata) {
+		meta = fork();
+		if (meta < 0)
+			ksft_exit_fail_msg("fork: %s\n", strerror(errno));
+		if (!meta)
+			run_metadata();
+	}
+
+	elapsed = now_ns();
+	for (j = 0; j < jobs; j++) {
+		pid_t pid = fork();
+
+		if (pid < 0)
+			ksft_exit_fail_msg("fork: %s\n", strerror(errno));
+		if (!pid)
+			run_job(j, lat + (size_t)j * iterations);
+	}
+	for (j = 0; j < jobs; j++) {
+		int status;
+
+		if (wait(&status) < 0 || !WIFEXITED(status) ||
+		    WEXITSTATUS(status))
+			ksft_exit_fail_msg("job failed\n");
+	}
+	elapsed = now_ns() - elapsed;
+
+	if (meta) {
+		kill(meta, SIGKILL);
+		waitpid(meta, NULL, 0);
+	}
+
+	for (i = 0; i < n; i++)
+		total += lat[i];
+	qsort(lat, n, sizeof(*lat), cmp_ull);
+
+	printf("%zu fsyncs of %zu byte appends, %d jobs%s\n", n, size, jobs,
+	       metadata ? ", concurrent metadata updates" : "");
+	printf("fsyncs/s: %llu\n", n * 1000000000ULL / elapsed);
+	printf("latency us: avg %llu p50 %llu p99 %llu max %llu\n",
+	       total / n / 1000, lat[n / 2] / 1000, lat[n * 99 / 100] / 1000,
+	       lat[n - 1] / 1000);
+
+	return 0;
+
+usage:
+	fprintf(stderr,
+		"Usage: %s [-n ITERATIONS] [-s SIZE] [-j JOBS] [-m] DIR\n",
+		argv[0]);
+	return 1;
+}
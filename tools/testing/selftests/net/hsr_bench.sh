@@ -0,0 +1,95 @@
+#!/bin/bash
+# SPDX-License-Identifier: GPL-2.0
+#
+# Benchmark HSR frame reception with a large node table.
+#
+# Two HSR devices, in namespaces ns1 and ns2, form a ring over two veth
+# pairs. ns2 also carries NUM_NODES macvlan devices on its HSR device; one
+# ping from each makes hsr1 learn a node for every macvlan address. A
+# flood ping between the two HSR devices then measures the per-frame cost
+# of looking up the sending node.
+#
+# Usage: hsr_bench.sh [NUM_NODES [PACKETS]]
+
+# Kselftest framework requirement - SKIP code is 4.
+ksft_skip=4
+
+NUM_NODES=${1:-200}
+PACKETS=${2:-100000}
+
+ns1="hsr-bench-1-$$"
+ns2="hsr-bench-2-$$"
+
+cleanup()
+{
+	ip netns del "$ns1" 2>/dev/null
+	ip netns del "$ns2" 2>/dev/null
+}
+
+if [ "$(id -u)" -ne 0 ]; then
+	echo "SKIP: Need root privileges"
+	exit $ksft_skip
+fi
+
+if ! ip link help hsr 2>&1 | grep -q slave1; then
+	echo "SKIP: iproute2 too old, missing hsr support"
+	exit $ksft_skip
+fi
+
+trap cleanup EXIT
+
+ip netns add "$ns1" || exit 1
+ip netns add "$ns2" || exit 1
+
+ip link add veth0 netns "$ns1" type veth peer name veth0 netns "$ns2"
+ip link add veth1 netns "$ns1" type veth peer name veth1 netns "$ns2"
+
+for ns in "$ns1" "$ns2"; do
+	ip -net "$ns" link set veth0 up
+	ip -net "$ns" link set veth1 up
+done
+
+if ! ip -net "$ns1" link add name hsr1 type hsr slave1 veth0 slave2 veth1 \
+		supervision 45 version 1; then
+	echo "SKIP: no HSR support"
+	exit $ksft_skip
+fi
+ip -net "$ns2" link add name hsr2 type hsr slave1 veth0 slave2 veth1 \
+	supervision 45 version 1 || exit 1
+
+ip -net "$ns1" addr add 10.0.0.1/16 dev hsr1
+ip -net "$ns2" addr add 10.0.0.2/16 dev hsr2
+ip -net "$ns1" link set hsr1 up
+ip -net "$ns2" link set hsr2 up
+
+# Give the supervision frames time to merge the AddrB nodes
+sleep 2
+
+for i in $(seq 1 "$NUM_NODES"); do
+	ip -net "$ns2" link add link hsr2 name mv$i type macvlan mode private
+	ip -net "$ns2" addr add 10.0.$((i / 250 + 1)).$((i % 250 + 1))/16 \
+		dev mv$i
+	ip -net "$ns2" link set mv$i up
+done
+
+for i in $(seq 1 "$NUM_NODES"); do
+	ip netns exec "$ns2" ping -q -c 1 -W 1 -I mv$i 10.0.0.1 >/dev/null &
+done
+wait
+
+node_table=/sys/kernel/debug/hsr/hsr1/node_table
+if [ -r "$node_table" ]; then
+	echo "hsr1 node table: $(ip netns exec "$ns1" cat "$node_table" |
+		grep -c :) entries"
+fi
+
+echo "flood ping of $PACKETS packets with $NUM_NODES extra nodes:"
+start=$(date +%s%N)
+ip netns exec "$ns2" ping -q -f -c "$PACKETS" 10.0.0.1 || exit 1
+end=$(date +%s%N)
+
+elapsed_us=$(((end - start) / 1000))
+echo "$((PACKETS * 1000000 / elapsed_us)) packets/s," \
+     "$((elapsed_us * 1000 / PACKETS)) ns/packet"
+
+exit 0